@@ -0,0 +1,22 @@
+#include "ActiveTiles.h"
+
+void buildActiveTileList(const std::vector<uint8_t> &tileChanged, int tilesX, int tilesY,
+                         std::vector<int> &activeTiles) {
+    activeTiles.clear();
+
+    for (int tileY = 0; tileY < tilesY; tileY++) {
+        for (int tileX = 0; tileX < tilesX; tileX++) {
+            bool active = false;
+            for (int y = tileY - 1; y <= tileY + 1 && !active; y++) {
+                if (y < 0 || y >= tilesY) continue;
+                for (int x = tileX - 1; x <= tileX + 1; x++) {
+                    if (x >= 0 && x < tilesX && tileChanged[y * tilesX + x]) {
+                        active = true;
+                        break;
+                    }
+                }
+            }
+            if (active) activeTiles.push_back(tileY * tilesX + tileX);
+        }
+    }
+}
@@ -0,0 +1,27 @@
+#ifndef FINAL_PROJECT_ACTIVETILES_H
+#define FINAL_PROJECT_ACTIVETILES_H
+
+#include <cstdint>
+#include <vector>
+
+// The grid is split into tiles with one "changed last generation" flag each.
+// A tile can only change in the next generation if it or one of its 8
+// neighbouring tiles changed in the last one, so every other tile is skipped.
+// Skipped tiles are still correct in the ping-pong buffer: they hold the state
+// from two generations ago, which equals the state from one generation ago.
+constexpr int ACTIVE_TILE_WIDTH = 64;
+constexpr int ACTIVE_TILE_HEIGHT = 16;
+
+inline int activeTilesX(int width) {
+    return (width + ACTIVE_TILE_WIDTH - 1) / ACTIVE_TILE_WIDTH;
+}
+
+inline int activeTilesY(int height) {
+    return (height + ACTIVE_TILE_HEIGHT - 1) / ACTIVE_TILE_HEIGHT;
+}
+
+// Compact the indices of tiles that changed, or border a tile that changed, into activeTiles
+void buildActiveTileList(const std::vector<uint8_t> &tileChanged, int tilesX, int tilesY,
+                         std::vector<int> &activeTiles);
+
+#endif
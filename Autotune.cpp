@@ -0,0 +1,151 @@
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "Autotune.h"
+#include "Configs.h"
+
+namespace {
+    const char *CACHE_FILE = "gol_autotune.cache";
+    constexpr int WARMUP_LAUNCHES = 2;
+    constexpr int TIMED_LAUNCHES = 10;
+
+    std::string deviceString(cl_device_id device, cl_device_info param) {
+        char value[256] = {0};
+        clGetDeviceInfo(device, param, sizeof(value) - 1, value, NULL);
+        return value;
+    }
+
+    // One line per device, grid size, species count and kernel build:
+    // name \t driver \t WIDTHxHEIGHT \t species \t build options \t x y
+    std::string cacheKey(cl_device_id device, const std::string &buildOptions) {
+        std::ostringstream key;
+        key << deviceString(device, CL_DEVICE_NAME) << '\t'
+            << deviceString(device, CL_DRIVER_VERSION) << '\t'
+            << WIDTH << 'x' << HEIGHT << '\t'
+            << NUMBER_OF_SPECIES << '\t'
+            << (buildOptions.empty() ? "generic" : buildOptions);
+        return key.str();
+    }
+
+    bool readCachedShape(const std::string &key, WorkGroupShape &shape) {
+        std::ifstream cache(CACHE_FILE);
+        std::string line;
+        while (std::getline(cache, line)) {
+            size_t split = line.rfind('\t');
+            if (split == std::string::npos || line.compare(0, split, key) != 0) continue;
+            std::istringstream value(line.substr(split + 1));
+            if (value >> shape.x >> shape.y) return true;
+        }
+        return false;
+    }
+
+    void writeCachedShape(const std::string &key, WorkGroupShape shape) {
+        // Keep entries for other devices and grid sizes
+        std::vector<std::string> lines;
+        {
+            std::ifstream cache(CACHE_FILE);
+            std::string line;
+            while (std::getline(cache, line)) {
+                if (line.compare(0, key.size() + 1, key + '\t') != 0) lines.push_back(line);
+            }
+        }
+
+        std::ofstream cache(CACHE_FILE, std::ios::trunc);
+        for (const std::string &line : lines) cache << line << '\n';
+        cache << key << '\t' << shape.x << ' ' << shape.y << '\n';
+    }
+
+    // Average kernel time in microseconds for one shape, or a negative value if it can't run
+    double benchmarkShape(cl_command_queue queue, cl_kernel referenceKernel, cl_kernel tiledKernel,
+                          cl_mem current, cl_mem next, WorkGroupShape shape) {
+        bool tiled = shape.x != 0;
+        cl_kernel kernel = tiled ? tiledKernel : referenceKernel;
+
+        size_t global[2] = {static_cast<size_t>(WIDTH), static_cast<size_t>(HEIGHT)};
+        size_t local[2] = {shape.x, shape.y};
+        if (tiled) {
+            global[0] = (global[0] + shape.x - 1) / shape.x * shape.x;
+            global[1] = (global[1] + shape.y - 1) / shape.y * shape.y;
+            setTiledKernelArgs(tiledKernel, current, next, shape);
+        }
+        else {
+            clSetKernelArg(referenceKernel, 0, sizeof(cl_mem), &current);
+            clSetKernelArg(referenceKernel, 1, sizeof(cl_mem), &next);
+            clSetKernelArg(referenceKernel, 2, sizeof(int), &WIDTH);
+            clSetKernelArg(referenceKernel, 3, sizeof(int), &HEIGHT);
+            clSetKernelArg(referenceKernel, 4, sizeof(int), &NUMBER_OF_SPECIES);
+        }
+
+        double totalTime = 0;
+        for (int launch = 0; launch < WARMUP_LAUNCHES + TIMED_LAUNCHES; launch++) {
+            cl_event event;
+            cl_int err = clEnqueueNDRangeKernel(queue, kernel, 2, NULL, global, tiled ? local : NULL,
+                                                0, NULL, &event);
+            if (err != CL_SUCCESS) return -1;
+
+            clWaitForEvents(1, &event);
+            cl_ulong start, end;
+            clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, NULL);
+            clGetEventProfilingInfo(event, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, NULL);
+            clReleaseEvent(event);
+
+            if (launch >= WARMUP_LAUNCHES) totalTime += (double)(end - start) / 1000.0;
+        }
+        return totalTime / TIMED_LAUNCHES;
+    }
+}
+
+void setTiledKernelArgs(cl_kernel tiledKernel, cl_mem current, cl_mem next, WorkGroupShape shape) {
+    clSetKernelArg(tiledKernel, 0, sizeof(cl_mem), &current);
+    clSetKernelArg(tiledKernel, 1, sizeof(cl_mem), &next);
+    clSetKernelArg(tiledKernel, 2, sizeof(int), &WIDTH);
+    clSetKernelArg(tiledKernel, 3, sizeof(int), &HEIGHT);
+    clSetKernelArg(tiledKernel, 4, sizeof(int), &NUMBER_OF_SPECIES);
+    clSetKernelArg(tiledKernel, 5, sizeof(cl_char) * (shape.x + 2) * (shape.y + 2), NULL);
+}
+
+WorkGroupShape selectWorkGroupShape(cl_device_id device, cl_command_queue queue,
+                                    cl_kernel referenceKernel, cl_kernel tiledKernel,
+                                    cl_mem current, cl_mem next, const std::string &buildOptions, bool retune) {
+    std::string key = cacheKey(device, buildOptions);
+    WorkGroupShape best = {0, 0};
+
+    if (!retune && readCachedShape(key, best)) {
+        std::cout << "Using cached work-group size " << best.x << "x" << best.y << std::endl;
+        return best;
+    }
+
+    size_t maxWorkGroupSize = 0;
+    clGetKernelWorkGroupInfo(tiledKernel, device, CL_KERNEL_WORK_GROUP_SIZE,
+                             sizeof(size_t), &maxWorkGroupSize, NULL);
+
+    const WorkGroupShape candidates[] = {
+            {0, 0},
+            {8, 8}, {16, 4}, {16, 8}, {16, 16},
+            {32, 2}, {32, 4}, {32, 8}, {32, 16},
+            {64, 1}, {64, 2}, {64, 4}, {128, 1}, {128, 2}
+    };
+
+    std::cout << "Tuning work-group size:\n";
+    double bestTime = -1;
+    for (const WorkGroupShape &shape : candidates) {
+        if (shape.x * shape.y > maxWorkGroupSize) continue;
+
+        double time = benchmarkShape(queue, referenceKernel, tiledKernel, current, next, shape);
+        if (time < 0) continue;
+
+        if (shape.x == 0) std::cout << "\tuntiled:\t" << time << "us\n";
+        else std::cout << "\t" << shape.x << "x" << shape.y << ":\t\t" << time << "us\n";
+
+        if (bestTime < 0 || time < bestTime) {
+            bestTime = time;
+            best = shape;
+        }
+    }
+
+    writeCachedShape(key, best);
+    return best;
+}
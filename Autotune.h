@@ -0,0 +1,27 @@
+#ifndef FINAL_PROJECT_AUTOTUNE_H
+#define FINAL_PROJECT_AUTOTUNE_H
+
+#include <cstddef>
+#include <string>
+#include <OpenCL/opencl.h>
+
+// Local size for the grid update. {0, 0} means the untiled gameOfLife
+// kernel with the local size left to the driver.
+struct WorkGroupShape {
+    size_t x;
+    size_t y;
+};
+
+// Benchmark the tiled kernel with each candidate work-group shape (and the
+// untiled kernel) on the current grid and return the fastest. The winner is
+// remembered per device, grid size, species count and kernel build options in
+// a cache file, so later runs skip the benchmark unless retune is set. Reads
+// current and overwrites next.
+WorkGroupShape selectWorkGroupShape(cl_device_id device, cl_command_queue queue,
+                                    cl_kernel referenceKernel, cl_kernel tiledKernel,
+                                    cl_mem current, cl_mem next, const std::string &buildOptions, bool retune);
+
+// Set the arguments of the tiled kernel, including its local tile, for the given shape
+void setTiledKernelArgs(cl_kernel tiledKernel, cl_mem current, cl_mem next, WorkGroupShape shape);
+
+#endif
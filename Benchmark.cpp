@@ -0,0 +1,395 @@
+// Benchmark suite: sweeps grid size, species count, engine variant and
+// generations per launch, and reports cells/second, per-launch latency
+// percentiles and host<->device transfer bandwidth as JSON or CSV so runs
+// from different builds can be compared.
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Configs.h"
+#include "Engine.h"
+
+namespace {
+    struct Variant {
+        const char *name;
+        Engine engine;
+        bool simd;
+        bool bitboard;
+        bool tiled;
+        bool activeTiles;
+        bool padded;
+    };
+
+    const Variant VARIANTS[] = {
+            {"opencl",              ENGINE_OPENCL,       true,  false, false, false, false},
+            {"opencl-tiled",        ENGINE_OPENCL,       true,  false, true,  false, false},
+            {"opencl-bitboard",     ENGINE_OPENCL,       true,  true,  false, false, false},
+            {"opencl-active-tiles", ENGINE_OPENCL,       true,  false, false, true,  false},
+            {"opencl-padded",       ENGINE_OPENCL,       true,  false, false, false, true},
+            {"cpu",                 ENGINE_CPU,          true,  false, false, false, false},
+            {"cpu-scalar",          ENGINE_CPU,          false, false, false, false, false},
+            {"cpu-bitboard",        ENGINE_CPU,          true,  true,  false, false, false},
+            {"cpu-active-tiles",    ENGINE_CPU,          true,  false, false, true,  false},
+            {"cpu-padded",          ENGINE_CPU,          true,  false, false, false, true},
+            {"multi",               ENGINE_MULTI_DEVICE, true,  false, false, false, false},
+    };
+
+    struct GridSize {
+        int width;
+        int height;
+    };
+
+    struct Result {
+        std::string variant;
+        int width;
+        int height;
+        int species;
+        int generationsPerLaunch;
+        int generations;
+        double seconds;
+        double cellsPerSecond;
+        double p50LaunchUs;
+        double p99LaunchUs;
+        double uploadGBs;       // 0 when the engine works on the host grid
+        double downloadGBs;
+    };
+
+    struct Options {
+        std::vector<GridSize> sizes = {{512, 512}, {1024, 768}, {2048, 2048}};
+        std::vector<int> species = {5, 10};
+        std::vector<const Variant *> variants;
+        std::vector<int> generationsPerLaunch = {1, 8, 32};
+        int generations = 256;
+        int warmup = 16;
+        int transferRepeats = 5;
+        bool csv = false;
+        const char *outputPath = "benchmark.json";
+    };
+
+    // Split a comma-separated list
+    std::vector<std::string> splitList(const char *value) {
+        std::vector<std::string> items;
+        std::string item;
+        for (const char *c = value; ; c++) {
+            if (*c == ',' || *c == '\0') {
+                if (!item.empty()) items.push_back(item);
+                item.clear();
+                if (*c == '\0') break;
+            }
+            else {
+                item += *c;
+            }
+        }
+        return items;
+    }
+
+    bool parseIntList(const char *flag, const char *value, long min, long max, std::vector<int> &result) {
+        if (value == nullptr) {
+            printf("Error: %s expects a comma-separated list!\n", flag);
+            return false;
+        }
+        result.clear();
+        for (const std::string &item : splitList(value)) {
+            char *end = nullptr;
+            long parsed = std::strtol(item.c_str(), &end, 10);
+            if (*end != '\0' || parsed < min || parsed > max) {
+                printf("Error: %s expects integers in [%ld, %ld], got '%s'!\n", flag, min, max, item.c_str());
+                return false;
+            }
+            result.push_back(static_cast<int>(parsed));
+        }
+        return !result.empty();
+    }
+
+    bool parseSizes(const char *value, std::vector<GridSize> &sizes) {
+        if (value == nullptr) {
+            printf("Error: --sizes expects a list like 512x512,2048x2048!\n");
+            return false;
+        }
+        sizes.clear();
+        for (const std::string &item : splitList(value)) {
+            int width, height;
+            char trailing;
+            if (std::sscanf(item.c_str(), "%dx%d%c", &width, &height, &trailing) != 2 || width < 1 || height < 1 ||
+                static_cast<size_t>(width) * height * 3 > INT_MAX) {
+                printf("Error: Invalid grid size '%s'!\n", item.c_str());
+                return false;
+            }
+            sizes.push_back({width, height});
+        }
+        return !sizes.empty();
+    }
+
+    bool parseVariants(const char *value, std::vector<const Variant *> &variants) {
+        if (value == nullptr) {
+            printf("Error: --engines expects a comma-separated list!\n");
+            return false;
+        }
+        variants.clear();
+        for (const std::string &item : splitList(value)) {
+            const Variant *match = nullptr;
+            for (const Variant &variant : VARIANTS) {
+                if (item == variant.name) match = &variant;
+            }
+            if (match == nullptr) {
+                printf("Error: Unknown engine variant '%s'!\n", item.c_str());
+                return false;
+            }
+            variants.push_back(match);
+        }
+        return !variants.empty();
+    }
+
+    void printUsage(const char *programName) {
+        std::cout << "Usage: " << programName << " [options]\n"
+                  << "  --sizes WxH,...     Grid sizes (default: 512x512,1024x768,2048x2048)\n"
+                  << "  --species N,...     Species counts, 5-10 (default: 5,10)\n"
+                  << "  --engines NAME,...  Engine variants (default: all), one of:\n"
+                  << "                      ";
+        for (const Variant &variant : VARIANTS) std::cout << variant.name << " ";
+        std::cout << "\n"
+                  << "  --batches K,...     Generations per launch (default: 1,8,32)\n"
+                  << "  --generations N     Timed generations per configuration (default: 256)\n"
+                  << "  --warmup N          Untimed generations per configuration (default: 16)\n"
+                  << "  --seed N            Seed for the initial grids (default: 1)\n"
+                  << "  --threads N         CPU engine worker threads (default: all hardware threads)\n"
+                  << "  --csv               Write CSV instead of JSON\n"
+                  << "  --output PATH       Results file (default: benchmark.json, or .csv with --csv)\n"
+                  << "  --help              Show this message\n";
+    }
+
+    bool parseOptions(int argc, char **argv, Options &options) {
+        bool outputGiven = false;
+        for (int i = 1; i < argc; i++) {
+            const char *flag = argv[i];
+            const char *value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+            std::vector<int> single;
+
+            if (std::strcmp(flag, "--help") == 0 || std::strcmp(flag, "-h") == 0) {
+                printUsage(argv[0]);
+                return false;
+            }
+            else if (std::strcmp(flag, "--sizes") == 0) {
+                if (!parseSizes(value, options.sizes)) return false;
+                i++;
+            }
+            else if (std::strcmp(flag, "--species") == 0) {
+                if (!parseIntList(flag, value, 5, 10, options.species)) return false;
+                i++;
+            }
+            else if (std::strcmp(flag, "--engines") == 0) {
+                if (!parseVariants(value, options.variants)) return false;
+                i++;
+            }
+            else if (std::strcmp(flag, "--batches") == 0) {
+                if (!parseIntList(flag, value, 1, 1 << 16, options.generationsPerLaunch)) return false;
+                i++;
+            }
+            else if (std::strcmp(flag, "--generations") == 0) {
+                if (!parseIntList(flag, value, 1, INT_MAX, single) || single.size() != 1) return false;
+                options.generations = single[0];
+                i++;
+            }
+            else if (std::strcmp(flag, "--warmup") == 0) {
+                if (!parseIntList(flag, value, 0, INT_MAX, single) || single.size() != 1) return false;
+                options.warmup = single[0];
+                i++;
+            }
+            else if (std::strcmp(flag, "--seed") == 0) {
+                if (!parseIntList(flag, value, 0, INT_MAX, single) || single.size() != 1) return false;
+                SEED = static_cast<unsigned int>(single[0]);
+                i++;
+            }
+            else if (std::strcmp(flag, "--threads") == 0) {
+                if (!parseIntList(flag, value, 0, 1024, single) || single.size() != 1) return false;
+                THREADS = static_cast<unsigned int>(single[0]);
+                i++;
+            }
+            else if (std::strcmp(flag, "--csv") == 0) {
+                options.csv = true;
+            }
+            else if (std::strcmp(flag, "--output") == 0) {
+                if (value == nullptr) {
+                    printf("Error: --output expects a path!\n");
+                    return false;
+                }
+                options.outputPath = value;
+                outputGiven = true;
+                i++;
+            }
+            else {
+                printf("Error: Unknown option '%s'!\n", flag);
+                printUsage(argv[0]);
+                return false;
+            }
+        }
+
+        if (options.variants.empty()) {
+            for (const Variant &variant : VARIANTS) options.variants.push_back(&variant);
+        }
+        if (options.csv && !outputGiven) options.outputPath = "benchmark.csv";
+        return true;
+    }
+
+    // Nearest-rank percentile of an unsorted sample
+    double percentile(std::vector<double> samples, double fraction) {
+        std::sort(samples.begin(), samples.end());
+        size_t rank = static_cast<size_t>(fraction * samples.size() + 0.999999);
+        return samples[std::min(samples.size(), std::max<size_t>(rank, 1)) - 1];
+    }
+
+    // Median bandwidth of repeated transfers in GB/s, 0 for engines without a device copy
+    double measureTransfer(uint (*transfer)(), int repeats) {
+        if (ENGINE == ENGINE_CPU) return 0;
+
+        std::vector<double> seconds;
+        for (int i = 0; i < repeats; i++) {
+            auto start = std::chrono::steady_clock::now();
+            if (!transfer()) return 0;
+            seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        }
+        double bytes = static_cast<double>(sizeof(cell_t)) * WIDTH * HEIGHT;
+        return bytes / percentile(seconds, 0.5) / 1e9;
+    }
+
+    bool runConfiguration(const Variant &variant, const Options &options, int generationsPerLaunch, Result &result) {
+        ENGINE = variant.engine;
+        SIMD = variant.simd;
+        BITBOARD = variant.bitboard;
+        TILED = variant.tiled;
+        ACTIVE_TILES = variant.activeTiles;
+        PADDED = variant.padded;
+
+        initialiseEngine();
+        bool ok = ENGINE == variant.engine;
+        if (!ok) {
+            std::cout << "Skipping " << variant.name << ", the engine is unavailable\n";
+        }
+
+        if (ok) {
+            // Transfers are measured with the seeded grid
+            ok = initialiseGrid() && readGridToHost();
+        }
+        if (ok) {
+            tuneEngine();
+            result.uploadGBs = measureTransfer(uploadGridToDevice, options.transferRepeats);
+
+            for (int generation = 0; generation < options.warmup; generation += generationsPerLaunch) {
+                ok = ok && stepGenerations(std::min(generationsPerLaunch, options.warmup - generation));
+            }
+
+            // Every launch runs generationsPerLaunch generations and waits for them
+            int launches = std::max(1, options.generations / generationsPerLaunch);
+            std::vector<double> launchUs;
+            auto start = std::chrono::steady_clock::now();
+            for (int launch = 0; launch < launches && ok; launch++) {
+                auto launchStart = std::chrono::steady_clock::now();
+                ok = stepGenerations(generationsPerLaunch) != 0;
+                auto launchEnd = std::chrono::steady_clock::now();
+                launchUs.push_back(std::chrono::duration<double, std::micro>(launchEnd - launchStart).count());
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            if (ok) {
+                result.variant = variant.name;
+                result.width = WIDTH;
+                result.height = HEIGHT;
+                result.species = NUMBER_OF_SPECIES;
+                result.generationsPerLaunch = generationsPerLaunch;
+                result.generations = launches * generationsPerLaunch;
+                result.seconds = seconds;
+                result.cellsPerSecond = static_cast<double>(WIDTH) * HEIGHT * result.generations / seconds;
+                result.p50LaunchUs = percentile(launchUs, 0.5);
+                result.p99LaunchUs = percentile(launchUs, 0.99);
+                result.downloadGBs = measureTransfer(readGridToHost, options.transferRepeats);
+            }
+        }
+
+        cleanupEngine();
+        return ok;
+    }
+
+    void writeJson(std::ostream &out, const Options &options, const std::vector<Result> &results) {
+        out << "{\n"
+            << "  \"compiler\": \"" << __VERSION__ << "\",\n"
+            << "  \"seed\": " << SEED << ",\n"
+            << "  \"warmup_generations\": " << options.warmup << ",\n"
+            << "  \"results\": [\n";
+        for (size_t i = 0; i < results.size(); i++) {
+            const Result &r = results[i];
+            out << "    {\"engine\": \"" << r.variant << "\", \"width\": " << r.width << ", \"height\": " << r.height
+                << ", \"species\": " << r.species << ", \"generations_per_launch\": " << r.generationsPerLaunch
+                << ", \"generations\": " << r.generations << ", \"seconds\": " << r.seconds
+                << ", \"cells_per_second\": " << r.cellsPerSecond
+                << ", \"p50_launch_us\": " << r.p50LaunchUs << ", \"p99_launch_us\": " << r.p99LaunchUs
+                << ", \"upload_gb_per_s\": " << r.uploadGBs << ", \"download_gb_per_s\": " << r.downloadGBs << "}"
+                << (i + 1 < results.size() ? ",\n" : "\n");
+        }
+        out << "  ]\n}\n";
+    }
+
+    void writeCsv(std::ostream &out, const std::vector<Result> &results) {
+        out << "engine,width,height,species,generations_per_launch,generations,seconds,cells_per_second,"
+               "p50_launch_us,p99_launch_us,upload_gb_per_s,download_gb_per_s\n";
+        for (const Result &r : results) {
+            out << r.variant << "," << r.width << "," << r.height << "," << r.species << ","
+                << r.generationsPerLaunch << "," << r.generations << "," << r.seconds << ","
+                << r.cellsPerSecond << "," << r.p50LaunchUs << "," << r.p99LaunchUs << ","
+                << r.uploadGBs << "," << r.downloadGBs << "\n";
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    SEED = 1;
+    HEADLESS = true;
+
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    std::vector<Result> results;
+    for (const GridSize &size : options.sizes) {
+        for (int species : options.species) {
+            for (const Variant *variant : options.variants) {
+                for (int generationsPerLaunch : options.generationsPerLaunch) {
+                    WIDTH = size.width;
+                    HEIGHT = size.height;
+                    NUMBER_OF_SPECIES = species;
+
+                    Result result = {};
+                    if (!runConfiguration(*variant, options, generationsPerLaunch, result)) continue;
+
+                    std::cout << result.variant << " " << result.width << "x" << result.height
+                              << " species=" << result.species << " K=" << result.generationsPerLaunch << ": "
+                              << result.cellsPerSecond / 1e6 << " Mcells/s, p50 " << result.p50LaunchUs
+                              << "us, p99 " << result.p99LaunchUs << "us\n";
+                    results.push_back(result);
+                }
+            }
+        }
+    }
+
+    std::ofstream out(options.outputPath);
+    if (!out) {
+        printf("Error: Failed to open %s!\n", options.outputPath);
+        return 1;
+    }
+    out.precision(10);
+    if (options.csv) {
+        writeCsv(out, results);
+    }
+    else {
+        writeJson(out, options, results);
+    }
+    std::cout << "Wrote " << results.size() << " results to " << options.outputPath << "\n";
+    return 0;
+}
@@ -0,0 +1,158 @@
+#include "Bitboard.h"
+#include "CpuEngine.h"
+
+namespace {
+    // Sum of three bits per lane: sum and carry of a full adder
+    inline void fullAdder(uint64_t a, uint64_t b, uint64_t c, uint64_t &sum, uint64_t &carry) {
+        uint64_t partial = a ^ b;
+        sum = partial ^ c;
+        carry = (a & b) | (partial & c);
+    }
+
+    // Bit-sliced count (0-8) of the neighbours set in plane around word w of row y,
+    // count = ones + 2 * twos + 4 * fours + 8 * eights
+    inline void neighbourCount(const uint64_t *plane, int wordsPerRow, int height, int y, int w,
+                               uint64_t &ones, uint64_t &twos, uint64_t &fours, uint64_t &eights) {
+        uint64_t neighbours[8] = {0};
+        int n = 0;
+
+        for (int row = y - 1; row <= y + 1; row++) {
+            uint64_t centre = 0, left = 0, right = 0;
+            if (row >= 0 && row < height) {
+                const uint64_t *words = plane + static_cast<size_t>(row) * wordsPerRow;
+                centre = words[w];
+                left = w > 0 ? words[w - 1] : 0;
+                right = w + 1 < wordsPerRow ? words[w + 1] : 0;
+            }
+
+            neighbours[n++] = (centre << 1) | (left >> 63);     // Neighbour at x - 1
+            neighbours[n++] = (centre >> 1) | (right << 63);    // Neighbour at x + 1
+            if (row != y) {
+                neighbours[n++] = centre;                       // Neighbour directly above/below
+            }
+        }
+
+        uint64_t sumA, carryA, sumB, carryB, sumC, carryC;
+        fullAdder(neighbours[0], neighbours[1], neighbours[2], sumA, carryA);
+        fullAdder(neighbours[3], neighbours[4], neighbours[5], sumB, carryB);
+        sumC = neighbours[6] ^ neighbours[7];
+        carryC = neighbours[6] & neighbours[7];
+
+        uint64_t carryOnes;
+        fullAdder(sumA, sumB, sumC, ones, carryOnes);
+
+        uint64_t sumTwos, carryTwos;
+        fullAdder(carryA, carryB, carryC, sumTwos, carryTwos);
+        twos = sumTwos ^ carryOnes;
+        uint64_t carryFours = sumTwos & carryOnes;
+
+        fours = carryTwos ^ carryFours;
+        eights = carryTwos & carryFours;
+    }
+}
+
+void packBitplanes(const cell_t *grid, uint64_t *planes, int width, int height,
+                   int numSpecies, int rowBegin, int rowEnd) {
+    int wordsPerRow = bitboardWordsPerRow(width);
+    size_t planeSize = bitboardPlaneSize(width, height);
+
+    for (int y = rowBegin; y < rowEnd; y++) {
+        for (int w = 0; w < wordsPerRow; w++) {
+            uint64_t words[10] = {0};
+            int xEnd = w * 64 + 64 < width ? w * 64 + 64 : width;
+            for (int x = w * 64; x < xEnd; x++) {
+                int speciesID = grid[y * width + x];
+                if (speciesID > 0 && speciesID <= numSpecies) {
+                    words[speciesID - 1] |= 1ull << (x - w * 64);
+                }
+            }
+            for (int species = 0; species < numSpecies; species++) {
+                planes[species * planeSize + static_cast<size_t>(y) * wordsPerRow + w] = words[species];
+            }
+        }
+    }
+}
+
+void unpackBitplanes(const uint64_t *planes, cell_t *grid, int width, int height,
+                     int numSpecies, int rowBegin, int rowEnd) {
+    int wordsPerRow = bitboardWordsPerRow(width);
+    size_t planeSize = bitboardPlaneSize(width, height);
+
+    for (int y = rowBegin; y < rowEnd; y++) {
+        cell_t *row = grid + static_cast<size_t>(y) * width;
+        for (int x = 0; x < width; x++) row[x] = -1;
+
+        for (int species = 0; species < numSpecies; species++) {
+            const uint64_t *words = planes + species * planeSize + static_cast<size_t>(y) * wordsPerRow;
+            for (int w = 0; w < wordsPerRow; w++) {
+                uint64_t bits = words[w];
+                while (bits) {
+                    row[w * 64 + __builtin_ctzll(bits)] = static_cast<cell_t>(species + 1);
+                    bits &= bits - 1;
+                }
+            }
+        }
+    }
+}
+
+void bitboardGameOfLifeRows(const uint64_t *current, uint64_t *next, int width, int height,
+                            int numSpecies, int rowBegin, int rowEnd) {
+    int wordsPerRow = bitboardWordsPerRow(width);
+    size_t planeSize = bitboardPlaneSize(width, height);
+    uint64_t lastWordMask = width % 64 == 0 ? ~0ull : (1ull << (width % 64)) - 1;
+
+    for (int y = rowBegin; y < rowEnd; y++) {
+        for (int w = 0; w < wordsPerRow; w++) {
+            size_t wordIndex = static_cast<size_t>(y) * wordsPerRow + w;
+            uint64_t valid = w == wordsPerRow - 1 ? lastWordMask : ~0ull;
+
+            uint64_t occupied = 0;
+            for (int species = 0; species < numSpecies; species++) {
+                occupied |= current[species * planeSize + wordIndex];
+            }
+            uint64_t dead = ~occupied & valid;
+
+            // seen: cells with at least one birth candidate, tied: cells with two or more
+            uint64_t births[10];
+            uint64_t seen = 0, tied = 0;
+
+            for (int species = 0; species < numSpecies; species++) {
+                const uint64_t *plane = current + species * planeSize;
+                uint64_t ones, twos, fours, eights;
+                neighbourCount(plane, wordsPerRow, height, y, w, ones, twos, fours, eights);
+
+                // Survival with 2 or 3 neighbours, birth with exactly 3
+                uint64_t twoOrThree = twos & ~fours & ~eights;
+                uint64_t survivors = plane[wordIndex] & twoOrThree;
+                births[species] = dead & twoOrThree & ones;
+
+                tied |= seen & births[species];
+                seen |= births[species];
+                next[species * planeSize + wordIndex] = survivors | births[species];
+            }
+
+            // Ties are rare, resolve them per cell with the kernel's PCG hash
+            if (tied) {
+                for (int species = 0; species < numSpecies; species++) {
+                    next[species * planeSize + wordIndex] &= ~tied;
+                }
+                while (tied) {
+                    int bit = __builtin_ctzll(tied);
+                    uint64_t cellBit = 1ull << bit;
+
+                    int reproductionConditionMet[10];
+                    int numCandidates = 0;
+                    for (int species = 0; species < numSpecies; species++) {
+                        if (births[species] & cellBit) reproductionConditionMet[numCandidates++] = species;
+                    }
+
+                    uint32_t cellIndex = static_cast<uint32_t>(y * width + w * 64 + bit);
+                    int selected = reproductionConditionMet[pcgHash(cellIndex) % numCandidates];
+                    next[selected * planeSize + wordIndex] |= cellBit;
+
+                    tied &= tied - 1;
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,35 @@
+#ifndef FINAL_PROJECT_BITBOARD_H
+#define FINAL_PROJECT_BITBOARD_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Configs.h"
+
+// Bit-sliced representation of the grid: one bitplane per species with 64
+// cells per uint64_t (bit b of word w is cell x = w * 64 + b). Neighbour
+// counts for a whole word are added with full-adder logic, so survival and
+// birth become bitwise masks instead of per-cell loops. Bits past the grid
+// width are always zero.
+
+inline int bitboardWordsPerRow(int width) {
+    return (width + 63) / 64;
+}
+
+// Words in one species' bitplane
+inline size_t bitboardPlaneSize(int width, int height) {
+    return static_cast<size_t>(bitboardWordsPerRow(width)) * height;
+}
+
+// Convert rows [rowBegin, rowEnd) between the cell grid and the bitplanes
+void packBitplanes(const cell_t *grid, uint64_t *planes, int width, int height,
+                   int numSpecies, int rowBegin, int rowEnd);
+void unpackBitplanes(const uint64_t *planes, cell_t *grid, int width, int height,
+                     int numSpecies, int rowBegin, int rowEnd);
+
+// Apply one generation of the multispecies rule to rows [rowBegin, rowEnd).
+// Matches the gameOfLife kernel exactly, including the PCG tie-break.
+void bitboardGameOfLifeRows(const uint64_t *current, uint64_t *next, int width, int height,
+                            int numSpecies, int rowBegin, int rowEnd);
+
+#endif
@@ -0,0 +1,258 @@
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Checkpoint.h"
+#include "Trace.h"
+#include "Rule.h"
+
+namespace {
+    constexpr uint32_t CHECKPOINT_VERSION = 1;
+    constexpr uint32_t ENCODING_RLE = 1;
+
+    struct CheckpointHeader {
+        char magic[8];          // "GOLCKPT\0"
+        uint32_t version;
+        uint32_t encoding;      // Payload encoding, ENCODING_RLE
+        uint32_t width;
+        uint32_t height;
+        uint32_t numSpecies;
+        uint32_t seed;          // Seed the run was started from
+        uint64_t generation;
+        uint64_t payloadBytes;
+        uint64_t payloadHash;   // FNV-1a of the payload
+        char rule[64];          // Null-terminated rulestring
+        uint32_t reserved[2];
+    };
+    static_assert(sizeof(CheckpointHeader) == 128, "Checkpoint header must stay 128 bytes");
+
+    uint64_t fnv1a(const uint8_t *data, size_t size) {
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < size; i++) {
+            hash ^= data[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    bool parseCheckpointRule(const CheckpointHeader *header, Rule &rule, Boundary &boundary) {
+        std::string text(header->rule, strnlen(header->rule, sizeof(header->rule)));
+        size_t colon = text.find(':');
+        boundary = BOUNDARY_DEAD;
+        if (colon != std::string::npos) {
+            std::string torus = "T" + std::to_string(header->width) + "," + std::to_string(header->height);
+            if (text.compare(colon + 1, std::string::npos, torus) != 0) return false;
+            boundary = BOUNDARY_TORUS;
+            text.resize(colon);
+        }
+        return parseRule(text.c_str(), rule);
+    }
+
+    void encodeRuns(const std::vector<cell_t> &grid, std::vector<uint8_t> &payload) {
+        payload.clear();
+        size_t cellIndex = 0;
+        while (cellIndex < grid.size()) {
+            cell_t species = grid[cellIndex];
+            size_t runEnd = cellIndex + 1;
+            while (runEnd < grid.size() && grid[runEnd] == species) runEnd++;
+
+            payload.push_back(static_cast<uint8_t>(species));
+            uint64_t length = runEnd - cellIndex;
+            do {
+                uint8_t byte = length & 0x7F;
+                length >>= 7;
+                payload.push_back(length ? byte | 0x80 : byte);
+            } while (length);
+
+            cellIndex = runEnd;
+        }
+    }
+
+    bool decodeRuns(const uint8_t *payload, size_t payloadBytes, std::vector<cell_t> &grid) {
+        const uint8_t *end = payload + payloadBytes;
+        size_t cellIndex = 0;
+        while (payload < end) {
+            cell_t species = static_cast<cell_t>(*payload++);
+            uint64_t length = 0;
+            for (int shift = 0; ; shift += 7) {
+                if (payload == end || shift > 63) return false;
+                uint8_t byte = *payload++;
+                length |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                if (!(byte & 0x80)) break;
+            }
+            if (species != -1 && (species < 1 || species > NUMBER_OF_SPECIES)) return false;
+            if (length > grid.size() - cellIndex) return false;
+
+            std::memset(grid.data() + cellIndex, static_cast<uint8_t>(species), length);
+            cellIndex += length;
+        }
+        return cellIndex == grid.size();
+    }
+}
+
+bool loadCheckpoint(const char *path, std::vector<cell_t> &grid, uint64_t &generation) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        printf("Error: Failed to open checkpoint %s!\n", path);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(CheckpointHeader)) {
+        printf("Error: %s is not a checkpoint!\n", path);
+        close(fd);
+        return false;
+    }
+
+    size_t fileSize = static_cast<size_t>(info.st_size);
+    void *mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        printf("Error: Failed to map checkpoint %s!\n", path);
+        return false;
+    }
+    madvise(mapping, fileSize, MADV_SEQUENTIAL);
+
+    const CheckpointHeader *header = static_cast<const CheckpointHeader *>(mapping);
+    const uint8_t *payload = static_cast<const uint8_t *>(mapping) + sizeof(CheckpointHeader);
+
+    Rule rule;
+    Boundary boundary;
+    bool valid = true;
+    if (std::memcmp(header->magic, "GOLCKPT", 8) != 0 || header->version != CHECKPOINT_VERSION ||
+        header->encoding != ENCODING_RLE) {
+        printf("Error: %s is not a version %u checkpoint!\n", path, CHECKPOINT_VERSION);
+        valid = false;
+    }
+    else if (header->payloadBytes != fileSize - sizeof(CheckpointHeader) ||
+             fnv1a(payload, header->payloadBytes) != header->payloadHash) {
+        printf("Error: Checkpoint %s is truncated or corrupt!\n", path);
+        valid = false;
+    }
+    else if (strnlen(header->rule, sizeof(header->rule)) == sizeof(header->rule) ||
+             !parseCheckpointRule(header, rule, boundary)) {
+        printf("Error: Checkpoint %s uses unsupported rule '%.64s'!\n", path, header->rule);
+        valid = false;
+    }
+    else if (header->width < 1 || header->height < 1 || header->numSpecies < 5 || header->numSpecies > 10 ||
+             static_cast<uint64_t>(header->width) * header->height * 3 > INT_MAX) {
+        printf("Error: Checkpoint %s has an unsupported grid size or species count!\n", path);
+        valid = false;
+    }
+
+    if (valid) {
+        WIDTH = static_cast<int>(header->width);
+        HEIGHT = static_cast<int>(header->height);
+        NUMBER_OF_SPECIES = static_cast<int>(header->numSpecies);
+        RULE = rule;
+        BOUNDARY = boundary;
+        PADDED = PADDED || boundary == BOUNDARY_TORUS;
+        SEED = header->seed;
+        generation = header->generation;
+
+        grid.resize(static_cast<size_t>(WIDTH) * HEIGHT);
+        if (!decodeRuns(payload, header->payloadBytes, grid)) {
+            printf("Error: Checkpoint %s has an invalid payload!\n", path);
+            valid = false;
+        }
+    }
+
+    munmap(mapping, fileSize);
+    return valid;
+}
+
+std::string checkpointRule() {
+    std::string rule = ruleString(RULE);
+    if (BOUNDARY == BOUNDARY_TORUS) rule += ":T" + std::to_string(WIDTH) + "," + std::to_string(HEIGHT);
+    return rule;
+}
+
+bool saveCheckpoint(const char *path, const std::vector<cell_t> &grid, uint64_t generation, const std::string &rule) {
+    std::vector<uint8_t> payload;
+    encodeRuns(grid, payload);
+
+    CheckpointHeader header = {};
+    std::memcpy(header.magic, "GOLCKPT", 8);
+    header.version = CHECKPOINT_VERSION;
+    header.encoding = ENCODING_RLE;
+    header.width = WIDTH;
+    header.height = HEIGHT;
+    header.numSpecies = NUMBER_OF_SPECIES;
+    header.seed = SEED;
+    header.generation = generation;
+    header.payloadBytes = payload.size();
+    header.payloadHash = fnv1a(payload.data(), payload.size());
+    std::strncpy(header.rule, rule.c_str(), sizeof(header.rule) - 1);
+
+    // Never leave a half-written checkpoint in place of the last good one
+    std::string temporaryPath = std::string(path) + ".tmp";
+    FILE *file = std::fopen(temporaryPath.c_str(), "wb");
+    if (file == nullptr) {
+        printf("Error: Failed to create checkpoint %s!\n", temporaryPath.c_str());
+        return false;
+    }
+    bool written = std::fwrite(&header, sizeof(header), 1, file) == 1 &&
+                   std::fwrite(payload.data(), 1, payload.size(), file) == payload.size();
+    written = std::fflush(file) == 0 && fsync(fileno(file)) == 0 && written;
+    written = std::fclose(file) == 0 && written;
+
+    if (!written || std::rename(temporaryPath.c_str(), path) != 0) {
+        printf("Error: Failed to write checkpoint %s!\n", path);
+        std::remove(temporaryPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+CheckpointWriter::CheckpointWriter(std::string path) : path(std::move(path)) {
+    writer = std::thread(&CheckpointWriter::writerLoop, this);
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_one();
+    writer.join();
+}
+
+void CheckpointWriter::submit(const std::vector<cell_t> &grid, uint64_t generation) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingGrid.assign(grid.begin(), grid.end());
+        pendingGeneration = generation;
+        pendingRule = checkpointRule();
+        hasPending = true;
+    }
+    workAvailable.notify_one();
+}
+
+void CheckpointWriter::writerLoop() {
+    traceNameThread("Checkpoint writer");
+    std::vector<cell_t> grid;
+    std::string rule;
+    while (true) {
+        uint64_t generation;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [this] { return hasPending || stopping; });
+            if (!hasPending) return;
+
+            grid.swap(pendingGrid);
+            generation = pendingGeneration;
+            rule.swap(pendingRule);
+            hasPending = false;
+        }
+
+        TraceScope scope("Write checkpoint");
+        if (saveCheckpoint(path.c_str(), grid, generation, rule)) {
+            std::cout << "Checkpoint written to " << path << " at generation " << generation << "\n";
+        }
+    }
+}
@@ -0,0 +1,57 @@
+#ifndef FINAL_PROJECT_CHECKPOINT_H
+#define FINAL_PROJECT_CHECKPOINT_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Configs.h"
+
+// Versioned binary snapshots of a grid. A 128-byte header (dimensions,
+// species count, generation, seed, rule) is followed by a run-length encoded
+// payload of (species, LEB128 run length) pairs, which stays small once the
+// grid settles into large empty or uniform regions.
+
+// Restore a checkpoint, setting WIDTH, HEIGHT, NUMBER_OF_SPECIES, SEED, RULE and BOUNDARY
+// from its header. The file is memory-mapped and decoded straight from the mapping.
+bool loadCheckpoint(const char *path, std::vector<cell_t> &grid, uint64_t &generation);
+
+// Header rulestring of the current RULE and BOUNDARY, Golly's ":T<width>,<height>" suffix marks a torus
+std::string checkpointRule();
+
+// Write a checkpoint atomically (to path.tmp, then renamed over path), rule from checkpointRule()
+bool saveCheckpoint(const char *path, const std::vector<cell_t> &grid, uint64_t generation, const std::string &rule);
+
+// Writes checkpoints on a background thread. submit() only copies the grid,
+// encoding and disk I/O happen on the writer thread. If the writer is still
+// busy, the newest submitted grid replaces the one waiting to be written.
+// The rule is captured by submit() too, so the writer thread never reads RULE,
+// which may already be destroyed when the last checkpoint is written.
+class CheckpointWriter {
+public:
+    explicit CheckpointWriter(std::string path);
+    ~CheckpointWriter();    // Writes anything still pending, then stops the thread
+
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    void submit(const std::vector<cell_t> &grid, uint64_t generation);
+
+private:
+    void writerLoop();
+
+    std::string path;
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::vector<cell_t> pendingGrid;
+    uint64_t pendingGeneration = 0;
+    std::string pendingRule;
+    bool hasPending = false;
+    bool stopping = false;
+};
+
+#endif
@@ -0,0 +1,496 @@
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+
+#include "CommandLine.h"
+#include "Configs.h"
+#include "Rule.h"
+
+namespace {
+    bool speciesGiven = false;
+
+    // Parse a whole-string integer in [min, max], printing an error on failure
+    bool parseInt(const char* flag, const char* value, long min, long max, long &result) {
+        if (value == nullptr) {
+            printf("Error: %s expects a value!\n", flag);
+            return false;
+        }
+
+        char* end = nullptr;
+        long parsed = std::strtol(value, &end, 10);
+        if (end == value || *end != '\0' || parsed < min || parsed > max) {
+            printf("Error: %s expects an integer in [%ld, %ld], got '%s'!\n", flag, min, max, value);
+            return false;
+        }
+
+        result = parsed;
+        return true;
+    }
+}
+
+bool parseCommandLine(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        const char* flag = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        long parsed;
+
+        if (std::strcmp(flag, "--help") == 0 || std::strcmp(flag, "-h") == 0) {
+            printUsage(argv[0]);
+            return false;
+        }
+        else if (std::strcmp(flag, "--headless") == 0) {
+            HEADLESS = true;
+        }
+        else if (std::strcmp(flag, "--generations") == 0) {
+            if (!parseInt(flag, value, 0, INT_MAX, parsed)) return false;
+            GENERATIONS = static_cast<int>(parsed);
+            i++;
+        }
+        else if (std::strcmp(flag, "--generations-per-frame") == 0) {
+            if (!parseInt(flag, value, 1, 1 << 16, parsed)) return false;
+            GENERATIONS_PER_FRAME = static_cast<int>(parsed);
+            i++;
+        }
+        else if (std::strcmp(flag, "--engine") == 0) {
+            if (value != nullptr && std::strcmp(value, "opencl") == 0) {
+                ENGINE = ENGINE_OPENCL;
+            }
+            else if (value != nullptr && std::strcmp(value, "cpu") == 0) {
+                ENGINE = ENGINE_CPU;
+            }
+            else if (value != nullptr && std::strcmp(value, "multi") == 0) {
+                ENGINE = ENGINE_MULTI_DEVICE;
+            }
+            else {
+                printf("Error: --engine expects 'opencl', 'cpu' or 'multi'!\n");
+                return false;
+            }
+            i++;
+        }
+        else if (std::strcmp(flag, "--threads") == 0) {
+            if (!parseInt(flag, value, 0, 1024, parsed)) return false;
+            THREADS = static_cast<unsigned int>(parsed);
+            i++;
+        }
+        else if (std::strcmp(flag, "--no-simd") == 0) {
+            SIMD = false;
+        }
+        else if (std::strcmp(flag, "--no-specialise") == 0) {
+            SPECIALISE = false;
+        }
+        else if (std::strcmp(flag, "--bitboard") == 0) {
+            BITBOARD = true;
+        }
+        else if (std::strcmp(flag, "--tiled") == 0) {
+            TILED = true;
+        }
+        else if (std::strcmp(flag, "--retune") == 0) {
+            TILED = true;
+            RETUNE = true;
+        }
+        else if (std::strcmp(flag, "--active-tiles") == 0) {
+            ACTIVE_TILES = true;
+        }
+        else if (std::strcmp(flag, "--padded") == 0) {
+            PADDED = true;
+        }
+        else if (std::strcmp(flag, "--boundary") == 0) {
+            if (value != nullptr && std::strcmp(value, "dead") == 0) {
+                BOUNDARY = BOUNDARY_DEAD;
+            }
+            else if (value != nullptr && std::strcmp(value, "torus") == 0) {
+                BOUNDARY = BOUNDARY_TORUS;
+                PADDED = true;
+            }
+            else {
+                printf("Error: --boundary expects 'dead' or 'torus'!\n");
+                return false;
+            }
+            i++;
+        }
+        else if (std::strcmp(flag, "--species") == 0) {
+            if (!parseInt(flag, value, 5, 10, parsed)) return false;
+            NUMBER_OF_SPECIES = static_cast<int>(parsed);
+            speciesGiven = true;
+            i++;
+        }
+        else if (std::strcmp(flag, "--seed") == 0) {
+            if (!parseInt(flag, value, 0, UINT_MAX, parsed)) return false;
+            SEED = static_cast<unsigned int>(parsed);
+            i++;
+        }
+        else if (std::strcmp(flag, "--pattern") == 0) {
+            if (value == nullptr) {
+                printf("Error: --pattern expects a path!\n");
+                return false;
+            }
+            PATTERN_PATH = value;
+            i++;
+        }
+        else if (std::strcmp(flag, "--pattern-at") == 0) {
+            char trailing;
+            if (value == nullptr || std::sscanf(value, "%d,%d%c", &PATTERN_X, &PATTERN_Y, &trailing) != 2 ||
+                PATTERN_X < 0 || PATTERN_Y < 0) {
+                printf("Error: --pattern-at expects X,Y with X, Y >= 0!\n");
+                return false;
+            }
+            i++;
+        }
+        else if (std::strcmp(flag, "--width") == 0) {
+            if (!parseInt(flag, value, 1, 1 << 20, parsed)) return false;
+            WIDTH = static_cast<int>(parsed);
+            i++;
+        }
+        else if (std::strcmp(flag, "--height") == 0) {
+            if (!parseInt(flag, value, 1, 1 << 24, parsed)) return false;
+            HEIGHT = static_cast<int>(parsed);
+            i++;
+        }
+        else if (std::strcmp(flag, "--state-file") == 0) {
+            if (value == nullptr) {
+                printf("Error: --state-file expects a path!\n");
+                return false;
+            }
+            STATE_FILE = value;
+            HEADLESS = true;
+            i++;
+        }
+        else if (std::strcmp(flag, "--strip-rows") == 0) {
+            if (!parseInt(flag, value, 1, 1 << 24, parsed)) return false;
+            STRIP_ROWS = static_cast<int>(parsed);
+            i++;
+        }
+        else if (std::strcmp(flag, "--ensemble") == 0) {
+            if (!parseInt(flag, value, 1, 1 << 20, parsed)) return false;
+            ENSEMBLE_SIZE = static_cast<int>(parsed);
+            HEADLESS = true;
+            i++;
+        }
+        else if (std::strcmp(flag, "--ensemble-file") == 0) {
+            if (value == nullptr) {
+                printf("Error: --ensemble-file expects a path!\n");
+                return false;
+            }
+            ENSEMBLE_PATH = value;
+            HEADLESS = true;
+            i++;
+        }
+        else if (std::strcmp(flag, "--devices") == 0) {
+            if (!parseInt(flag, value, 0, 64, parsed)) return false;
+            DEVICES = static_cast<int>(parsed);
+            ENGINE = ENGINE_MULTI_DEVICE;
+            i++;
+        }
+        else if (std::strcmp(flag, "--checkpoint-every") == 0) {
+            if (!parseInt(flag, value, 0, INT_MAX, parsed)) return false;
+            CHECKPOINT_EVERY = static_cast<int>(parsed);
+            i++;
+        }
+        else if (std::strcmp(flag, "--checkpoint") == 0) {
+            if (value == nullptr) {
+                printf("Error: --checkpoint expects a path!\n");
+                return false;
+            }
+            CHECKPOINT_PATH = value;
+            i++;
+        }
+        else if (std::strcmp(flag, "--restore") == 0) {
+            if (value == nullptr) {
+                printf("Error: --restore expects a path!\n");
+                return false;
+            }
+            RESTORE_PATH = value;
+            speciesGiven = true;
+            i++;
+        }
+        else if (std::strcmp(flag, "--export") == 0) {
+            if (value == nullptr) {
+                printf("Error: --export expects a path!\n");
+                return false;
+            }
+            EXPORT_PATH = value;
+            i++;
+        }
+        else if (std::strcmp(flag, "--export-format") == 0) {
+            if (value != nullptr && std::strcmp(value, "ppm") == 0) {
+                EXPORT_FORMAT = FRAME_PPM;
+            }
+            else if (value != nullptr && std::strcmp(value, "y4m") == 0) {
+                EXPORT_FORMAT = FRAME_Y4M;
+            }
+            else if (value != nullptr && std::strcmp(value, "delta") == 0) {
+                EXPORT_FORMAT = FRAME_DELTA;
+            }
+            else {
+                printf("Error: --export-format expects 'ppm', 'y4m' or 'delta'!\n");
+                return false;
+            }
+            i++;
+        }
+        else if (std::strcmp(flag, "--trace") == 0) {
+            if (value == nullptr) {
+                printf("Error: --trace expects a path!\n");
+                return false;
+            }
+            TRACE_PATH = value;
+            i++;
+        }
+        else if (std::strcmp(flag, "--print-timing") == 0) {
+            PRINT_TIMING = true;
+        }
+        else if (std::strcmp(flag, "--pipeline-depth") == 0) {
+            if (!parseInt(flag, value, 1, MAX_PIPELINE_DEPTH, parsed)) return false;
+            PIPELINE_DEPTH = static_cast<int>(parsed);
+            i++;
+        }
+        else if (std::strcmp(flag, "--rule") == 0) {
+            if (value == nullptr || !parseRule(value, RULE)) {
+                printf("Error: --rule expects a B/S rulestring such as B3/S23, or Larger than Life such as R5,C0,M1,S34..58,B34..45,NM!\n");
+                return false;
+            }
+            i++;
+        }
+        else if (std::strcmp(flag, "--fused-pixels") == 0) {
+            FUSED_PIXELS = true;
+        }
+        else if (std::strcmp(flag, "--window") == 0) {
+            char trailing;
+            if (value == nullptr || std::sscanf(value, "%dx%d%c", &VIEW_WIDTH, &VIEW_HEIGHT, &trailing) != 2 ||
+                VIEW_WIDTH < 1 || VIEW_HEIGHT < 1 || VIEW_WIDTH > 16384 || VIEW_HEIGHT > 16384) {
+                printf("Error: --window expects WxH with W, H in [1, 16384]!\n");
+                return false;
+            }
+            i++;
+        }
+        else if (std::strcmp(flag, "--detect-cycles") == 0) {
+            if (!parseInt(flag, value, 1, 1 << 20, parsed)) return false;
+            CYCLE_WINDOW = static_cast<int>(parsed);
+            i++;
+        }
+        else if (std::strcmp(flag, "--on-cycle") == 0) {
+            if (value != nullptr && std::strcmp(value, "stop") == 0) {
+                CYCLE_ACTION = CYCLE_STOP;
+            }
+            else if (value != nullptr && std::strcmp(value, "jump") == 0) {
+                CYCLE_ACTION = CYCLE_JUMP;
+            }
+            else {
+                printf("Error: --on-cycle expects 'stop' or 'jump'!\n");
+                return false;
+            }
+            i++;
+        }
+        else if (std::strcmp(flag, "--stats") == 0) {
+            if (value == nullptr) {
+                printf("Error: --stats expects a path!\n");
+                return false;
+            }
+            STATS_PATH = value;
+            i++;
+        }
+        else if (std::strcmp(flag, "--stats-format") == 0) {
+            if (value != nullptr && std::strcmp(value, "csv") == 0) {
+                STATS_FORMAT = STATS_CSV;
+            }
+            else if (value != nullptr && std::strcmp(value, "binary") == 0) {
+                STATS_FORMAT = STATS_BINARY;
+            }
+            else {
+                printf("Error: --stats-format expects 'csv' or 'binary'!\n");
+                return false;
+            }
+            i++;
+        }
+        else if (std::strcmp(flag, "--sub-devices") == 0) {
+            if (!parseInt(flag, value, 1, 256, parsed)) return false;
+            SUB_DEVICES = static_cast<int>(parsed);
+            ENGINE = ENGINE_MULTI_DEVICE;
+            i++;
+        }
+        else {
+            printf("Error: Unknown option '%s'!\n", flag);
+            printUsage(argv[0]);
+            return false;
+        }
+    }
+
+    // In-core grids (and their pixel buffers) are indexed with int
+    if (STATE_FILE == nullptr && static_cast<size_t>(WIDTH) * HEIGHT * 3 > INT_MAX) {
+        printf("Error: A %dx%d grid is too large to hold in memory, use --state-file!\n", WIDTH, HEIGHT);
+        return false;
+    }
+    if (STATE_FILE != nullptr && static_cast<size_t>(STRIP_ROWS + 2) * WIDTH > INT_MAX) {
+        printf("Error: --strip-rows %d is too large for a width of %d!\n", STRIP_ROWS, WIDTH);
+        return false;
+    }
+
+    // Out-of-core runs persist every generation in their state file and never hold the whole grid
+    if (STATE_FILE != nullptr && (RESTORE_PATH != nullptr || CHECKPOINT_EVERY > 0 || EXPORT_PATH != nullptr)) {
+        printf("Error: --restore, --checkpoint-every and --export can't be combined with --state-file!\n");
+        return false;
+    }
+
+    // Restored grids and ensembles aren't seeded, so there's nothing to place the pattern on
+    if (PATTERN_PATH != nullptr && (RESTORE_PATH != nullptr || ENSEMBLE_SIZE > 0 || ENSEMBLE_PATH != nullptr)) {
+        printf("Error: --pattern can't be combined with --restore, --ensemble or --ensemble-file!\n");
+        return false;
+    }
+
+    // Ensembles run their own batched kernel on one device and only report a summary
+    bool ensemble = ENSEMBLE_SIZE > 0 || ENSEMBLE_PATH != nullptr;
+    if (ensemble && (ENGINE != ENGINE_OPENCL || BITBOARD || TILED || ACTIVE_TILES || PADDED || FUSED_PIXELS ||
+                     STATE_FILE != nullptr || RESTORE_PATH != nullptr || CHECKPOINT_EVERY > 0 ||
+                     EXPORT_PATH != nullptr || STATS_PATH != nullptr || CYCLE_WINDOW > 0)) {
+        printf("Error: --ensemble and --ensemble-file only run the reference OpenCL update and can't be combined "
+               "with other engines or updates, --state-file, --restore, --checkpoint-every, --export, --stats "
+               "or --detect-cycles!\n");
+        return false;
+    }
+
+    // The multi-device engine only has the reference update
+    if (ENGINE == ENGINE_MULTI_DEVICE && (BITBOARD || TILED || ACTIVE_TILES || PADDED)) {
+        printf("Error: --bitboard, --tiled, --active-tiles and --padded are not supported by the multi-device engine!\n");
+        return false;
+    }
+
+    // The tiled kernel and its work-group autotuner only exist on the OpenCL engine
+    if (TILED && ENGINE != ENGINE_OPENCL) {
+        printf("Error: --tiled and --retune need --engine opencl!\n");
+        return false;
+    }
+
+    // Each update variant is its own kernel, active tiles only track the reference update
+    if (ACTIVE_TILES && (BITBOARD || TILED)) {
+        printf("Error: --active-tiles can't be combined with --bitboard, --tiled or --retune!\n");
+        return false;
+    }
+
+    // The padded layout is its own update, not a layout for the others
+    if (PADDED && (BITBOARD || TILED || ACTIVE_TILES)) {
+        printf("Error: --padded and --boundary torus can't be combined with --bitboard, --tiled or --active-tiles!\n");
+        return false;
+    }
+
+    // Only the reference OpenCL update has a colouring variant
+    if (FUSED_PIXELS && (ENGINE == ENGINE_CPU || ENGINE == ENGINE_MULTI_DEVICE || BITBOARD || TILED || ACTIVE_TILES ||
+                         PADDED)) {
+        printf("Error: --fused-pixels can't be combined with --bitboard, --tiled, --active-tiles, --padded, "
+               "the CPU engine or the multi-device engine!\n");
+        return false;
+    }
+
+    // Fused frames are coloured cell for cell by the update, the others render nothing
+    if (VIEW_WIDTH > 0 && (FUSED_PIXELS || STATE_FILE != nullptr || ENSEMBLE_SIZE > 0 || ENSEMBLE_PATH != nullptr)) {
+        printf("Error: --window can't be combined with --fused-pixels, --state-file, --ensemble or --ensemble-file!\n");
+        return false;
+    }
+
+    // Fingerprints are taken by the in-core headless loop
+    if (CYCLE_WINDOW > 0 && (!HEADLESS || STATE_FILE != nullptr)) {
+        printf("Error: --detect-cycles needs --headless and can't be combined with --state-file!\n");
+        return false;
+    }
+
+    // Statistics are counted after every update, the fused kernel only hands back the frame's last generation
+    if (STATS_PATH != nullptr && (FUSED_PIXELS || STATE_FILE != nullptr)) {
+        printf("Error: --stats can't be combined with --fused-pixels or --state-file!\n");
+        return false;
+    }
+
+    if (!ruleSupportedByOptions()) return false;
+
+    // A headless run always needs a finite number of generations
+    if (HEADLESS && GENERATIONS == 0) {
+        GENERATIONS = 1000;
+    }
+
+    return true;
+}
+
+bool speciesGivenOnCommandLine() {
+    return speciesGiven;
+}
+
+bool ruleSupportedByOptions() {
+    // The other updates and the strip kernels only implement B3/S23
+    if (!isLifeRule(RULE) && (ENGINE == ENGINE_MULTI_DEVICE || STATE_FILE != nullptr ||
+                              BITBOARD || TILED || ACTIVE_TILES || FUSED_PIXELS || PADDED)) {
+        printf("Error: Rule %s can't be combined with --bitboard, --tiled, --active-tiles, --fused-pixels, --padded, "
+               "--boundary torus, --state-file or the multi-device engine!\n", ruleString(RULE).c_str());
+        return false;
+    }
+
+    // Only the padded update wraps the grid, restored torus checkpoints haven't been checked yet
+    if (BOUNDARY == BOUNDARY_TORUS && (ENGINE == ENGINE_MULTI_DEVICE || STATE_FILE != nullptr ||
+                                       BITBOARD || TILED || ACTIVE_TILES || FUSED_PIXELS)) {
+        printf("Error: --boundary torus can't be combined with --bitboard, --tiled, --active-tiles, --fused-pixels, "
+               "--state-file or the multi-device engine!\n");
+        return false;
+    }
+
+    // The ensemble kernel is the reference update for every instance
+    if ((!isLifeRule(RULE) || BOUNDARY == BOUNDARY_TORUS) && (ENSEMBLE_SIZE > 0 || ENSEMBLE_PATH != nullptr)) {
+        printf("Error: --ensemble only supports B3/S23 with dead boundaries!\n");
+        return false;
+    }
+
+    // Contested births are cells where several species had exactly 3 neighbours
+    if (!isLifeRule(RULE) && STATS_PATH != nullptr) {
+        printf("Error: Rule %s can't be combined with --stats!\n", ruleString(RULE).c_str());
+        return false;
+    }
+    return true;
+}
+
+void printUsage(const char* programName) {
+    std::cout << "Usage: " << programName << " [options]\n"
+              << "  --headless          Run without a window and report throughput\n"
+              << "  --generations N     Stop after N generations (headless default: 1000)\n"
+              << "  --generations-per-frame K\n"
+              << "                      Generations computed on the device between frames (default: 1)\n"
+              << "  --engine NAME       opencl, cpu or multi (default: opencl, falls back to cpu)\n"
+              << "  --threads N         CPU engine worker threads (default: all hardware threads)\n"
+              << "  --no-simd           Force the scalar CPU update instead of AVX2/NEON\n"
+              << "  --no-specialise     Pass the grid size and species to the OpenCL kernels at run time\n"
+              << "  --bitboard          Use the bit-sliced bitplane update (both engines)\n"
+              << "  --tiled             Use the local-memory tiled OpenCL kernel\n"
+              << "  --retune            Re-run the work-group size benchmark (implies --tiled)\n"
+              << "  --active-tiles      Skip tiles where nothing changed last generation\n"
+              << "  --padded            Use the ghost-cell padded update without bounds checks (both engines)\n"
+              << "  --boundary B        dead or torus, torus wraps the grid and implies --padded (default: dead)\n"
+              << "  --species N         Number of species (5-10), skips the startup prompt\n"
+              << "  --rule RULE         B/S or Larger than Life rulestring (default: B3/S23)\n"
+              << "  --seed N            Seed for the initial grid (default: current time)\n"
+              << "  --pattern PATH      Place an RLE or plaintext pattern on a dead grid instead of seeding it\n"
+              << "  --pattern-at X,Y    Top-left corner of the pattern (default: centred)\n"
+              << "  --width N           Grid width in cells (default: " << WIDTH << ")\n"
+              << "  --height N          Grid height in cells (default: " << HEIGHT << ")\n"
+              << "  --state-file PATH   Stream the grid from a memory-mapped file (out-of-core, headless)\n"
+              << "  --strip-rows N      Rows per out-of-core strip (default: about 64 MB per strip)\n"
+              << "  --ensemble N        Run N copies of the grid with seeds from --seed as one batched ensemble\n"
+              << "  --ensemble-file PATH\n"
+              << "                      Run the ensemble listed in PATH, one 'width height species seed' per line\n"
+              << "  --devices N         Split the grid over N GPUs, 0 = all of them (implies --engine multi)\n"
+              << "  --sub-devices N     Split the grid over N CPU sub-devices (implies --engine multi)\n"
+              << "  --checkpoint-every N\n"
+              << "                      Write a checkpoint every N generations from a background thread\n"
+              << "  --checkpoint PATH   Checkpoint file (default: gol.checkpoint)\n"
+              << "  --restore PATH      Resume from a checkpoint instead of seeding a new grid\n"
+              << "  --export PATH       Stream a frame per batch of generations to a file or named pipe\n"
+              << "  --export-format F   ppm, y4m or delta (default: ppm)\n"
+              << "  --trace PATH        Record a timeline of every frame stage, written as Chrome trace JSON\n"
+              << "                      on exit and when 't' is pressed\n"
+              << "  --print-timing      Print kernel and host timings after every frame\n"
+              << "  --pipeline-depth N  Frames in flight in the window, 2-3 overlap compute and drawing (default: 1)\n"
+              << "  --fused-pixels      Colour each frame's last generation in the update kernel (OpenCL)\n"
+              << "  --window WxH        Window and exported frame size in pixels, pan and zoom over larger grids\n"
+              << "                      (default: the grid, at most 1024x1024 in the window)\n"
+              << "  --detect-cycles N   Stop once the grid repeats within N generations or dies out (headless)\n"
+              << "  --on-cycle ACTION   stop, or jump to the last generation by skipping whole periods (default: stop)\n"
+              << "  --stats PATH        Stream per-species population, births, deaths and contested births\n"
+              << "                      of every generation to a file or named pipe\n"
+              << "  --stats-format F    csv or binary (default: csv)\n"
+              << "  --help              Show this message\n";
+}
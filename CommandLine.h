@@ -0,0 +1,18 @@
+#ifndef FINAL_PROJECT_COMMANDLINE_H
+#define FINAL_PROJECT_COMMANDLINE_H
+
+// Parse command line flags into the run parameters declared in Configs.h
+// Returns false if the program should exit (invalid flags or --help)
+bool parseCommandLine(int argc, char** argv);
+
+// True if the number of species was given with --species, so it
+// doesn't need to be asked for at startup
+bool speciesGivenOnCommandLine();
+
+// False if RULE or BOUNDARY needs an update the selected options don't have. Checked
+// again after --restore, since restored runs take both from the checkpoint.
+bool ruleSupportedByOptions();
+
+void printUsage(const char* programName);
+
+#endif
@@ -1,5 +1,59 @@
+#include <ctime>
+
 #include "Configs.h"
 
 // Assign NUMBER_OF_SPECIES a default value for compiler
 // Can be overwritten at runtime
-int NUMBER_OF_SPECIES = 5;
\ No newline at end of file
+int NUMBER_OF_SPECIES = 5;
+
+// Default grid size, can be overwritten with --width/--height
+int WIDTH = 1024;
+int HEIGHT = 768;
+
+// Default run parameters, can be overwritten from the command line
+bool HEADLESS = false;
+int GENERATIONS = 0;
+unsigned int SEED = static_cast<unsigned int>(std::time(nullptr));
+const char *PATTERN_PATH = nullptr;
+int PATTERN_X = -1;
+int PATTERN_Y = -1;
+int GENERATIONS_PER_FRAME = 1;
+Engine ENGINE = ENGINE_OPENCL;
+unsigned int THREADS = 0;
+bool SIMD = true;
+bool SPECIALISE = true;
+bool BITBOARD = false;
+bool TILED = false;
+bool RETUNE = false;
+bool ACTIVE_TILES = false;
+bool PADDED = false;
+Boundary BOUNDARY = BOUNDARY_DEAD;
+const char *STATE_FILE = nullptr;
+int STRIP_ROWS = 0;
+int ENSEMBLE_SIZE = 0;
+const char *ENSEMBLE_PATH = nullptr;
+int DEVICES = -1;
+int SUB_DEVICES = 0;
+int CHECKPOINT_EVERY = 0;
+const char *CHECKPOINT_PATH = "gol.checkpoint";
+const char *RESTORE_PATH = nullptr;
+const char *EXPORT_PATH = nullptr;
+FrameFormat EXPORT_FORMAT = FRAME_PPM;
+const char *TRACE_PATH = nullptr;
+bool PRINT_TIMING = false;
+int PIPELINE_DEPTH = 1;
+bool FUSED_PIXELS = false;
+int VIEW_WIDTH = 0;
+int VIEW_HEIGHT = 0;
+int CYCLE_WINDOW = 0;
+CycleAction CYCLE_ACTION = CYCLE_STOP;
+const char *STATS_PATH = nullptr;
+StatsFormat STATS_FORMAT = STATS_CSV;
+
+void buildCellPalette(unsigned char palette[PALETTE_SIZE][3]) {
+    for (int species = 0; species < PALETTE_SIZE; species++) {
+        for (int channel = 0; channel < 3; channel++) {
+            palette[species][channel] = static_cast<unsigned char>(CELL_COLOURS[species][channel] * 255.0f + 0.5f);
+        }
+    }
+}
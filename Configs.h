@@ -1,11 +1,92 @@
 #ifndef FINAL_PROJECT_CONFIGS_H
 #define FINAL_PROJECT_CONFIGS_H
 
+#include <cstdint>
+
+// Species ID of a cell, -1 for dead and 1 to 10 for the species.
+// 8 bits is plenty and keeps the bandwidth-bound update at a quarter of int storage.
+typedef int8_t cell_t;
+
 extern int NUMBER_OF_SPECIES;
 
 // Grid parameters
-constexpr int WIDTH = 1024;
-constexpr int HEIGHT = 768;
+extern int WIDTH;
+extern int HEIGHT;
+
+// Simulation engines, both produce identical grids
+enum Engine {
+    ENGINE_OPENCL,
+    ENGINE_CPU,
+    ENGINE_MULTI_DEVICE
+};
+
+// Frame export formats
+enum FrameFormat {
+    FRAME_PPM,      // Concatenated binary PPM images
+    FRAME_Y4M,      // YUV4MPEG2 video, 4:4:4
+    FRAME_DELTA     // Changed 32x32 tiles only
+};
+
+// Per-generation statistics formats
+enum StatsFormat {
+    STATS_CSV,      // One row per generation and species
+    STATS_BINARY    // Fixed-size records, see Stats.h
+};
+
+// What a headless run does once the grid repeats or dies out
+enum CycleAction {
+    CYCLE_STOP,     // End the run at the batch the cycle was found in
+    CYCLE_JUMP      // Skip whole periods and finish at the requested generation
+};
+
+// What cells past the grid edge count as
+enum Boundary {
+    BOUNDARY_DEAD,  // Always dead
+    BOUNDARY_TORUS  // The opposite edge, the grid wraps around
+};
+
+// Run parameters
+extern bool HEADLESS;               // Run without a window (no GLUT/OpenGL)
+extern int GENERATIONS;             // Number of generations to run, 0 = until the window is closed
+extern unsigned int SEED;           // Seed for the initial grid
+extern const char *PATTERN_PATH;    // RLE or plaintext pattern placed on a dead grid instead of seeding, nullptr = seed
+extern int PATTERN_X;               // Column of the pattern's top-left corner, -1 = centred
+extern int PATTERN_Y;               // Row of the pattern's top-left corner, -1 = centred
+extern int GENERATIONS_PER_FRAME;   // Generations computed on the device between frames
+extern Engine ENGINE;               // Engine used to compute generations
+extern unsigned int THREADS;        // Worker threads for the CPU engine, 0 = all hardware threads
+extern bool SIMD;                   // Use the vectorised CPU update when the processor supports it
+extern bool SPECIALISE;             // Build the OpenCL kernels for this run's grid size and species count
+extern bool BITBOARD;               // Use the bit-sliced per-species bitplane update
+extern bool TILED;                  // Use the local-memory tiled kernel with an autotuned work-group size
+extern bool RETUNE;                 // Ignore the cached work-group size and benchmark again
+extern bool ACTIVE_TILES;           // Only recompute tiles where something changed last generation
+extern bool PADDED;                 // Use the ghost-cell padded update, required by BOUNDARY_TORUS
+extern Boundary BOUNDARY;           // Grid edge behaviour
+extern const char *STATE_FILE;      // Memory-mapped state file for out-of-core runs, nullptr = in-core
+extern int STRIP_ROWS;              // Rows per out-of-core strip, 0 = pick from the grid width
+extern int ENSEMBLE_SIZE;           // Copies of the grid run as one ensemble with consecutive seeds, 0 = none
+extern const char *ENSEMBLE_PATH;   // Ensemble instance list (width height species seed per line), nullptr = none
+extern int DEVICES;                 // GPUs used by the multi-device engine, 0 = all, -1 = not given
+extern int SUB_DEVICES;             // CPU sub-devices used by the multi-device engine, 0 = none
+extern int CHECKPOINT_EVERY;        // Generations between background checkpoints, 0 = never
+extern const char *CHECKPOINT_PATH; // File checkpoints are written to
+extern const char *RESTORE_PATH;    // Checkpoint to resume from instead of seeding, nullptr = seed
+extern const char *EXPORT_PATH;     // File or named pipe frames are streamed to, nullptr = no export
+extern FrameFormat EXPORT_FORMAT;   // Encoding of exported frames
+extern const char *TRACE_PATH;      // Chrome trace written on exit and on 't', nullptr = no tracing
+extern bool PRINT_TIMING;           // Print kernel and host timings after every frame
+extern int PIPELINE_DEPTH;          // Frames in flight in the window, 1 = compute, colour and draw in turn
+extern bool FUSED_PIXELS;           // Colour each frame's last generation in the update kernel itself
+extern int VIEW_WIDTH;              // Window (and exported frame) width in pixels, 0 = the grid's width
+extern int VIEW_HEIGHT;             // Window (and exported frame) height in pixels, 0 = the grid's height
+extern int CYCLE_WINDOW;            // Generations of fingerprints kept for cycle detection, 0 = off
+extern CycleAction CYCLE_ACTION;    // What headless runs do once a cycle is found
+extern const char *STATS_PATH;      // File or named pipe per-generation statistics are streamed to, nullptr = none
+extern StatsFormat STATS_FORMAT;    // Encoding of the statistics
+
+// Upper bound for PIPELINE_DEPTH, one PBO and device buffer set per frame in flight
+constexpr int MAX_PIPELINE_DEPTH = 3;
 
 // Timing
 constexpr int FRAME_RATE = 30; // 30 FPS
@@ -26,4 +107,8 @@ constexpr float CELL_COLOURS[11][3] = {
         {0.55f, 0.00f, 0.00f}   // SPECIES 10: Dark red rgb(139,0,0);
 };
 
+// CELL_COLOURS as 8-bit RGB, index 0 is the dead colour and index N is species N
+constexpr int PALETTE_SIZE = 11;
+void buildCellPalette(unsigned char palette[PALETTE_SIZE][3]);
+
 #endif
@@ -0,0 +1,467 @@
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "CpuEngine.h"
+#include "Bitboard.h"
+#include "PaddedGrid.h"
+#include "ActiveTiles.h"
+#include "Rule.h"
+#include "CycleDetector.h"
+#include "Stats.h"
+#include "Configs.h"
+#include "Viewport.h"
+#include "ThreadPool.h"
+
+namespace {
+    std::unique_ptr<ThreadPool> pool;
+    std::vector<cell_t> nextGrid;   // Ping-pong partner of the caller's grid
+    std::vector<uint64_t> planes;   // Bitplanes for the bitboard update
+    std::vector<uint64_t> nextPlanes;
+    std::vector<cell_t> paddedGrid;     // Ghost-bordered grids for the padded update
+    std::vector<cell_t> nextPaddedGrid;
+    bool useSimd = false;
+
+    std::vector<uint8_t> tileChanged;       // Per-tile "changed last generation" flags
+    std::vector<uint8_t> nextTileChanged;
+    std::vector<int> activeTiles;
+
+    std::vector<uint16_t> ruleSums;         // Padded first-pass sums for the generalised rule
+    std::vector<uint16_t> ruleCounts;       // Per-species neighbour counts
+
+    std::vector<ViewTexel> pyramid;         // Mip levels 1..pyramidLevels(), see Viewport.h
+
+    // Rows per task: small enough for stealing to balance, big enough to amortise scheduling
+    constexpr int BAND_HEIGHT = 16;
+
+    int bandCount(int height) {
+        return (height + BAND_HEIGHT - 1) / BAND_HEIGHT;
+    }
+}
+
+cell_t cpuNextCellState(const cell_t *current, int width, int height, int numSpecies, int x, int y) {
+    int cellIndex = y * width + x;
+    int currentCellSpecies = current[cellIndex];
+
+    if (currentCellSpecies != -1) {
+        // Cell is alive - count neighbours of the same species
+        int count = 0;
+        for (int ny = y - 1; ny <= y + 1; ny++) {
+            if (ny < 0 || ny >= height) continue;
+            for (int nx = x - 1; nx <= x + 1; nx++) {
+                if (nx < 0 || nx >= width || (nx == x && ny == y)) continue;
+                if (current[ny * width + nx] == currentCellSpecies) count++;
+            }
+        }
+        if (count < 2 || count > 3) {
+            return -1;   // Death, speciesID = -1 (N/A)
+        }
+        return static_cast<cell_t>(currentCellSpecies);
+    }
+
+    // Cell is dead - check for birth
+    int speciesCount[10] = {0};
+    for (int ny = y - 1; ny <= y + 1; ny++) {
+        if (ny < 0 || ny >= height) continue;
+        for (int nx = x - 1; nx <= x + 1; nx++) {
+            if (nx < 0 || nx >= width || (nx == x && ny == y)) continue;
+            int speciesID = current[ny * width + nx];
+            if (speciesID > 0) speciesCount[speciesID - 1]++;
+        }
+    }
+
+    int reproductionConditionMet[10];
+    int numCandidates = 0;
+    for (int i = 0; i < numSpecies; i++) {
+        if (speciesCount[i] == 3) {
+            reproductionConditionMet[numCandidates++] = i + 1;
+        }
+    }
+
+    // Same PCG tie-break as the kernel, keyed on the cell index
+    if (numCandidates > 0) {
+        uint32_t hash = pcgHash(static_cast<uint32_t>(cellIndex));
+        return static_cast<cell_t>(reproductionConditionMet[hash % numCandidates]);
+    }
+    return -1;
+}
+
+void cpuGameOfLifeRect(const cell_t *current, cell_t *next, int width, int height,
+                       int numSpecies, int xBegin, int xEnd, int rowBegin, int rowEnd) {
+    for (int y = rowBegin; y < rowEnd; y++) {
+        for (int x = xBegin; x < xEnd; x++) {
+            next[y * width + x] = cpuNextCellState(current, width, height, numSpecies, x, y);
+        }
+    }
+}
+
+void cpuGameOfLifeRows(const cell_t *current, cell_t *next, int width, int height,
+                       int numSpecies, int rowBegin, int rowEnd) {
+    cpuGameOfLifeRect(current, next, width, height, numSpecies, 0, width, rowBegin, rowEnd);
+}
+
+void initialiseCpuEngine(unsigned int threadCount) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    pool = std::make_unique<ThreadPool>(threadCount);
+    useSimd = SIMD && cpuSimdAvailable();
+
+    const char *update = BITBOARD ? "bitboard" : PADDED ? "padded" : (useSimd ? cpuSimdName() : "scalar");
+    std::cout << "CPU engine initialized with " << threadCount << " threads ("
+              << update << " update)!" << std::endl;
+}
+
+void cleanupCpuEngine() {
+    pool.reset();
+}
+
+void cpuBitboardStepGenerations(std::vector<cell_t> &grid, int count) {
+    size_t planeWords = bitboardPlaneSize(WIDTH, HEIGHT) * NUMBER_OF_SPECIES;
+    planes.resize(planeWords);
+    nextPlanes.resize(planeWords);
+
+    // Packing is paid once per batch, generations in between stay bit-sliced
+    pool->parallelFor(bandCount(HEIGHT), [&](int band) {
+        int rowBegin = band * BAND_HEIGHT;
+        int rowEnd = std::min(rowBegin + BAND_HEIGHT, HEIGHT);
+        packBitplanes(grid.data(), planes.data(), WIDTH, HEIGHT, NUMBER_OF_SPECIES, rowBegin, rowEnd);
+    });
+
+    for (int generation = 0; generation < count; generation++) {
+        const uint64_t *current = planes.data();
+        uint64_t *next = nextPlanes.data();
+
+        pool->parallelFor(bandCount(HEIGHT), [&](int band) {
+            int rowBegin = band * BAND_HEIGHT;
+            int rowEnd = std::min(rowBegin + BAND_HEIGHT, HEIGHT);
+            bitboardGameOfLifeRows(current, next, WIDTH, HEIGHT, NUMBER_OF_SPECIES, rowBegin, rowEnd);
+        });
+
+        std::swap(planes, nextPlanes);
+    }
+
+    pool->parallelFor(bandCount(HEIGHT), [&](int band) {
+        int rowBegin = band * BAND_HEIGHT;
+        int rowEnd = std::min(rowBegin + BAND_HEIGHT, HEIGHT);
+        unpackBitplanes(planes.data(), grid.data(), WIDTH, HEIGHT, NUMBER_OF_SPECIES, rowBegin, rowEnd);
+    });
+}
+
+void cpuPaddedStepGenerations(std::vector<cell_t> &grid, int count) {
+    paddedGrid.resize(paddedSize(WIDTH, HEIGHT));
+    nextPaddedGrid.resize(paddedSize(WIDTH, HEIGHT));
+
+    // Padding is paid once per batch, like the bitboard packing
+    pool->parallelFor(bandCount(HEIGHT), [&](int band) {
+        int rowBegin = band * BAND_HEIGHT;
+        int rowEnd = std::min(rowBegin + BAND_HEIGHT, HEIGHT);
+        padGrid(grid.data(), paddedGrid.data(), WIDTH, rowBegin, rowEnd);
+    });
+
+    // The update never writes the border, so a dead one only needs filling once per buffer
+    fillGhostCells(paddedGrid.data(), WIDTH, HEIGHT, BOUNDARY_DEAD);
+    fillGhostCells(nextPaddedGrid.data(), WIDTH, HEIGHT, BOUNDARY_DEAD);
+
+    for (int generation = 0; generation < count; generation++) {
+        if (BOUNDARY == BOUNDARY_TORUS) {
+            fillGhostCells(paddedGrid.data(), WIDTH, HEIGHT, BOUNDARY_TORUS);
+        }
+
+        const cell_t *current = paddedGrid.data();
+        cell_t *next = nextPaddedGrid.data();
+        pool->parallelFor(bandCount(HEIGHT), [&](int band) {
+            int rowBegin = band * BAND_HEIGHT;
+            int rowEnd = std::min(rowBegin + BAND_HEIGHT, HEIGHT);
+            if (useSimd) {
+                cpuPaddedGameOfLifeRowsSimd(current, next, WIDTH, NUMBER_OF_SPECIES, rowBegin, rowEnd);
+            }
+            else {
+                paddedGameOfLifeRows(current, next, WIDTH, NUMBER_OF_SPECIES, rowBegin, rowEnd);
+            }
+        });
+
+        std::swap(paddedGrid, nextPaddedGrid);
+    }
+
+    pool->parallelFor(bandCount(HEIGHT), [&](int band) {
+        int rowBegin = band * BAND_HEIGHT;
+        int rowEnd = std::min(rowBegin + BAND_HEIGHT, HEIGHT);
+        unpadGrid(paddedGrid.data(), grid.data(), WIDTH, rowBegin, rowEnd);
+    });
+}
+
+void cpuResetActiveTiles() {
+    // Every tile is scheduled until the grid has been stepped once
+    tileChanged.assign(static_cast<size_t>(activeTilesX(WIDTH)) * activeTilesY(HEIGHT), 1);
+}
+
+void cpuActiveTileStepGenerations(std::vector<cell_t> &grid, int count) {
+    int tilesX = activeTilesX(WIDTH);
+    int tilesY = activeTilesY(HEIGHT);
+    if (tileChanged.size() != static_cast<size_t>(tilesX) * tilesY) cpuResetActiveTiles();
+    nextTileChanged.resize(tileChanged.size());
+
+    // A fresh partner buffer has no valid history, every tile has to run once
+    if (nextGrid.size() != grid.size()) {
+        nextGrid.resize(grid.size());
+        cpuResetActiveTiles();
+    }
+
+    for (int generation = 0; generation < count; generation++) {
+        const cell_t *current = grid.data();
+        cell_t *next = nextGrid.data();
+
+        buildActiveTileList(tileChanged, tilesX, tilesY, activeTiles);
+        std::fill(nextTileChanged.begin(), nextTileChanged.end(), 0);
+
+        pool->parallelFor(static_cast<int>(activeTiles.size()), [&](int task) {
+            int tile = activeTiles[task];
+            int xBegin = (tile % tilesX) * ACTIVE_TILE_WIDTH;
+            int yBegin = (tile / tilesX) * ACTIVE_TILE_HEIGHT;
+            int xEnd = std::min(xBegin + ACTIVE_TILE_WIDTH, WIDTH);
+            int yEnd = std::min(yBegin + ACTIVE_TILE_HEIGHT, HEIGHT);
+
+            if (useSimd) {
+                cpuGameOfLifeRectSimd(current, next, WIDTH, HEIGHT, NUMBER_OF_SPECIES, xBegin, xEnd, yBegin, yEnd);
+            }
+            else {
+                cpuGameOfLifeRect(current, next, WIDTH, HEIGHT, NUMBER_OF_SPECIES, xBegin, xEnd, yBegin, yEnd);
+            }
+
+            bool changed = false;
+            for (int y = yBegin; y < yEnd && !changed; y++) {
+                changed = !std::equal(current + y * WIDTH + xBegin, current + y * WIDTH + xEnd, next + y * WIDTH + xBegin);
+            }
+            nextTileChanged[tile] = changed;
+        });
+
+        std::swap(grid, nextGrid);
+        std::swap(tileChanged, nextTileChanged);
+    }
+}
+
+void cpuRuleStepGenerations(std::vector<cell_t> &grid, int count) {
+    int padding = ruleCountPadding(RULE);
+    int sumsWidth = WIDTH + 2 * padding;
+    int sumsHeight = HEIGHT + 2 * padding;
+    size_t sumsPlaneSize = static_cast<size_t>(sumsWidth) * sumsHeight;
+    size_t planeSize = static_cast<size_t>(WIDTH) * HEIGHT;
+    std::vector<RuleCountPass> passes = ruleCountPasses(RULE);
+
+    ruleSums.resize(sumsPlaneSize * NUMBER_OF_SPECIES);
+    ruleCounts.resize(planeSize * NUMBER_OF_SPECIES);
+    nextGrid.resize(grid.size());
+
+    for (int generation = 0; generation < count; generation++) {
+        const cell_t *current = grid.data();
+        cell_t *next = nextGrid.data();
+
+        // Every line is one task, each walks its line with a sliding window
+        for (const RuleCountPass &pass : passes) {
+            int firstLines = ruleLineCount(sumsWidth, sumsHeight, pass.firstDx, pass.firstDy);
+            pool->parallelFor(firstLines, [&](int line) {
+                ruleSpeciesLineSums(current, WIDTH, HEIGHT, NUMBER_OF_SPECIES, padding,
+                                    pass.firstDx, pass.firstDy, pass.lo, pass.hi, ruleSums.data(), line);
+            });
+
+            int secondLines = ruleLineCount(WIDTH, HEIGHT, pass.secondDx, pass.secondDy);
+            pool->parallelFor(secondLines * NUMBER_OF_SPECIES, [&](int task) {
+                int species = task / secondLines;
+                rulePlaneLineSums(ruleSums.data() + species * sumsPlaneSize, WIDTH, HEIGHT, padding,
+                                  pass.secondDx, pass.secondDy, pass.lo, pass.hi, pass.shiftX, pass.accumulate,
+                                  ruleCounts.data() + species * planeSize, task % secondLines);
+            });
+        }
+
+        pool->parallelFor(bandCount(HEIGHT), [&](int band) {
+            int rowBegin = band * BAND_HEIGHT;
+            int rowEnd = std::min(rowBegin + BAND_HEIGHT, HEIGHT);
+            for (int cellIndex = rowBegin * WIDTH; cellIndex < rowEnd * WIDTH; cellIndex++) {
+                next[cellIndex] = ruleNextCellState(RULE, current, ruleCounts.data(), planeSize, NUMBER_OF_SPECIES, cellIndex);
+            }
+        });
+
+        std::swap(grid, nextGrid);
+    }
+}
+
+void cpuStepGenerations(std::vector<cell_t> &grid, int count) {
+    // Rules other than B3/S23 only have the generalised update
+    if (!isLifeRule(RULE)) {
+        cpuRuleStepGenerations(grid, count);
+        return;
+    }
+    if (BITBOARD) {
+        cpuBitboardStepGenerations(grid, count);
+        return;
+    }
+    if (ACTIVE_TILES) {
+        cpuActiveTileStepGenerations(grid, count);
+        return;
+    }
+    if (PADDED) {
+        cpuPaddedStepGenerations(grid, count);
+        return;
+    }
+
+    nextGrid.resize(grid.size());
+
+    for (int generation = 0; generation < count; generation++) {
+        const cell_t *current = grid.data();
+        cell_t *next = nextGrid.data();
+
+        // Each task is one band of rows, the pool steals bands between threads
+        pool->parallelFor(bandCount(HEIGHT), [&](int band) {
+            int rowBegin = band * BAND_HEIGHT;
+            int rowEnd = std::min(rowBegin + BAND_HEIGHT, HEIGHT);
+            if (useSimd) {
+                cpuGameOfLifeRowsSimd(current, next, WIDTH, HEIGHT, NUMBER_OF_SPECIES, rowBegin, rowEnd);
+            }
+            else {
+                cpuGameOfLifeRows(current, next, WIDTH, HEIGHT, NUMBER_OF_SPECIES, rowBegin, rowEnd);
+            }
+        });
+
+        std::swap(grid, nextGrid);
+    }
+}
+
+uint64_t cpuGridFingerprint(const std::vector<cell_t> &grid) {
+    // One partial per band, XOR doesn't care which order they are combined in
+    std::vector<uint64_t> partials(bandCount(HEIGHT));
+    pool->parallelFor(bandCount(HEIGHT), [&](int band) {
+        int rowBegin = band * BAND_HEIGHT;
+        int rowEnd = std::min(rowBegin + BAND_HEIGHT, HEIGHT);
+        uint64_t fingerprint = 0;
+        for (int cellIndex = rowBegin * WIDTH; cellIndex < rowEnd * WIDTH; cellIndex++) {
+            if (grid[cellIndex] != -1) fingerprint ^= cellFingerprint(static_cast<uint32_t>(cellIndex), grid[cellIndex]);
+        }
+        partials[band] = fingerprint;
+    });
+
+    uint64_t fingerprint = 0;
+    for (uint64_t partial : partials) fingerprint ^= partial;
+    return fingerprint;
+}
+
+void cpuGenerationStats(const std::vector<cell_t> &previous, const std::vector<cell_t> &current, uint32_t *slot) {
+    // One histogram per band, merged afterwards like the kernel's work-group histograms
+    std::vector<uint32_t> histograms(static_cast<size_t>(bandCount(HEIGHT)) * STATS_SLOT_SIZE, 0);
+    pool->parallelFor(bandCount(HEIGHT), [&](int band) {
+        uint32_t *histogram = histograms.data() + static_cast<size_t>(band) * STATS_SLOT_SIZE;
+        int rowBegin = band * BAND_HEIGHT;
+        int rowEnd = std::min(rowBegin + BAND_HEIGHT, HEIGHT);
+        for (int y = rowBegin; y < rowEnd; y++) {
+            for (int x = 0; x < WIDTH; x++) {
+                int before = previous[y * WIDTH + x];
+                int after = current[y * WIDTH + x];
+                if (after != -1) histogram[(after - 1) * STATS_FIELDS + STAT_POPULATION]++;
+                if (before != -1 && after == -1) histogram[(before - 1) * STATS_FIELDS + STAT_DEATHS]++;
+                if (before != -1 || after == -1) continue;
+
+                histogram[(after - 1) * STATS_FIELDS + STAT_BIRTHS]++;
+                int speciesCount[10] = {0};
+                for (int ny = y - 1; ny <= y + 1; ny++) {
+                    for (int nx = x - 1; nx <= x + 1; nx++) {
+                        int sx = BOUNDARY == BOUNDARY_TORUS ? (nx + WIDTH) % WIDTH : nx;
+                        int sy = BOUNDARY == BOUNDARY_TORUS ? (ny + HEIGHT) % HEIGHT : ny;
+                        if ((nx == x && ny == y) || sx < 0 || sx >= WIDTH || sy < 0 || sy >= HEIGHT) continue;
+                        int speciesID = previous[sy * WIDTH + sx];
+                        if (speciesID > 0) speciesCount[speciesID - 1]++;
+                    }
+                }
+                int numCandidates = static_cast<int>(std::count(speciesCount, speciesCount + NUMBER_OF_SPECIES, 3));
+                if (numCandidates > 1) histogram[(after - 1) * STATS_FIELDS + STAT_CONTESTED]++;
+            }
+        }
+    });
+
+    for (int band = 0; band < bandCount(HEIGHT); band++) {
+        for (int i = 0; i < STATS_SLOT_SIZE; i++) slot[i] += histograms[static_cast<size_t>(band) * STATS_SLOT_SIZE + i];
+    }
+}
+
+// Rebuild the pyramid texels the viewport shows, from level 1 up to its level
+void cpuDownsample(const std::vector<cell_t> &grid) {
+    int level = viewLevel(viewport);
+    if (level == 0) return;
+    pyramid.resize(pyramidSize());
+
+    for (int target = 1; target <= level; target++) {
+        LevelRect rect = viewLevelRect(viewport, target);
+        const ViewTexel *source = pyramid.data() + pyramidLevelOffset(target - 1);
+        ViewTexel *texels = pyramid.data() + pyramidLevelOffset(target);
+        int sourceWidth = levelWidth(target - 1);
+        int sourceHeight = levelHeight(target - 1);
+        int targetWidth = levelWidth(target);
+
+        pool->parallelFor(bandCount(rect.y1 - rect.y0), [&](int band) {
+            int rowBegin = rect.y0 + band * BAND_HEIGHT;
+            int rowEnd = std::min(rowBegin + BAND_HEIGHT, rect.y1);
+            for (int y = rowBegin; y < rowEnd; y++) {
+                for (int x = rect.x0; x < rect.x1; x++) {
+                    ViewTexel children[4] = {};
+                    int count = 0;
+                    for (int dy = 0; dy < 2; dy++) {
+                        for (int dx = 0; dx < 2; dx++) {
+                            int sx = 2 * x + dx;
+                            int sy = 2 * y + dy;
+                            if (sx >= sourceWidth || sy >= sourceHeight) continue;
+                            int sourceIndex = sy * sourceWidth + sx;
+                            children[count++] = target == 1 ? cellTexel(grid[sourceIndex]) : source[sourceIndex];
+                        }
+                    }
+                    texels[y * targetWidth + x] = reduceTexels(children, count);
+                }
+            }
+        });
+    }
+}
+
+void cpuWritePixels(const std::vector<cell_t> &grid, unsigned char *pixels) {
+    unsigned char palette[PALETTE_SIZE][3];
+    buildCellPalette(palette);
+    cpuDownsample(grid);
+
+    int viewW = viewWidth();
+    int viewH = viewHeight();
+    int level = viewLevel(viewport);
+    const ViewTexel *texels = level > 0 ? pyramid.data() + pyramidLevelOffset(level) : nullptr;
+    int levelW = levelWidth(level);
+    int levelH = levelHeight(level);
+    int originX, originY;
+    viewOrigin(viewport, originX, originY);
+    int magnify = std::max(viewport.zoom, 0);
+
+    pool->parallelFor(bandCount(viewH), [&](int band) {
+        int rowBegin = band * BAND_HEIGHT;
+        int rowEnd = std::min(rowBegin + BAND_HEIGHT, viewH);
+        for (int y = rowBegin; y < rowEnd; y++) {
+            for (int x = 0; x < viewW; x++) {
+                int texelX = originX + (x >> magnify);
+                int texelY = originY + (y >> magnify);
+                unsigned char *pixel = pixels + (static_cast<size_t>(y) * viewW + x) * 3;
+                if (texelX < 0 || texelX >= levelW || texelY < 0 || texelY >= levelH) {
+                    pixel[0] = OUTSIDE_COLOUR[0]; pixel[1] = OUTSIDE_COLOUR[1]; pixel[2] = OUTSIDE_COLOUR[2];
+                    continue;
+                }
+                if (level > 0) {
+                    texelColour(palette, texels[texelY * levelW + texelX], pixel);
+                    continue;
+                }
+
+                int speciesID = grid[texelY * WIDTH + texelX];
+                int paletteIndex = speciesID == -1 ? 0 : speciesID;
+                if (paletteIndex < 0 || paletteIndex >= PALETTE_SIZE) {
+                    pixel[0] = 255; pixel[1] = 0; pixel[2] = 255;   // ERROR: Magenta
+                    continue;
+                }
+                pixel[0] = palette[paletteIndex][0];
+                pixel[1] = palette[paletteIndex][1];
+                pixel[2] = palette[paletteIndex][2];
+            }
+        }
+    });
+}
@@ -0,0 +1,64 @@
+#ifndef FINAL_PROJECT_CPUENGINE_H
+#define FINAL_PROJECT_CPUENGINE_H
+
+#include <cstdint>
+#include <vector>
+
+#include "Configs.h"
+
+// Native multithreaded implementation of the gameOfLife kernel in KernelSource.h.
+// Produces bit-identical grids to the OpenCL path, so either engine can be
+// swapped in mid-run without changing results.
+
+// 32-bit PCG hash used to break ties between species competing for a birth
+inline uint32_t pcgHash(uint32_t seed) {
+    uint32_t state = seed * 747796405u + 2891336453u;
+    uint32_t word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+    return (word >> 22u) ^ word;
+}
+
+// Next state of the cell at (x, y), handles cells on the grid edge
+cell_t cpuNextCellState(const cell_t *current, int width, int height, int numSpecies, int x, int y);
+
+// Apply one generation of the multispecies rule to rows [rowBegin, rowEnd)
+void cpuGameOfLifeRows(const cell_t *current, cell_t *next, int width, int height,
+                       int numSpecies, int rowBegin, int rowEnd);
+
+// Apply one generation to the cells in columns [xBegin, xEnd) of rows [rowBegin, rowEnd)
+void cpuGameOfLifeRect(const cell_t *current, cell_t *next, int width, int height,
+                       int numSpecies, int xBegin, int xEnd, int rowBegin, int rowEnd);
+
+// Vectorised versions of the above, only valid when cpuSimdAvailable()
+void cpuGameOfLifeRowsSimd(const cell_t *current, cell_t *next, int width, int height,
+                           int numSpecies, int rowBegin, int rowEnd);
+void cpuGameOfLifeRectSimd(const cell_t *current, cell_t *next, int width, int height,
+                           int numSpecies, int xBegin, int xEnd, int rowBegin, int rowEnd);
+// Vectorised paddedGameOfLifeRows, every cell has its 8 neighbours so no row or column falls back
+void cpuPaddedGameOfLifeRowsSimd(const cell_t *current, cell_t *next, int width,
+                                 int numSpecies, int rowBegin, int rowEnd);
+
+// Runtime CPU detection for the vectorised update
+bool cpuSimdAvailable();
+const char *cpuSimdName();
+
+// Create the worker pool, threadCount = 0 uses every hardware thread
+void initialiseCpuEngine(unsigned int threadCount);
+void cleanupCpuEngine();
+
+// The grid was changed outside the engine, schedule every tile again
+void cpuResetActiveTiles();
+
+// Advance grid by count generations in place
+void cpuStepGenerations(std::vector<cell_t> &grid, int count);
+
+// XOR of cellFingerprint() over the live cells, see CycleDetector.h
+uint64_t cpuGridFingerprint(const std::vector<cell_t> &grid);
+
+// Accumulate the statistics of the step from previous to current into slot, see Stats.h
+void cpuGenerationStats(const std::vector<cell_t> &previous, const std::vector<cell_t> &current, uint32_t *slot);
+
+// Colour the viewport of grid into an RGB buffer with the same layout and
+// texels as writeViewport, viewWidth() x viewHeight() pixels
+void cpuWritePixels(const std::vector<cell_t> &grid, unsigned char *pixels);
+
+#endif
@@ -0,0 +1,251 @@
+#include <algorithm>
+
+#include "CpuEngine.h"
+#include "PaddedGrid.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CPU_ENGINE_AVX2 1
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define CPU_ENGINE_NEON 1
+#endif
+
+// Vectorised interior update. Each lane holds one 8-bit cell, so one compare
+// handles 32 cells (AVX2) and every neighbour/species count is built from
+// byte compares: a match is -1 (0xFF), so subtracting the mask counts up.
+// Cells on the grid edge and dead cells where two species tie for a birth
+// (at most two species can reach 3 of the 8 neighbours) fall back to the
+// scalar update, which applies the kernel's PCG tie-break. Padded grids are
+// updated by the same blocks with width set to the padded pitch.
+
+namespace {
+
+// Scalar state of a tied birth at (x, y). For padded grids width and height include the border,
+// and the tie-break is keyed on the unpadded index like paddedGameOfLifeRows.
+inline cell_t tiedCellState(const cell_t *current, int width, int height, int numSpecies, int x, int y, bool padded) {
+    if (padded) return paddedNextCellState(current, width - 2, numSpecies, x - 1, y - 1);
+    return cpuNextCellState(current, width, height, numSpecies, x, y);
+}
+
+#if CPU_ENGINE_AVX2
+
+// Update the 32 cells starting at (x, y), all of which must have 8 in-grid neighbours
+__attribute__((target("avx2")))
+void updateBlock32(const cell_t *current, cell_t *next, int width, int height,
+                   int numSpecies, int y, int x, bool padded) {
+    const cell_t *above = current + (y - 1) * width;
+    const cell_t *row = current + y * width;
+    const cell_t *below = current + (y + 1) * width;
+
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i dead = _mm256_set1_epi8(-1);
+    const __m256i one = _mm256_set1_epi8(1);
+    const __m256i two = _mm256_set1_epi8(2);
+    const __m256i three = _mm256_set1_epi8(3);
+
+    {
+        const __m256i neighbours[8] = {
+                _mm256_loadu_si256((const __m256i *)(above + x - 1)),
+                _mm256_loadu_si256((const __m256i *)(above + x)),
+                _mm256_loadu_si256((const __m256i *)(above + x + 1)),
+                _mm256_loadu_si256((const __m256i *)(row + x - 1)),
+                _mm256_loadu_si256((const __m256i *)(row + x + 1)),
+                _mm256_loadu_si256((const __m256i *)(below + x - 1)),
+                _mm256_loadu_si256((const __m256i *)(below + x)),
+                _mm256_loadu_si256((const __m256i *)(below + x + 1))
+        };
+        const __m256i centre = _mm256_loadu_si256((const __m256i *)(row + x));
+
+        // Live cells survive with 2 or 3 neighbours of their own species
+        __m256i same = zero;
+        for (const __m256i &neighbour : neighbours) {
+            same = _mm256_sub_epi8(same, _mm256_cmpeq_epi8(neighbour, centre));
+        }
+        __m256i survives = _mm256_or_si256(_mm256_cmpeq_epi8(same, two), _mm256_cmpeq_epi8(same, three));
+        __m256i liveResult = _mm256_blendv_epi8(dead, centre, survives);
+
+        // Dead cells are born into a species with exactly 3 neighbours
+        __m256i candidates = zero;
+        __m256i selected = dead;
+        for (int species = 1; species <= numSpecies; species++) {
+            const __m256i speciesID = _mm256_set1_epi8(static_cast<char>(species));
+            __m256i count = zero;
+            for (const __m256i &neighbour : neighbours) {
+                count = _mm256_sub_epi8(count, _mm256_cmpeq_epi8(neighbour, speciesID));
+            }
+            __m256i reproduces = _mm256_cmpeq_epi8(count, three);
+            candidates = _mm256_sub_epi8(candidates, reproduces);
+            selected = _mm256_blendv_epi8(selected, speciesID, reproduces);
+        }
+
+        __m256i isDead = _mm256_cmpeq_epi8(centre, dead);
+        __m256i result = _mm256_blendv_epi8(liveResult, selected, isDead);
+        _mm256_storeu_si256((__m256i *)(next + y * width + x), result);
+
+        // Redo tied births with the scalar PCG tie-break
+        __m256i tied = _mm256_and_si256(isDead, _mm256_cmpgt_epi8(candidates, one));
+        uint32_t tiedLanes = static_cast<uint32_t>(_mm256_movemask_epi8(tied));
+        while (tiedLanes) {
+            int lane = __builtin_ctz(tiedLanes);
+            next[y * width + x + lane] = tiedCellState(current, width, height, numSpecies, x + lane, y, padded);
+            tiedLanes &= tiedLanes - 1;
+        }
+    }
+}
+
+#elif CPU_ENGINE_NEON
+
+// 16 cells per NEON register, called twice per iteration to cover 32 cells
+inline void updateBlock16(const cell_t *current, cell_t *next, int width, int height,
+                          int numSpecies, int y, int x, bool padded) {
+    const cell_t *above = current + (y - 1) * width;
+    const cell_t *row = current + y * width;
+    const cell_t *below = current + (y + 1) * width;
+
+    const uint8x16_t zero = vdupq_n_u8(0);
+    const int8x16_t dead = vdupq_n_s8(-1);
+
+    const int8x16_t neighbours[8] = {
+            vld1q_s8(above + x - 1), vld1q_s8(above + x), vld1q_s8(above + x + 1),
+            vld1q_s8(row + x - 1), vld1q_s8(row + x + 1),
+            vld1q_s8(below + x - 1), vld1q_s8(below + x), vld1q_s8(below + x + 1)
+    };
+    const int8x16_t centre = vld1q_s8(row + x);
+
+    // Live cells survive with 2 or 3 neighbours of their own species
+    uint8x16_t same = zero;
+    for (const int8x16_t &neighbour : neighbours) {
+        same = vsubq_u8(same, vceqq_s8(neighbour, centre));
+    }
+    uint8x16_t survives = vorrq_u8(vceqq_u8(same, vdupq_n_u8(2)), vceqq_u8(same, vdupq_n_u8(3)));
+    int8x16_t liveResult = vbslq_s8(survives, centre, dead);
+
+    // Dead cells are born into a species with exactly 3 neighbours
+    uint8x16_t candidates = zero;
+    int8x16_t selected = dead;
+    for (int species = 1; species <= numSpecies; species++) {
+        const int8x16_t speciesID = vdupq_n_s8(static_cast<int8_t>(species));
+        uint8x16_t count = zero;
+        for (const int8x16_t &neighbour : neighbours) {
+            count = vsubq_u8(count, vceqq_s8(neighbour, speciesID));
+        }
+        uint8x16_t reproduces = vceqq_u8(count, vdupq_n_u8(3));
+        candidates = vsubq_u8(candidates, reproduces);
+        selected = vbslq_s8(reproduces, speciesID, selected);
+    }
+
+    uint8x16_t isDead = vceqq_s8(centre, dead);
+    vst1q_s8(next + y * width + x, vbslq_s8(isDead, selected, liveResult));
+
+    // Redo tied births with the scalar PCG tie-break
+    uint8x16_t tied = vandq_u8(isDead, vcgtq_u8(candidates, vdupq_n_u8(1)));
+    if (vmaxvq_u8(tied)) {
+        uint8_t tiedLanes[16];
+        vst1q_u8(tiedLanes, tied);
+        for (int lane = 0; lane < 16; lane++) {
+            if (tiedLanes[lane]) {
+                next[y * width + x + lane] = tiedCellState(current, width, height, numSpecies, x + lane, y, padded);
+            }
+        }
+    }
+}
+
+void updateBlock32(const cell_t *current, cell_t *next, int width, int height,
+                   int numSpecies, int y, int x, bool padded) {
+    updateBlock16(current, next, width, height, numSpecies, y, x, padded);
+    updateBlock16(current, next, width, height, numSpecies, y, x + 16, padded);
+}
+
+#endif
+
+#if CPU_ENGINE_AVX2 || CPU_ENGINE_NEON
+
+// Update interior columns [xBegin, xEnd) of row y, returns the first column left for the scalar update
+int updateRowInterior(const cell_t *current, cell_t *next, int width, int height,
+                      int numSpecies, int y, int xBegin, int xEnd, bool padded) {
+    if (xEnd - xBegin < 32) return xBegin;
+
+    int x = xBegin;
+    for (; x + 32 <= xEnd; x += 32) {
+        updateBlock32(current, next, width, height, numSpecies, y, x, padded);
+    }
+
+    // Overlap the last block with the previous one rather than finishing with
+    // scalar cells, recomputing a cell from the current grid is harmless
+    if (x < xEnd) {
+        updateBlock32(current, next, width, height, numSpecies, y, xEnd - 32, padded);
+    }
+    return xEnd;
+}
+
+#else
+
+int updateRowInterior(const cell_t *, cell_t *, int, int, int, int, int xBegin, int, bool) {
+    return xBegin;
+}
+
+#endif
+
+}
+
+bool cpuSimdAvailable() {
+#if CPU_ENGINE_AVX2
+    return __builtin_cpu_supports("avx2");
+#elif CPU_ENGINE_NEON
+    return true;    // NEON is mandatory on ARM64
+#else
+    return false;
+#endif
+}
+
+const char *cpuSimdName() {
+#if CPU_ENGINE_AVX2
+    return "AVX2";
+#elif CPU_ENGINE_NEON
+    return "NEON";
+#else
+    return "scalar";
+#endif
+}
+
+void cpuGameOfLifeRectSimd(const cell_t *current, cell_t *next, int width, int height,
+                           int numSpecies, int xBegin, int xEnd, int rowBegin, int rowEnd) {
+    for (int y = rowBegin; y < rowEnd; y++) {
+        // Top and bottom rows have missing neighbours, use the scalar update
+        if (y == 0 || y == height - 1) {
+            cpuGameOfLifeRect(current, next, width, height, numSpecies, xBegin, xEnd, y, y + 1);
+            continue;
+        }
+
+        // Left and right edge columns also use the scalar update
+        int x = xBegin;
+        if (x == 0) {
+            next[y * width] = cpuNextCellState(current, width, height, numSpecies, 0, y);
+            x = 1;
+        }
+        x = updateRowInterior(current, next, width, height, numSpecies, y, x, std::min(xEnd, width - 1), false);
+
+        for (; x < xEnd; x++) {
+            next[y * width + x] = cpuNextCellState(current, width, height, numSpecies, x, y);
+        }
+    }
+}
+
+void cpuGameOfLifeRowsSimd(const cell_t *current, cell_t *next, int width, int height,
+                           int numSpecies, int rowBegin, int rowEnd) {
+    cpuGameOfLifeRectSimd(current, next, width, height, numSpecies, 0, width, rowBegin, rowEnd);
+}
+
+void cpuPaddedGameOfLifeRowsSimd(const cell_t *current, cell_t *next, int width,
+                                 int numSpecies, int rowBegin, int rowEnd) {
+    int pitch = paddedPitch(width);
+    for (int y = rowBegin; y < rowEnd; y++) {
+        // Padded columns [1, width + 1) of padded row y + 1, only grids narrower than a block stay scalar.
+        // The height is only read by the unpadded tie-break.
+        int x = updateRowInterior(current, next, pitch, 0, numSpecies, y + 1, 1, width + 1, true);
+        for (; x < width + 1; x++) {
+            next[static_cast<size_t>(y + 1) * pitch + x] = paddedNextCellState(current, width, numSpecies, x - 1, y);
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#include "CycleDetector.h"
+
+CycleDetector::CycleDetector(int window) : window(window), history(window) {
+    lastSeen.reserve(window);
+}
+
+bool CycleDetector::record(uint64_t generation, uint64_t fingerprint) {
+    if (found) return true;
+
+    // Nothing alive, nothing can change again
+    if (fingerprint == 0) {
+        found = diedOut = true;
+        cycleStart = generation;
+        cyclePeriod = 1;
+        return true;
+    }
+
+    auto seen = lastSeen.find(fingerprint);
+    if (seen != lastSeen.end()) {
+        found = true;
+        cycleStart = seen->second;
+        cyclePeriod = generation - seen->second;
+        return true;
+    }
+
+    // Forget the fingerprint leaving the window, unless it was seen again since
+    uint64_t &slot = history[recorded % window];
+    if (recorded >= static_cast<uint64_t>(window)) {
+        auto leaving = lastSeen.find(slot);
+        if (leaving != lastSeen.end() && leaving->second + window <= generation) lastSeen.erase(leaving);
+    }
+    slot = fingerprint;
+    lastSeen[fingerprint] = generation;
+    recorded++;
+    return false;
+}
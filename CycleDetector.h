@@ -0,0 +1,53 @@
+#ifndef FINAL_PROJECT_CYCLEDETECTOR_H
+#define FINAL_PROJECT_CYCLEDETECTOR_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "Configs.h"
+
+// Steady-state detection from per-generation grid fingerprints. A fingerprint
+// is the XOR over live cells of a 64-bit mix of (cell index, species), a
+// Zobrist hash with the random table replaced by a hash function, so it can be
+// reduced in any order on the device and an empty grid fingerprints to 0.
+
+// Zobrist key of a live cell, the splitmix64 finaliser. Matches cellFingerprint in KernelSource.h.
+inline uint64_t cellFingerprint(uint32_t cellIndex, int species) {
+    uint64_t z = ((static_cast<uint64_t>(cellIndex) << 4) | static_cast<uint64_t>(species)) + 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Work-groups and work-items per group of the gridFingerprint kernel, one partial per group
+constexpr int FINGERPRINT_GROUPS = 64;
+constexpr int FINGERPRINT_LOCAL_SIZE = 128;
+
+// Remembers the fingerprints of the last window generations. Fed every
+// generation in order, the first repeat found is the start of the cycle, so
+// the transient and period are exact for any period up to the window.
+class CycleDetector {
+public:
+    explicit CycleDetector(int window);
+
+    // Record the fingerprint of generation, true once the grid has repeated or died out
+    bool record(uint64_t generation, uint64_t fingerprint);
+
+    bool detected() const { return found; }
+    bool extinct() const { return diedOut; }
+    uint64_t transient() const { return cycleStart; }   // First generation of the cycle
+    uint64_t period() const { return cyclePeriod; }     // 1 for still lifes and extinction
+
+private:
+    int window;
+    std::vector<uint64_t> history;                      // Ring of the last window fingerprints
+    std::unordered_map<uint64_t, uint64_t> lastSeen;    // Fingerprint -> generation, for the ring's entries
+    uint64_t recorded = 0;
+    bool found = false;
+    bool diedOut = false;
+    uint64_t cycleStart = 0;
+    uint64_t cyclePeriod = 0;
+};
+
+#endif
@@ -0,0 +1,1316 @@
+#include <iostream>
+#include <memory>
+#include <algorithm>
+#include <string>
+
+#include "Engine.h"
+#include "CpuEngine.h"
+#include "Bitboard.h"
+#include "PaddedGrid.h"
+#include "Autotune.h"
+#include "ActiveTiles.h"
+#include "MultiDevice.h"
+#include "ProgramCache.h"
+#include "CycleDetector.h"
+#include "Stats.h"
+#include "Seeding.h"
+#include "Pattern.h"
+#include "Rule.h"
+#include "Viewport.h"
+#include "Trace.h"
+#include "KernelSource.h"
+
+// ----------- OPENCL ----------- //
+cl_device_id device_id;
+cl_context context;
+cl_command_queue gpu_commands;
+cl_command_queue cpu_commands;
+cl_program gpu_program;
+cl_program cpu_program;
+cl_kernel grid_update_kernel;
+cl_kernel pixels_update_kernel;
+cl_mem grid_mem;
+cl_mem grid_cpu_mem[MAX_PIPELINE_DEPTH];        // Grid snapshot per frame in flight
+cl_mem next_grid_mem;
+cl_mem cpu_pixel_buffer_mem[MAX_PIPELINE_DEPTH];
+cl_mem palette_mem;             // buildCellPalette() colours, shared by both colouring kernels
+
+// Update that also colours the last generation of a frame
+cl_kernel fused_update_kernel;
+
+// Generalised rule update, only allocated for rules other than B3/S23
+cl_kernel rule_species_sums_kernel;
+cl_kernel rule_plane_sums_kernel;
+cl_kernel apply_rule_kernel;
+cl_mem rule_sums_mem;
+cl_mem rule_counts_mem;
+cl_mem rule_birth_mem;
+cl_mem rule_survival_mem;
+
+// Bitboard variant of the grid update
+cl_kernel pack_bitplanes_kernel;
+cl_kernel unpack_bitplanes_kernel;
+cl_kernel bitboard_update_kernel;
+cl_mem planes_mem;
+cl_mem next_planes_mem;
+
+// Ghost-cell padded variant of the grid update
+cl_kernel pad_grid_kernel;
+cl_kernel unpad_grid_kernel;
+cl_kernel fill_ghost_cells_kernel;
+cl_kernel padded_update_kernel;
+cl_mem padded_grid_mem;
+cl_mem next_padded_grid_mem;
+
+// Counter-based seeding straight into grid_mem
+cl_kernel seed_grid_kernel;
+
+// Mip pyramid of the grid copy, levels 1..pyramidLevels(), only the viewport's texels are rebuilt
+cl_kernel downsample_kernel;
+cl_mem pyramid_mem;
+
+// Grid fingerprints for cycle detection, FINGERPRINT_GROUPS partials per generation
+cl_kernel fingerprint_kernel;
+cl_mem fingerprint_partials_mem;
+
+// Per-generation statistics, read back asynchronously through a ring of counter buffers
+constexpr int STATS_RING_SIZE = MAX_PIPELINE_DEPTH + 1;     // Batches whose read-back may still be in flight
+struct StatsBatch {
+    cl_mem counters = NULL;             // STATS_SLOT_SIZE counters per generation of the batch
+    std::vector<cl_uint> host;          // Read-back target
+    cl_event read_event = NULL;
+    uint64_t firstGeneration = 0;
+    int count = 0;
+};
+cl_kernel stats_kernel;
+cl_mem stats_previous_mem;              // Copy of the previous generation, for updates that don't ping-pong grid_mem
+StatsBatch statsBatches[STATS_RING_SIZE];
+int nextStatsBatch = 0;
+std::unique_ptr<StatsStream> statsStream;
+uint64_t statsGeneration = 0;           // Generation of the grid the next update starts from
+std::vector<cell_t> statsPreviousGrid;  // Host copy of the previous generation for the other engines
+
+// Local-memory tiled variant of the grid update
+cl_kernel tiled_update_kernel;
+WorkGroupShape work_group_shape = {0, 0};   // {0, 0} = untiled gameOfLife kernel
+
+// Active-tile variant of the grid update
+cl_kernel build_tile_list_kernel;
+cl_kernel active_update_kernel;
+cl_mem tile_changed_mem;
+cl_mem next_tile_changed_mem;
+cl_mem tile_list_mem;
+cl_mem tile_count_mem;
+
+bool initialiseOpenCL();
+void cleanupOpenCL();
+std::string buildOptions();
+uint enqueueBitboardGenerations(int count, cl_event *first_event, cl_event *last_event);
+uint enqueueActiveTileGenerations(int count, cl_event *first_event, cl_event *last_event);
+uint enqueuePaddedGenerations(int count, cl_event *first_event, cl_event *last_event);
+uint enqueueRuleGenerations(int count, cl_event *first_event, cl_event *last_event);
+uint enqueueFingerprint(int slot);
+uint enqueueUpdate(int count, cl_event *first_event, cl_event *last_event);
+uint enqueueDownsample(int slot, cl_event copy_event);
+uint markAllTilesChanged();
+uint enqueueGenerationsWithStats(int count, cl_event *first_event, cl_event *last_event);
+uint writeStatsBatch(StatsBatch &batch);
+uint readFingerprints(int count, uint64_t *fingerprints);
+
+// ----------- GAME OF LIFE ----------- //
+std::vector<cell_t> grid;       // Host copy of the species IDs, only synced when needed
+
+void initialiseEngine() {
+    // Fail over to the CPU engine on machines without a usable OpenCL device,
+    // both engines produce identical grids
+    if (ENGINE == ENGINE_OPENCL && !initialiseOpenCL()) {
+        std::cout << "OpenCL is unavailable, falling back to the CPU engine\n";
+        ENGINE = ENGINE_CPU;
+    }
+    if (ENGINE == ENGINE_MULTI_DEVICE && !initialiseMultiDevice(DEVICES, SUB_DEVICES)) {
+        std::cout << "Multi-device setup failed, falling back to the CPU engine\n";
+        ENGINE = ENGINE_CPU;
+    }
+
+    // The multi-device engine colours frames on the host with the CPU engine's pool
+    if (ENGINE == ENGINE_CPU || ENGINE == ENGINE_MULTI_DEVICE) {
+        initialiseCpuEngine(THREADS);
+    }
+}
+
+// Pick the tiled kernel's work-group size on the real grid
+void tuneEngine() {
+    if (ENGINE == ENGINE_OPENCL && TILED && !BITBOARD && !ACTIVE_TILES && !PADDED) {
+        work_group_shape = selectWorkGroupShape(device_id, gpu_commands, grid_update_kernel, tiled_update_kernel,
+                                                grid_mem, next_grid_mem, buildOptions(), RETUNE);
+    }
+}
+
+void cleanupEngine() {
+    finishStats();
+    cleanupOpenCL();
+    cleanupMultiDevice();
+    cleanupCpuEngine();
+}
+
+// Bake the grid size and species count into the whole-grid kernels, they are fixed for the run
+std::string buildOptions() {
+    if (!SPECIALISE) return "";
+    return "-D GOL_WIDTH=" + std::to_string(WIDTH) + " -D GOL_HEIGHT=" + std::to_string(HEIGHT) +
+           " -D GOL_NUM_SPECIES=" + std::to_string(NUMBER_OF_SPECIES);
+}
+
+bool initialiseOpenCL() {
+    cl_int err[2];
+
+    // Connect to a compute device
+    int gpu = 1;
+    err[0] = clGetDeviceIDs(NULL, gpu ? CL_DEVICE_TYPE_GPU : CL_DEVICE_TYPE_CPU, 1, &device_id, NULL);
+    if (err[0] != CL_SUCCESS) {
+        printf("Error: Failed to create a device group!\n");
+        return false;
+    }
+
+    // Create a compute context
+    context = clCreateContext(0, 1, &device_id, NULL, NULL, &err[0]);
+    if (!context) {
+        printf("Error: Failed to create a compute context!\n");
+        return false;
+    }
+
+    // Create "CPU" and GPU device command queues
+    gpu_commands = clCreateCommandQueue(context, device_id, CL_QUEUE_PROFILING_ENABLE, &err[0]);
+    cpu_commands = clCreateCommandQueue(context, device_id, CL_QUEUE_PROFILING_ENABLE, &err[1]);
+    if (!gpu_commands || !cpu_commands) {
+        printf("Error: Failed to create a command queue!\n");
+        return false;
+    }
+
+    // Build the gpu_program and cpu_program executables from the source character arrays,
+    // or from the binaries cached by an earlier run with the same grid
+    const char *gpuSources[12] = {specialisationSource, gpuKernelSource, bitboardKernelSource, tiledKernelSource,
+                                  cellRuleSource, activeTileKernelSource, fusedKernelSource, ruleKernelSource,
+                                  paddedKernelSource, fingerprintKernelSource, statsKernelSource, seedKernelSource};
+    const char *cpuSources[2] = {specialisationSource, cpuKernelSource};
+    std::string options = buildOptions();
+    gpu_program = buildProgram(context, device_id, gpuSources, 12, options.c_str());
+    cpu_program = buildProgram(context, device_id, cpuSources, 2, options.c_str());
+    if (!gpu_program || !cpu_program) {
+        printf("Error: Failed to build program executable!\n");
+        return false;
+    }
+
+    // Create the GPU and "CPU" compute kernels
+    grid_update_kernel = clCreateKernel(gpu_program, "gameOfLife", &err[0]);
+    pixels_update_kernel = clCreateKernel(cpu_program, "writeViewport", &err[1]);
+    if (!grid_update_kernel || err[0] != CL_SUCCESS || !pixels_update_kernel || err[1] != CL_SUCCESS) {
+        printf("Error: Failed to create compute kernel!\n");
+        return false;
+    }
+
+    // Create the bitboard kernels
+    pack_bitplanes_kernel = clCreateKernel(gpu_program, "packBitplanes", &err[0]);
+    unpack_bitplanes_kernel = clCreateKernel(gpu_program, "unpackBitplanes", &err[1]);
+    bitboard_update_kernel = clCreateKernel(gpu_program, "bitboardGameOfLife", &err[0]);
+    if (!pack_bitplanes_kernel || !unpack_bitplanes_kernel || !bitboard_update_kernel) {
+        printf("Error: Failed to create bitboard kernels!\n");
+        return false;
+    }
+
+    tiled_update_kernel = clCreateKernel(gpu_program, "gameOfLifeTiled", &err[0]);
+    if (!tiled_update_kernel || err[0] != CL_SUCCESS) {
+        printf("Error: Failed to create tiled kernel!\n");
+        return false;
+    }
+
+    pad_grid_kernel = clCreateKernel(gpu_program, "padGrid", &err[0]);
+    unpad_grid_kernel = clCreateKernel(gpu_program, "unpadGrid", &err[1]);
+    fill_ghost_cells_kernel = clCreateKernel(gpu_program, "fillGhostCells", &err[0]);
+    padded_update_kernel = clCreateKernel(gpu_program, "gameOfLifePadded", &err[1]);
+    if (!pad_grid_kernel || !unpad_grid_kernel || !fill_ghost_cells_kernel || !padded_update_kernel) {
+        printf("Error: Failed to create padded kernels!\n");
+        return false;
+    }
+
+    build_tile_list_kernel = clCreateKernel(gpu_program, "buildActiveTileList", &err[0]);
+    active_update_kernel = clCreateKernel(gpu_program, "gameOfLifeActiveTiles", &err[1]);
+    if (!build_tile_list_kernel || !active_update_kernel) {
+        printf("Error: Failed to create active tile kernels!\n");
+        return false;
+    }
+
+    fused_update_kernel = clCreateKernel(gpu_program, "gameOfLifeColoured", &err[0]);
+    if (!fused_update_kernel || err[0] != CL_SUCCESS) {
+        printf("Error: Failed to create fused kernel!\n");
+        return false;
+    }
+
+    downsample_kernel = clCreateKernel(cpu_program, "downsampleLevel", &err[0]);
+    if (!downsample_kernel || err[0] != CL_SUCCESS) {
+        printf("Error: Failed to create downsample kernel!\n");
+        return false;
+    }
+
+    rule_species_sums_kernel = clCreateKernel(gpu_program, "ruleSpeciesLineSums", &err[0]);
+    rule_plane_sums_kernel = clCreateKernel(gpu_program, "rulePlaneLineSums", &err[1]);
+    apply_rule_kernel = clCreateKernel(gpu_program, "applyRule", &err[0]);
+    if (!rule_species_sums_kernel || !rule_plane_sums_kernel || !apply_rule_kernel) {
+        printf("Error: Failed to create rule kernels!\n");
+        return false;
+    }
+
+    seed_grid_kernel = clCreateKernel(gpu_program, "seedGrid", &err[0]);
+    if (!seed_grid_kernel || err[0] != CL_SUCCESS) {
+        printf("Error: Failed to create seeding kernel!\n");
+        return false;
+    }
+
+    stats_kernel = clCreateKernel(gpu_program, "generationStats", &err[0]);
+    if (!stats_kernel || err[0] != CL_SUCCESS) {
+        printf("Error: Failed to create statistics kernel!\n");
+        return false;
+    }
+
+    fingerprint_kernel = clCreateKernel(gpu_program, "gridFingerprint", &err[0]);
+    if (!fingerprint_kernel || err[0] != CL_SUCCESS) {
+        printf("Error: Failed to create fingerprint kernel!\n");
+        return false;
+    }
+
+    // Create GPU buffers
+    grid_mem = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(cell_t) * WIDTH * HEIGHT, NULL, &err[0]);
+    next_grid_mem = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(cell_t) * WIDTH * HEIGHT, NULL, &err[0]);
+
+    if (!grid_mem || !next_grid_mem) {
+        printf("Error: Failed to allocate device memory!\n");
+        return false;
+    }
+
+    // Tile flags and work list are only needed by the active-tile update
+    if (ACTIVE_TILES) {
+        size_t tileCount = static_cast<size_t>(activeTilesX(WIDTH)) * activeTilesY(HEIGHT);
+        tile_changed_mem = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(cl_uchar) * tileCount, NULL, &err[0]);
+        next_tile_changed_mem = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(cl_uchar) * tileCount, NULL, &err[0]);
+        tile_list_mem = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(cl_int) * tileCount, NULL, &err[0]);
+        tile_count_mem = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(cl_int), NULL, &err[0]);
+        if (!tile_changed_mem || !next_tile_changed_mem || !tile_list_mem || !tile_count_mem) {
+            printf("Error: Failed to allocate active tile memory!\n");
+            return false;
+        }
+    }
+
+    // Sliding-window sums and counts are only needed by the generalised rule update
+    if (!isLifeRule(RULE)) {
+        int padding = ruleCountPadding(RULE);
+        size_t sumsPlaneSize = static_cast<size_t>(WIDTH + 2 * padding) * (HEIGHT + 2 * padding);
+        size_t countWords = RULE.birth.size();
+        rule_sums_mem = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(cl_ushort) * sumsPlaneSize * NUMBER_OF_SPECIES, NULL, &err[0]);
+        rule_counts_mem = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(cl_ushort) * WIDTH * HEIGHT * NUMBER_OF_SPECIES, NULL, &err[0]);
+        rule_birth_mem = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(cl_uint) * countWords,
+                                        RULE.birth.data(), &err[0]);
+        rule_survival_mem = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(cl_uint) * countWords,
+                                           RULE.survival.data(), &err[0]);
+        if (!rule_sums_mem || !rule_counts_mem || !rule_birth_mem || !rule_survival_mem) {
+            printf("Error: Failed to allocate rule memory!\n");
+            return false;
+        }
+    }
+
+    // Bitplanes are only needed by the bitboard update
+    if (BITBOARD) {
+        size_t planesSize = sizeof(cl_ulong) * bitboardPlaneSize(WIDTH, HEIGHT) * NUMBER_OF_SPECIES;
+        planes_mem = clCreateBuffer(context, CL_MEM_READ_WRITE, planesSize, NULL, &err[0]);
+        next_planes_mem = clCreateBuffer(context, CL_MEM_READ_WRITE, planesSize, NULL, &err[0]);
+        if (!planes_mem || !next_planes_mem) {
+            printf("Error: Failed to allocate bitplane memory!\n");
+            return false;
+        }
+    }
+
+    // Ghost-bordered grids are only needed by the padded update
+    if (PADDED) {
+        size_t paddedBytes = sizeof(cell_t) * paddedSize(WIDTH, HEIGHT);
+        padded_grid_mem = clCreateBuffer(context, CL_MEM_READ_WRITE, paddedBytes, NULL, &err[0]);
+        next_padded_grid_mem = clCreateBuffer(context, CL_MEM_READ_WRITE, paddedBytes, NULL, &err[0]);
+        if (!padded_grid_mem || !next_padded_grid_mem) {
+            printf("Error: Failed to allocate padded grid memory!\n");
+            return false;
+        }
+    }
+
+    // Partials for a whole batch of fingerprints are only needed by cycle detection
+    if (CYCLE_WINDOW > 0) {
+        size_t partials = static_cast<size_t>(GENERATIONS_PER_FRAME) * FINGERPRINT_GROUPS;
+        fingerprint_partials_mem = clCreateBuffer(context, CL_MEM_WRITE_ONLY, sizeof(cl_ulong) * partials, NULL, &err[0]);
+        if (!fingerprint_partials_mem) {
+            printf("Error: Failed to allocate fingerprint memory!\n");
+            return false;
+        }
+    }
+
+    // Counters for every generation of a batch, per batch still being read back
+    if (STATS_PATH != nullptr) {
+        size_t counters = static_cast<size_t>(GENERATIONS_PER_FRAME) * STATS_SLOT_SIZE;
+        for (StatsBatch &batch : statsBatches) {
+            batch.counters = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(cl_uint) * counters, NULL, &err[0]);
+            batch.host.resize(counters);
+            if (!batch.counters) {
+                printf("Error: Failed to allocate statistics memory!\n");
+                return false;
+            }
+        }
+        if (BITBOARD || PADDED) {
+            stats_previous_mem = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(cell_t) * WIDTH * HEIGHT, NULL, &err[0]);
+            if (!stats_previous_mem) {
+                printf("Error: Failed to allocate statistics memory!\n");
+                return false;
+            }
+        }
+    }
+
+    // Create "CPU" buffers
+    // One set per frame in flight, so colouring frame N never waits on frame N+1's copy.
+    // Fused frames are coloured straight from the update, so they need no grid copy.
+    for (int slot = 0; slot < PIPELINE_DEPTH; slot++) {
+        if (!FUSED_PIXELS) {
+            grid_cpu_mem[slot] = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(cell_t) * WIDTH * HEIGHT, NULL, &err[1]);
+        }
+        cpu_pixel_buffer_mem[slot] = clCreateBuffer(context, CL_MEM_WRITE_ONLY, sizeof(unsigned char) * viewWidth() * viewHeight() * 3, NULL, &err[1]);
+
+        if ((!FUSED_PIXELS && !grid_cpu_mem[slot]) || !cpu_pixel_buffer_mem[slot]) {
+            printf("Error: Failed to allocate device memory!\n");
+            return false;
+        }
+    }
+
+    // Shared by every slot, the pixel queue builds and reads it one frame at a time
+    if (!FUSED_PIXELS && pyramidLevels() > 0) {
+        pyramid_mem = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(ViewTexel) * pyramidSize(), NULL, &err[0]);
+        if (!pyramid_mem) {
+            printf("Error: Failed to allocate pyramid memory!\n");
+            return false;
+        }
+    }
+
+    unsigned char palette[PALETTE_SIZE][3];
+    buildCellPalette(palette);
+    palette_mem = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, sizeof(palette), palette, &err[0]);
+    if (!palette_mem) {
+        printf("Error: Failed to allocate palette memory!\n");
+        return false;
+    }
+
+    std::cout << "OpenCL initialized successfully!" << std::endl;
+    return true;
+}
+
+void cleanupOpenCL() {
+    std::cout << "Freeing memory allocated by OpenCL\n";
+
+    if (grid_mem) clReleaseMemObject(grid_mem);
+    if (next_grid_mem) clReleaseMemObject(next_grid_mem);
+    if (planes_mem) clReleaseMemObject(planes_mem);
+    if (next_planes_mem) clReleaseMemObject(next_planes_mem);
+    if (pack_bitplanes_kernel) clReleaseKernel(pack_bitplanes_kernel);
+    if (unpack_bitplanes_kernel) clReleaseKernel(unpack_bitplanes_kernel);
+    if (bitboard_update_kernel) clReleaseKernel(bitboard_update_kernel);
+    if (padded_grid_mem) clReleaseMemObject(padded_grid_mem);
+    if (next_padded_grid_mem) clReleaseMemObject(next_padded_grid_mem);
+    if (pad_grid_kernel) clReleaseKernel(pad_grid_kernel);
+    if (unpad_grid_kernel) clReleaseKernel(unpad_grid_kernel);
+    if (fill_ghost_cells_kernel) clReleaseKernel(fill_ghost_cells_kernel);
+    if (padded_update_kernel) clReleaseKernel(padded_update_kernel);
+    if (tiled_update_kernel) clReleaseKernel(tiled_update_kernel);
+    if (build_tile_list_kernel) clReleaseKernel(build_tile_list_kernel);
+    if (active_update_kernel) clReleaseKernel(active_update_kernel);
+    if (tile_changed_mem) clReleaseMemObject(tile_changed_mem);
+    if (next_tile_changed_mem) clReleaseMemObject(next_tile_changed_mem);
+    if (tile_list_mem) clReleaseMemObject(tile_list_mem);
+    if (tile_count_mem) clReleaseMemObject(tile_count_mem);
+    for (int slot = 0; slot < MAX_PIPELINE_DEPTH; slot++) {
+        if (grid_cpu_mem[slot]) clReleaseMemObject(grid_cpu_mem[slot]);
+        if (cpu_pixel_buffer_mem[slot]) clReleaseMemObject(cpu_pixel_buffer_mem[slot]);
+        grid_cpu_mem[slot] = cpu_pixel_buffer_mem[slot] = NULL;
+    }
+    if (rule_species_sums_kernel) clReleaseKernel(rule_species_sums_kernel);
+    if (rule_plane_sums_kernel) clReleaseKernel(rule_plane_sums_kernel);
+    if (apply_rule_kernel) clReleaseKernel(apply_rule_kernel);
+    if (rule_sums_mem) clReleaseMemObject(rule_sums_mem);
+    if (rule_counts_mem) clReleaseMemObject(rule_counts_mem);
+    if (rule_birth_mem) clReleaseMemObject(rule_birth_mem);
+    if (rule_survival_mem) clReleaseMemObject(rule_survival_mem);
+    if (palette_mem) clReleaseMemObject(palette_mem);
+    if (pyramid_mem) clReleaseMemObject(pyramid_mem);
+    if (downsample_kernel) clReleaseKernel(downsample_kernel);
+    if (fingerprint_kernel) clReleaseKernel(fingerprint_kernel);
+    if (seed_grid_kernel) clReleaseKernel(seed_grid_kernel);
+    if (stats_kernel) clReleaseKernel(stats_kernel);
+    if (stats_previous_mem) clReleaseMemObject(stats_previous_mem);
+    for (StatsBatch &batch : statsBatches) {
+        if (batch.read_event) clReleaseEvent(batch.read_event);
+        if (batch.counters) clReleaseMemObject(batch.counters);
+        batch = StatsBatch();
+    }
+    if (fingerprint_partials_mem) clReleaseMemObject(fingerprint_partials_mem);
+    if (fused_update_kernel) clReleaseKernel(fused_update_kernel);
+    if (gpu_program) clReleaseProgram(gpu_program);
+    if (cpu_program) clReleaseProgram(cpu_program);
+    if (grid_update_kernel) clReleaseKernel(grid_update_kernel);
+    if (pixels_update_kernel) clReleaseKernel(pixels_update_kernel);
+    if (gpu_commands) clReleaseCommandQueue(gpu_commands);
+    if (cpu_commands) clReleaseCommandQueue(cpu_commands);
+    if (context) clReleaseContext(context);
+
+    // Forget the released handles so the engine can be initialised again
+    grid_mem = next_grid_mem = NULL;
+    planes_mem = next_planes_mem = NULL;
+    padded_grid_mem = next_padded_grid_mem = NULL;
+    tile_changed_mem = next_tile_changed_mem = tile_list_mem = tile_count_mem = NULL;
+    palette_mem = pyramid_mem = NULL;
+    fingerprint_kernel = stats_kernel = seed_grid_kernel = downsample_kernel = NULL;
+    stats_previous_mem = NULL;
+    fingerprint_partials_mem = NULL;
+    grid_update_kernel = pixels_update_kernel = tiled_update_kernel = fused_update_kernel = NULL;
+    pack_bitplanes_kernel = unpack_bitplanes_kernel = bitboard_update_kernel = NULL;
+    pad_grid_kernel = unpad_grid_kernel = fill_ghost_cells_kernel = padded_update_kernel = NULL;
+    build_tile_list_kernel = active_update_kernel = NULL;
+    rule_species_sums_kernel = rule_plane_sums_kernel = apply_rule_kernel = NULL;
+    rule_sums_mem = rule_counts_mem = rule_birth_mem = rule_survival_mem = NULL;
+    gpu_program = cpu_program = NULL;
+    gpu_commands = cpu_commands = NULL;
+    context = NULL;
+    work_group_shape = {0, 0};
+}
+
+uint initialiseGrid() {
+    grid.resize(WIDTH * HEIGHT);
+
+    if (PATTERN_PATH != nullptr) {
+        if (!loadPattern(PATTERN_PATH, grid.data(), WIDTH, HEIGHT, NUMBER_OF_SPECIES, PATTERN_X, PATTERN_Y)) return 0;
+        return uploadGridToDevice();
+    }
+
+    // The other engines seed the host grid on every core and upload it
+    if (ENGINE != ENGINE_OPENCL) {
+        seedCells(grid.data(), grid.size(), SEED, NUMBER_OF_SPECIES);
+        return uploadGridToDevice();
+    }
+
+    // Seeded where it lives, the host copy is only filled in by readGridToHost
+    int cellCount = WIDTH * HEIGHT;
+    cl_ulong key = seedKey(SEED);
+    clSetKernelArg(seed_grid_kernel, 0, sizeof(cl_mem), &grid_mem);
+    clSetKernelArg(seed_grid_kernel, 1, sizeof(int), &cellCount);
+    clSetKernelArg(seed_grid_kernel, 2, sizeof(cl_ulong), &key);
+    clSetKernelArg(seed_grid_kernel, 3, sizeof(int), &NUMBER_OF_SPECIES);
+
+    cl_event seed_event;
+    size_t global = static_cast<size_t>(cellCount);
+    cl_int err = clEnqueueNDRangeKernel(gpu_commands, seed_grid_kernel, 1, NULL, &global, NULL, 0, NULL, &seed_event);
+    if (err != CL_SUCCESS) {
+        printf("Error: Failed to seed the grid!\n");
+        return 0;
+    }
+    clFinish(gpu_commands);
+    traceDeviceEvent("Seed grid", TRACK_GPU_QUEUE, seed_event);
+    clReleaseEvent(seed_event);
+    return markAllTilesChanged();
+}
+
+uint uploadGridToDevice() {
+    // The host grid was replaced, no tile can be skipped until it has been stepped once
+    if (ENGINE == ENGINE_CPU) {
+        cpuResetActiveTiles();
+        return 1;
+    }
+    if (ENGINE == ENGINE_MULTI_DEVICE) return multiDeviceUpload(grid) ? 1 : 0;
+
+    // The grid only crosses the bus once, afterwards it stays on the device
+    cl_event write_event;
+    cl_int err = clEnqueueWriteBuffer(gpu_commands, grid_mem, CL_TRUE, 0,
+                                      sizeof(cell_t) * WIDTH * HEIGHT,
+                                      grid.data(), 0, NULL, &write_event);
+    if (err != CL_SUCCESS) {
+        printf("Error: Failed to write grid to GPU memory!\n");
+        return 0;
+    }
+    traceDeviceEvent("Upload grid", TRACK_GPU_QUEUE, write_event);
+    clReleaseEvent(write_event);
+    return markAllTilesChanged();
+}
+
+// grid_mem was replaced, no tile can be skipped until it has been stepped once
+uint markAllTilesChanged() {
+    if (!ACTIVE_TILES) return 1;
+
+    cl_uchar changed = 1;
+    size_t tileCount = static_cast<size_t>(activeTilesX(WIDTH)) * activeTilesY(HEIGHT);
+    cl_int err = clEnqueueFillBuffer(gpu_commands, tile_changed_mem, &changed, sizeof(changed), 0,
+                                     sizeof(cl_uchar) * tileCount, 0, NULL, NULL);
+    if (err != CL_SUCCESS) {
+        printf("Error: Failed to reset active tiles!\n");
+        return 0;
+    }
+    return 1;
+}
+
+uint readGridToHost() {
+    // The CPU engine works on the host grid directly
+    if (ENGINE == ENGINE_CPU) return 1;
+    if (ENGINE == ENGINE_MULTI_DEVICE) return multiDeviceDownload(grid) ? 1 : 0;
+
+    cl_event read_event;
+    cl_int err = clEnqueueReadBuffer(gpu_commands, grid_mem, CL_TRUE, 0,
+                                     sizeof(cell_t) * WIDTH * HEIGHT,
+                                     grid.data(), 0, NULL, &read_event);
+    if (err != CL_SUCCESS) {
+        printf("Error: Failed to read back grid!\n");
+        return 0;
+    }
+    traceDeviceEvent("Read back grid", TRACK_GPU_QUEUE, read_event);
+    clReleaseEvent(read_event);
+    return 1;
+}
+
+uint enqueueBitboardGenerations(int count, cl_event *first_event, cl_event *last_event) {
+    cl_int err;
+    int wordsPerRow = bitboardWordsPerRow(WIDTH);
+    size_t global[2] = {static_cast<size_t>(wordsPerRow), static_cast<size_t>(HEIGHT)};
+
+    // Pack grid N into bitplanes, the K generations in between stay bit-sliced
+    cl_kernel kernels[3] = {pack_bitplanes_kernel, bitboard_update_kernel, unpack_bitplanes_kernel};
+    for (cl_kernel kernel : kernels) {
+        clSetKernelArg(kernel, 2, sizeof(int), &WIDTH);
+        clSetKernelArg(kernel, 3, sizeof(int), &HEIGHT);
+        clSetKernelArg(kernel, 4, sizeof(int), &wordsPerRow);
+        clSetKernelArg(kernel, 5, sizeof(int), &NUMBER_OF_SPECIES);
+    }
+
+    clSetKernelArg(pack_bitplanes_kernel, 0, sizeof(cl_mem), &grid_mem);
+    clSetKernelArg(pack_bitplanes_kernel, 1, sizeof(cl_mem), &planes_mem);
+    err = clEnqueueNDRangeKernel(gpu_commands, pack_bitplanes_kernel, 2, NULL, global, NULL, 0, NULL, first_event);
+    if (err != CL_SUCCESS) {
+        printf("Error: Failed to launch bitplane packing kernel!\n");
+        return 0;
+    }
+
+    for (int generation = 0; generation < count; generation++) {
+        clSetKernelArg(bitboard_update_kernel, 0, sizeof(cl_mem), &planes_mem);
+        clSetKernelArg(bitboard_update_kernel, 1, sizeof(cl_mem), &next_planes_mem);
+        err = clEnqueueNDRangeKernel(gpu_commands, bitboard_update_kernel, 2, NULL, global, NULL, 0, NULL, NULL);
+        if (err != CL_SUCCESS) {
+            printf("Error: Failed to launch bitboard kernel!\n");
+            return 0;
+        }
+        std::swap(planes_mem, next_planes_mem);
+    }
+
+    // Unpack generation N+K back into grid_mem for colouring and read-back
+    clSetKernelArg(unpack_bitplanes_kernel, 0, sizeof(cl_mem), &planes_mem);
+    clSetKernelArg(unpack_bitplanes_kernel, 1, sizeof(cl_mem), &grid_mem);
+    err = clEnqueueNDRangeKernel(gpu_commands, unpack_bitplanes_kernel, 2, NULL, global, NULL, 0, NULL, last_event);
+    if (err != CL_SUCCESS) {
+        printf("Error: Failed to launch bitplane unpacking kernel!\n");
+        return 0;
+    }
+
+    return 1;
+}
+
+uint enqueuePaddedGenerations(int count, cl_event *first_event, cl_event *last_event) {
+    cl_int err;
+    int torus = BOUNDARY == BOUNDARY_TORUS;
+    size_t global[2] = {static_cast<size_t>(WIDTH), static_cast<size_t>(HEIGHT)};
+    size_t ghostCells = 2 * static_cast<size_t>(paddedPitch(WIDTH)) + 2 * static_cast<size_t>(HEIGHT);
+
+    cl_kernel kernels[4] = {pad_grid_kernel, unpad_grid_kernel, fill_ghost_cells_kernel, padded_update_kernel};
+    int firstSizeArg[4] = {2, 2, 1, 2};
+    for (int i = 0; i < 4; i++) {
+        clSetKernelArg(kernels[i], firstSizeArg[i], sizeof(int), &WIDTH);
+        clSetKernelArg(kernels[i], firstSizeArg[i] + 1, sizeof(int), &HEIGHT);
+    }
+    clSetKernelArg(fill_ghost_cells_kernel, 3, sizeof(int), &torus);
+    clSetKernelArg(padded_update_kernel, 4, sizeof(int), &NUMBER_OF_SPECIES);
+
+    // Pad grid N once, the K generations in between stay padded
+    clSetKernelArg(pad_grid_kernel, 0, sizeof(cl_mem), &grid_mem);
+    clSetKernelArg(pad_grid_kernel, 1, sizeof(cl_mem), &padded_grid_mem);
+    err = clEnqueueNDRangeKernel(gpu_commands, pad_grid_kernel, 2, NULL, global, NULL, 0, NULL, first_event);
+    if (err != CL_SUCCESS) {
+        printf("Error: Failed to launch grid padding kernel!\n");
+        return 0;
+    }
+
+    // The update never writes the border, so a dead one only needs filling once per buffer
+    cl_mem buffers[2] = {padded_grid_mem, next_padded_grid_mem};
+    for (int i = 0; i < 2 && !torus; i++) {
+        clSetKernelArg(fill_ghost_cells_kernel, 0, sizeof(cl_mem), &buffers[i]);
+        err = clEnqueueNDRangeKernel(gpu_commands, fill_ghost_cells_kernel, 1, NULL, &ghostCells, NULL, 0, NULL, NULL);
+        if (err != CL_SUCCESS) {
+            printf("Error: Failed to launch ghost cell kernel!\n");
+            return 0;
+        }
+    }
+
+    for (int generation = 0; generation < count; generation++) {
+        // A torus border changes with the edges, wrap it before every generation
+        if (torus) {
+            clSetKernelArg(fill_ghost_cells_kernel, 0, sizeof(cl_mem), &padded_grid_mem);
+            err = clEnqueueNDRangeKernel(gpu_commands, fill_ghost_cells_kernel, 1, NULL, &ghostCells, NULL, 0, NULL, NULL);
+            if (err != CL_SUCCESS) {
+                printf("Error: Failed to launch ghost cell kernel!\n");
+                return 0;
+            }
+        }
+
+        clSetKernelArg(padded_update_kernel, 0, sizeof(cl_mem), &padded_grid_mem);
+        clSetKernelArg(padded_update_kernel, 1, sizeof(cl_mem), &next_padded_grid_mem);
+        err = clEnqueueNDRangeKernel(gpu_commands, padded_update_kernel, 2, NULL, global, NULL, 0, NULL, NULL);
+        if (err != CL_SUCCESS) {
+            printf("Error: Failed to launch padded kernel!\n");
+            return 0;
+        }
+        std::swap(padded_grid_mem, next_padded_grid_mem);
+    }
+
+    // Copy generation N+K back into grid_mem for colouring and read-back
+    clSetKernelArg(unpad_grid_kernel, 0, sizeof(cl_mem), &padded_grid_mem);
+    clSetKernelArg(unpad_grid_kernel, 1, sizeof(cl_mem), &grid_mem);
+    err = clEnqueueNDRangeKernel(gpu_commands, unpad_grid_kernel, 2, NULL, global, NULL, 0, NULL, last_event);
+    if (err != CL_SUCCESS) {
+        printf("Error: Failed to launch grid unpadding kernel!\n");
+        return 0;
+    }
+
+    return 1;
+}
+
+uint enqueueActiveTileGenerations(int count, cl_event *first_event, cl_event *last_event) {
+    cl_int err;
+    int tilesX = activeTilesX(WIDTH);
+    int tilesY = activeTilesY(HEIGHT);
+    size_t tileCount = static_cast<size_t>(tilesX) * tilesY;
+
+    // One work-group of 64x4 work-items per tile slot, each work-item walks a column of the tile
+    size_t listGlobal[2] = {static_cast<size_t>(tilesX), static_cast<size_t>(tilesY)};
+    size_t updateLocal[2] = {ACTIVE_TILE_WIDTH, 4};
+    size_t updateGlobal[2] = {ACTIVE_TILE_WIDTH, 4 * tileCount};
+
+    clSetKernelArg(build_tile_list_kernel, 1, sizeof(cl_mem), &tile_list_mem);
+    clSetKernelArg(build_tile_list_kernel, 2, sizeof(cl_mem), &tile_count_mem);
+    clSetKernelArg(build_tile_list_kernel, 3, sizeof(int), &tilesX);
+    clSetKernelArg(build_tile_list_kernel, 4, sizeof(int), &tilesY);
+
+    clSetKernelArg(active_update_kernel, 2, sizeof(int), &WIDTH);
+    clSetKernelArg(active_update_kernel, 3, sizeof(int), &HEIGHT);
+    clSetKernelArg(active_update_kernel, 4, sizeof(int), &NUMBER_OF_SPECIES);
+    clSetKernelArg(active_update_kernel, 5, sizeof(int), &tilesX);
+    clSetKernelArg(active_update_kernel, 6, sizeof(cl_mem), &tile_list_mem);
+    clSetKernelArg(active_update_kernel, 7, sizeof(cl_mem), &tile_count_mem);
+
+    for (int generation = 0; generation < count; generation++) {
+        cl_int zero = 0;
+        cl_uchar unchanged = 0;
+        err = clEnqueueFillBuffer(gpu_commands, tile_count_mem, &zero, sizeof(zero), 0, sizeof(cl_int), 0, NULL, NULL);
+        err |= clEnqueueFillBuffer(gpu_commands, next_tile_changed_mem, &unchanged, sizeof(unchanged), 0,
+                                   sizeof(cl_uchar) * tileCount, 0, NULL, NULL);
+
+        // Compact the tiles that need recomputing, then update only those
+        clSetKernelArg(build_tile_list_kernel, 0, sizeof(cl_mem), &tile_changed_mem);
+        err |= clEnqueueNDRangeKernel(gpu_commands, build_tile_list_kernel, 2, NULL, listGlobal, NULL, 0, NULL,
+                                      generation == 0 ? first_event : NULL);
+
+        clSetKernelArg(active_update_kernel, 0, sizeof(cl_mem), &grid_mem);
+        clSetKernelArg(active_update_kernel, 1, sizeof(cl_mem), &next_grid_mem);
+        clSetKernelArg(active_update_kernel, 8, sizeof(cl_mem), &next_tile_changed_mem);
+        err |= clEnqueueNDRangeKernel(gpu_commands, active_update_kernel, 2, NULL, updateGlobal, updateLocal, 0, NULL,
+                                      generation == count - 1 ? last_event : NULL);
+        if (err != CL_SUCCESS) {
+            printf("Error: Failed to launch active tile kernels!\n");
+            return 0;
+        }
+
+        std::swap(grid_mem, next_grid_mem);
+        std::swap(tile_changed_mem, next_tile_changed_mem);
+    }
+
+    return 1;
+}
+
+uint enqueueRuleGenerations(int count, cl_event *first_event, cl_event *last_event) {
+    cl_int err;
+    int padding = ruleCountPadding(RULE);
+    int sumsWidth = WIDTH + 2 * padding;
+    int sumsHeight = HEIGHT + 2 * padding;
+    int countWords = static_cast<int>(RULE.birth.size());
+    int includeCentre = RULE.includeCentre ? 1 : 0;
+    std::vector<RuleCountPass> passes = ruleCountPasses(RULE);
+    size_t global[2] = {static_cast<size_t>(WIDTH), static_cast<size_t>(HEIGHT)};
+
+    clSetKernelArg(rule_species_sums_kernel, 1, sizeof(int), &WIDTH);
+    clSetKernelArg(rule_species_sums_kernel, 2, sizeof(int), &HEIGHT);
+    clSetKernelArg(rule_species_sums_kernel, 3, sizeof(int), &NUMBER_OF_SPECIES);
+    clSetKernelArg(rule_species_sums_kernel, 4, sizeof(int), &padding);
+    clSetKernelArg(rule_species_sums_kernel, 9, sizeof(cl_mem), &rule_sums_mem);
+
+    clSetKernelArg(rule_plane_sums_kernel, 0, sizeof(cl_mem), &rule_sums_mem);
+    clSetKernelArg(rule_plane_sums_kernel, 1, sizeof(int), &WIDTH);
+    clSetKernelArg(rule_plane_sums_kernel, 2, sizeof(int), &HEIGHT);
+    clSetKernelArg(rule_plane_sums_kernel, 3, sizeof(int), &padding);
+    clSetKernelArg(rule_plane_sums_kernel, 10, sizeof(cl_mem), &rule_counts_mem);
+
+    clSetKernelArg(apply_rule_kernel, 1, sizeof(cl_mem), &rule_counts_mem);
+    clSetKernelArg(apply_rule_kernel, 3, sizeof(int), &WIDTH);
+    clSetKernelArg(apply_rule_kernel, 4, sizeof(int), &HEIGHT);
+    clSetKernelArg(apply_rule_kernel, 5, sizeof(int), &NUMBER_OF_SPECIES);
+    clSetKernelArg(apply_rule_kernel, 6, sizeof(cl_mem), &rule_birth_mem);
+    clSetKernelArg(apply_rule_kernel, 7, sizeof(cl_mem), &rule_survival_mem);
+    clSetKernelArg(apply_rule_kernel, 8, sizeof(int), &countWords);
+    clSetKernelArg(apply_rule_kernel, 9, sizeof(int), &includeCentre);
+
+    for (int generation = 0; generation < count; generation++) {
+        // Count every species' neighbours, one work-item per line of each sliding-window pass
+        clSetKernelArg(rule_species_sums_kernel, 0, sizeof(cl_mem), &grid_mem);
+        for (size_t index = 0; index < passes.size(); index++) {
+            const RuleCountPass &pass = passes[index];
+            int accumulate = pass.accumulate ? 1 : 0;
+
+            clSetKernelArg(rule_species_sums_kernel, 5, sizeof(int), &pass.firstDx);
+            clSetKernelArg(rule_species_sums_kernel, 6, sizeof(int), &pass.firstDy);
+            clSetKernelArg(rule_species_sums_kernel, 7, sizeof(int), &pass.lo);
+            clSetKernelArg(rule_species_sums_kernel, 8, sizeof(int), &pass.hi);
+            size_t firstGlobal = static_cast<size_t>(ruleLineCount(sumsWidth, sumsHeight, pass.firstDx, pass.firstDy));
+            err = clEnqueueNDRangeKernel(gpu_commands, rule_species_sums_kernel, 1, NULL, &firstGlobal, NULL, 0, NULL,
+                                         generation == 0 && index == 0 ? first_event : NULL);
+
+            clSetKernelArg(rule_plane_sums_kernel, 4, sizeof(int), &pass.secondDx);
+            clSetKernelArg(rule_plane_sums_kernel, 5, sizeof(int), &pass.secondDy);
+            clSetKernelArg(rule_plane_sums_kernel, 6, sizeof(int), &pass.lo);
+            clSetKernelArg(rule_plane_sums_kernel, 7, sizeof(int), &pass.hi);
+            clSetKernelArg(rule_plane_sums_kernel, 8, sizeof(int), &pass.shiftX);
+            clSetKernelArg(rule_plane_sums_kernel, 9, sizeof(int), &accumulate);
+            size_t secondGlobal[2] = {static_cast<size_t>(ruleLineCount(WIDTH, HEIGHT, pass.secondDx, pass.secondDy)),
+                                      static_cast<size_t>(NUMBER_OF_SPECIES)};
+            err |= clEnqueueNDRangeKernel(gpu_commands, rule_plane_sums_kernel, 2, NULL, secondGlobal, NULL, 0, NULL, NULL);
+            if (err != CL_SUCCESS) {
+                printf("Error: Failed to launch neighbour count kernels!\n");
+                return 0;
+            }
+        }
+
+        clSetKernelArg(apply_rule_kernel, 0, sizeof(cl_mem), &grid_mem);
+        clSetKernelArg(apply_rule_kernel, 2, sizeof(cl_mem), &next_grid_mem);
+        err = clEnqueueNDRangeKernel(gpu_commands, apply_rule_kernel, 2, NULL, global, NULL, 0, NULL,
+                                     generation == count - 1 ? last_event : NULL);
+        if (err != CL_SUCCESS) {
+            printf("Error: Failed to launch rule kernel!\n");
+            return 0;
+        }
+
+        // grid_mem now refers to the newest generation
+        std::swap(grid_mem, next_grid_mem);
+    }
+
+    return 1;
+}
+
+uint enqueueGenerations(int count, cl_event *first_event, cl_event *last_event) {
+    if (statsStream) return enqueueGenerationsWithStats(count, first_event, last_event);
+    return enqueueUpdate(count, first_event, last_event);
+}
+
+// Dispatch count generations to the selected update
+uint enqueueUpdate(int count, cl_event *first_event, cl_event *last_event) {
+    if (!isLifeRule(RULE)) return enqueueRuleGenerations(count, first_event, last_event);
+    if (BITBOARD) return enqueueBitboardGenerations(count, first_event, last_event);
+    if (ACTIVE_TILES) return enqueueActiveTileGenerations(count, first_event, last_event);
+    if (PADDED) return enqueuePaddedGenerations(count, first_event, last_event);
+
+    cl_int err;
+    size_t global[2] = {static_cast<size_t>(WIDTH), static_cast<size_t>(HEIGHT)};
+
+    // The tiled kernel needs the global size rounded up to whole work-groups
+    bool tiled = work_group_shape.x != 0;
+    size_t local[2] = {work_group_shape.x, work_group_shape.y};
+    cl_kernel kernel = tiled ? tiled_update_kernel : grid_update_kernel;
+    if (tiled) {
+        global[0] = (global[0] + local[0] - 1) / local[0] * local[0];
+        global[1] = (global[1] + local[1] - 1) / local[1] * local[1];
+    }
+
+    clSetKernelArg(grid_update_kernel, 2, sizeof(int), &WIDTH);
+    clSetKernelArg(grid_update_kernel, 3, sizeof(int), &HEIGHT);
+    clSetKernelArg(grid_update_kernel, 4, sizeof(int), &NUMBER_OF_SPECIES);
+
+    for (int generation = 0; generation < count; generation++) {
+        // Ping-pong: generation N is read from grid_mem and written to next_grid_mem
+        if (tiled) {
+            setTiledKernelArgs(tiled_update_kernel, grid_mem, next_grid_mem, work_group_shape);
+        }
+        else {
+            clSetKernelArg(grid_update_kernel, 0, sizeof(cl_mem), &grid_mem);
+            clSetKernelArg(grid_update_kernel, 1, sizeof(cl_mem), &next_grid_mem);
+        }
+
+        // Only profile the first and last launch of the batch
+        cl_event *event = NULL;
+        if (generation == 0 && first_event) event = first_event;
+        else if (generation == count - 1 && last_event) event = last_event;
+
+        err = clEnqueueNDRangeKernel(gpu_commands, kernel,
+                                     2, NULL, global, tiled ? local : NULL, 0, NULL, event);
+        if (err != CL_SUCCESS) {
+            printf("Error: Failed to launch compute kernel!\n");
+            return 0;
+        }
+
+        // grid_mem now refers to the newest generation
+        std::swap(grid_mem, next_grid_mem);
+    }
+
+    // A single launch is both the first and last event of the batch
+    if (count == 1 && first_event && last_event) {
+        *last_event = *first_event;
+        clRetainEvent(*last_event);
+    }
+
+    return 1;
+}
+
+uint stepGenerations(int count) {
+    // The other engines' statistics are counted on the host, one generation at a time
+    if (statsStream && ENGINE != ENGINE_OPENCL) {
+        std::vector<uint32_t> slot(STATS_SLOT_SIZE);
+        for (int generation = 0; generation < count; generation++) {
+            if (!readGridToHost()) return 0;
+            statsPreviousGrid = grid;
+            if (ENGINE == ENGINE_CPU) {
+                TraceScope scope("CPU generations");
+                cpuStepGenerations(grid, 1);
+            }
+            else if (!multiDeviceStepGenerations(1) || !readGridToHost()) {
+                return 0;
+            }
+
+            TraceScope scope("Statistics");
+            std::fill(slot.begin(), slot.end(), 0);
+            cpuGenerationStats(statsPreviousGrid, grid, slot.data());
+            statsStream->write(++statsGeneration, slot.data());
+        }
+        statsStream->flush();
+        return 1;
+    }
+
+    if (ENGINE == ENGINE_CPU) {
+        TraceScope scope("CPU generations");
+        cpuStepGenerations(grid, count);
+        return 1;
+    }
+    if (ENGINE == ENGINE_MULTI_DEVICE) {
+        TraceScope scope("Multi-device generations");
+        return multiDeviceStepGenerations(count) ? 1 : 0;
+    }
+
+    // Only profile the batch when someone is looking at the trace
+    bool traced = tracingEnabled();
+    cl_event first_event = NULL, last_event = NULL;
+    if (!enqueueGenerations(count, traced ? &first_event : NULL, traced ? &last_event : NULL)) return 0;
+    if (traced) {
+        traceDeviceSpan("Generations", TRACK_GPU_QUEUE, first_event, last_event);
+        clReleaseEvent(first_event);
+        clReleaseEvent(last_event);
+    }
+
+    TraceScope scope("Wait for generations");
+    clFinish(gpu_commands);
+    return 1;
+}
+
+// Rebuild the pyramid texels the viewport shows, from level 1 up to its level
+uint enqueueDownsample(int slot, cl_event copy_event) {
+    int level = viewLevel(viewport);
+    for (int target = 1; target <= level; target++) {
+        LevelRect rect = viewLevelRect(viewport, target);
+        if (rect.x1 <= rect.x0 || rect.y1 <= rect.y0) continue;
+
+        int fromGrid = target == 1;
+        int sourceOffset = fromGrid ? 0 : static_cast<int>(pyramidLevelOffset(target - 1));
+        int sourceWidth = levelWidth(target - 1);
+        int sourceHeight = levelHeight(target - 1);
+        int targetOffset = static_cast<int>(pyramidLevelOffset(target));
+        int targetWidth = levelWidth(target);
+
+        clSetKernelArg(downsample_kernel, 0, sizeof(cl_mem), &grid_cpu_mem[slot]);
+        clSetKernelArg(downsample_kernel, 1, sizeof(cl_mem), &pyramid_mem);
+        clSetKernelArg(downsample_kernel, 2, sizeof(int), &fromGrid);
+        clSetKernelArg(downsample_kernel, 3, sizeof(int), &sourceOffset);
+        clSetKernelArg(downsample_kernel, 4, sizeof(int), &sourceWidth);
+        clSetKernelArg(downsample_kernel, 5, sizeof(int), &sourceHeight);
+        clSetKernelArg(downsample_kernel, 6, sizeof(int), &targetOffset);
+        clSetKernelArg(downsample_kernel, 7, sizeof(int), &targetWidth);
+        clSetKernelArg(downsample_kernel, 8, sizeof(int), &rect.x0);
+        clSetKernelArg(downsample_kernel, 9, sizeof(int), &rect.y0);
+        clSetKernelArg(downsample_kernel, 10, sizeof(int), &rect.x1);
+        clSetKernelArg(downsample_kernel, 11, sizeof(int), &rect.y1);
+
+        // The pixel queue is in order, so only the first level has to wait for the copy
+        size_t global[2] = {static_cast<size_t>(rect.x1 - rect.x0), static_cast<size_t>(rect.y1 - rect.y0)};
+        cl_event downsample_event;
+        cl_int err = clEnqueueNDRangeKernel(cpu_commands, downsample_kernel, 2, NULL, global, NULL,
+                                            fromGrid ? 1 : 0, fromGrid ? &copy_event : NULL, &downsample_event);
+        if (err != CL_SUCCESS) {
+            printf("Error: Failed to launch downsample kernel!\n");
+            return 0;
+        }
+        traceDeviceEvent("Downsample", TRACK_PIXEL_QUEUE, downsample_event);
+        clReleaseEvent(downsample_event);
+    }
+    return 1;
+}
+
+// Colour the viewport into cpu_pixel_buffer_mem[slot], pixel_event may be NULL
+uint enqueuePixelUpdate(cl_event *pixel_event, int slot) {
+    // ----------------- Copy grid N+K to "CPU" buffer on the device -----------------
+    // Leaves grid_mem free for the next frame's generations while the pixels are coloured
+    cl_event copy_event;
+    cl_int err = clEnqueueCopyBuffer(gpu_commands, grid_mem, grid_cpu_mem[slot], 0, 0,
+                                     sizeof(cell_t) * WIDTH * HEIGHT, 0, NULL, &copy_event);
+    if (err != CL_SUCCESS) {
+        printf("Error: Failed to copy grid to CPU-grid buffer!\n");
+        return 0;
+    }
+    clFlush(gpu_commands);
+
+    if (!enqueueDownsample(slot, copy_event)) {
+        clReleaseEvent(copy_event);
+        return 0;
+    }
+
+    // ----------------- Execute "CPU" kernel -----------------
+    int viewW = viewWidth();
+    int viewH = viewHeight();
+    int level = viewLevel(viewport);
+    int levelOffset = level > 0 ? static_cast<int>(pyramidLevelOffset(level)) : 0;
+    int levelW = levelWidth(level);
+    int levelH = levelHeight(level);
+    int originX, originY;
+    viewOrigin(viewport, originX, originY);
+    int magnify = std::max(viewport.zoom, 0);
+    size_t global[2] = {static_cast<size_t>(viewW), static_cast<size_t>(viewH)};
+
+    clSetKernelArg(pixels_update_kernel, 0, sizeof(cl_mem), &grid_cpu_mem[slot]);
+    clSetKernelArg(pixels_update_kernel, 1, sizeof(cl_mem), &pyramid_mem);
+    clSetKernelArg(pixels_update_kernel, 2, sizeof(cl_mem), &cpu_pixel_buffer_mem[slot]);
+    clSetKernelArg(pixels_update_kernel, 3, sizeof(int), &WIDTH);
+    clSetKernelArg(pixels_update_kernel, 4, sizeof(int), &HEIGHT);
+    clSetKernelArg(pixels_update_kernel, 5, sizeof(cl_mem), &palette_mem);
+    clSetKernelArg(pixels_update_kernel, 6, sizeof(int), &viewW);
+    clSetKernelArg(pixels_update_kernel, 7, sizeof(int), &viewH);
+    clSetKernelArg(pixels_update_kernel, 8, sizeof(int), &level);
+    clSetKernelArg(pixels_update_kernel, 9, sizeof(int), &levelOffset);
+    clSetKernelArg(pixels_update_kernel, 10, sizeof(int), &levelW);
+    clSetKernelArg(pixels_update_kernel, 11, sizeof(int), &levelH);
+    clSetKernelArg(pixels_update_kernel, 12, sizeof(int), &originX);
+    clSetKernelArg(pixels_update_kernel, 13, sizeof(int), &originY);
+    clSetKernelArg(pixels_update_kernel, 14, sizeof(int), &magnify);
+
+    cl_event kernel_event;
+    err = clEnqueueNDRangeKernel(cpu_commands, pixels_update_kernel,
+                                 2, NULL, global, NULL,
+                                 1, &copy_event, &kernel_event);
+    traceDeviceEvent("Copy grid", TRACK_GPU_QUEUE, copy_event);
+    clReleaseEvent(copy_event);
+    if (err != CL_SUCCESS) {
+        printf("Error: Failed to launch pixel kernel!\n");
+        return 0;
+    }
+
+    traceDeviceEvent("Colour pixels", TRACK_PIXEL_QUEUE, kernel_event);
+    if (pixel_event != NULL) {
+        *pixel_event = kernel_event;
+    }
+    else {
+        clReleaseEvent(kernel_event);
+    }
+    return 1;
+}
+
+// Fused frames: every generation runs gameOfLifeColoured, and only the last one writes pixels
+uint enqueueFusedFrame(int count, cl_event *first_event, cl_event *last_event, cl_event *pixel_event, int slot) {
+    cl_int err;
+    size_t global[2] = {static_cast<size_t>(WIDTH), static_cast<size_t>(HEIGHT)};
+
+    clSetKernelArg(fused_update_kernel, 2, sizeof(int), &WIDTH);
+    clSetKernelArg(fused_update_kernel, 3, sizeof(int), &HEIGHT);
+    clSetKernelArg(fused_update_kernel, 4, sizeof(int), &NUMBER_OF_SPECIES);
+    clSetKernelArg(fused_update_kernel, 5, sizeof(cl_mem), &palette_mem);
+    clSetKernelArg(fused_update_kernel, 6, sizeof(cl_mem), &cpu_pixel_buffer_mem[slot]);
+
+    cl_event colour_event;
+    for (int generation = 0; generation < count; generation++) {
+        int writePixels = generation == count - 1;
+        clSetKernelArg(fused_update_kernel, 0, sizeof(cl_mem), &grid_mem);
+        clSetKernelArg(fused_update_kernel, 1, sizeof(cl_mem), &next_grid_mem);
+        clSetKernelArg(fused_update_kernel, 7, sizeof(int), &writePixels);
+
+        // The colouring launch is always kept, it ends both the batch and the frame
+        cl_event *event = writePixels ? &colour_event : (generation == 0 ? first_event : NULL);
+        err = clEnqueueNDRangeKernel(gpu_commands, fused_update_kernel, 2, NULL, global, NULL, 0, NULL, event);
+        if (err != CL_SUCCESS) {
+            printf("Error: Failed to launch fused kernel!\n");
+            return 0;
+        }
+
+        // grid_mem now refers to the newest generation
+        std::swap(grid_mem, next_grid_mem);
+    }
+
+    if (count == 1 && first_event) {
+        *first_event = colour_event;
+        clRetainEvent(colour_event);
+    }
+    if (last_event) {
+        *last_event = colour_event;
+        clRetainEvent(colour_event);
+    }
+    traceDeviceEvent("Colour pixels", TRACK_GPU_QUEUE, colour_event);
+    if (pixel_event != NULL) {
+        *pixel_event = colour_event;
+    }
+    else {
+        clReleaseEvent(colour_event);
+    }
+    return 1;
+}
+
+uint enqueueFrame(int count, cl_event *first_event, cl_event *last_event, cl_event *pixel_event, int slot) {
+    if (FUSED_PIXELS) return enqueueFusedFrame(count, first_event, last_event, pixel_event, slot);
+
+    if (!enqueueGenerations(count, first_event, last_event)) return 0;
+    return enqueuePixelUpdate(pixel_event, slot);
+}
+
+uint stepFrame(int count) {
+    // Only profile the batch when someone is looking at the trace
+    bool traced = tracingEnabled();
+    cl_event first_event = NULL, last_event = NULL;
+    if (!enqueueFrame(count, traced ? &first_event : NULL, traced ? &last_event : NULL, NULL, 0)) return 0;
+    if (traced) {
+        traceDeviceSpan("Generations", TRACK_GPU_QUEUE, first_event, last_event);
+        clReleaseEvent(first_event);
+        clReleaseEvent(last_event);
+    }
+
+    TraceScope scope("Wait for queues");
+    clFinish(gpu_commands);
+    clFinish(cpu_commands);
+    return 1;
+}
+
+// ----------- CYCLE DETECTION ----------- //
+
+// Fingerprint grid_mem into the partials of batch slot slot
+uint enqueueFingerprint(int slot) {
+    int cellCount = WIDTH * HEIGHT;
+    int firstPartial = slot * FINGERPRINT_GROUPS;
+    size_t global = static_cast<size_t>(FINGERPRINT_GROUPS) * FINGERPRINT_LOCAL_SIZE;
+    size_t local = FINGERPRINT_LOCAL_SIZE;
+
+    clSetKernelArg(fingerprint_kernel, 0, sizeof(cl_mem), &grid_mem);
+    clSetKernelArg(fingerprint_kernel, 1, sizeof(cl_mem), &fingerprint_partials_mem);
+    clSetKernelArg(fingerprint_kernel, 2, sizeof(int), &cellCount);
+    clSetKernelArg(fingerprint_kernel, 3, sizeof(int), &firstPartial);
+    clSetKernelArg(fingerprint_kernel, 4, sizeof(cl_ulong) * FINGERPRINT_LOCAL_SIZE, NULL);
+    cl_int err = clEnqueueNDRangeKernel(gpu_commands, fingerprint_kernel, 1, NULL, &global, &local, 0, NULL, NULL);
+    if (err != CL_SUCCESS) {
+        printf("Error: Failed to launch fingerprint kernel!\n");
+        return 0;
+    }
+    return 1;
+}
+
+// Read back the partials of count slots in one transfer and finish the reduction
+uint readFingerprints(int count, uint64_t *fingerprints) {
+    std::vector<cl_ulong> partials(static_cast<size_t>(count) * FINGERPRINT_GROUPS);
+    cl_int err = clEnqueueReadBuffer(gpu_commands, fingerprint_partials_mem, CL_TRUE, 0,
+                                     sizeof(cl_ulong) * partials.size(), partials.data(), 0, NULL, NULL);
+    if (err != CL_SUCCESS) {
+        printf("Error: Failed to read back fingerprints!\n");
+        return 0;
+    }
+
+    for (int slot = 0; slot < count; slot++) {
+        uint64_t fingerprint = 0;
+        for (int group = 0; group < FINGERPRINT_GROUPS; group++) {
+            fingerprint ^= partials[static_cast<size_t>(slot) * FINGERPRINT_GROUPS + group];
+        }
+        fingerprints[slot] = fingerprint;
+    }
+    return 1;
+}
+
+uint gridFingerprint(uint64_t &fingerprint) {
+    if (ENGINE != ENGINE_OPENCL) {
+        if (!readGridToHost()) return 0;
+        fingerprint = cpuGridFingerprint(grid);
+        return 1;
+    }
+    return enqueueFingerprint(0) && readFingerprints(1, &fingerprint);
+}
+
+uint stepGenerationsFingerprinted(int count, uint64_t *fingerprints, bool colour) {
+    TraceScope scope("Fingerprinted generations");
+
+    // The host grid is the engine's own grid, or gathered from the devices
+    if (ENGINE != ENGINE_OPENCL) {
+        for (int generation = 0; generation < count; generation++) {
+            if (!stepGenerations(1) || !gridFingerprint(fingerprints[generation])) return 0;
+        }
+        return 1;
+    }
+
+    if (count > GENERATIONS_PER_FRAME) {
+        printf("Error: Can't fingerprint more than %d generations at once!\n", GENERATIONS_PER_FRAME);
+        return 0;
+    }
+
+    // Each fingerprint follows its generation in the queue, the host only waits once for all of them
+    for (int generation = 0; generation < count; generation++) {
+        bool last = generation == count - 1;
+        uint ok = colour && last ? enqueueFrame(1, NULL, NULL, NULL, 0) : enqueueGenerations(1, NULL, NULL);
+        if (!ok || !enqueueFingerprint(generation)) return 0;
+    }
+
+    if (!readFingerprints(count, fingerprints)) return 0;
+    if (colour) clFinish(cpu_commands);
+    return 1;
+}
+
+// ----------- STATISTICS ----------- //
+
+bool startStats(uint64_t generation) {
+    statsGeneration = generation;
+    if (STATS_PATH == nullptr) return true;
+
+    statsStream = std::make_unique<StatsStream>(STATS_PATH, STATS_FORMAT, NUMBER_OF_SPECIES);
+    if (!statsStream->isOpen()) {
+        statsStream.reset();
+        return false;
+    }
+    return true;
+}
+
+void setStatsGeneration(uint64_t generation) {
+    statsGeneration = generation;
+}
+
+void finishStats() {
+    if (!statsStream) return;
+
+    // Oldest batch first, so the stream stays in generation order
+    for (int i = 0; i < STATS_RING_SIZE; i++) {
+        writeStatsBatch(statsBatches[(nextStatsBatch + i) % STATS_RING_SIZE]);
+    }
+    statsStream.reset();
+}
+
+// Write out a batch once its read-back has landed, a no-op for a batch with nothing pending
+uint writeStatsBatch(StatsBatch &batch) {
+    if (batch.read_event == NULL) return 1;
+
+    cl_int err;
+    {
+        TraceScope scope("Wait for statistics");
+        err = clWaitForEvents(1, &batch.read_event);
+    }
+    clReleaseEvent(batch.read_event);
+    batch.read_event = NULL;
+    if (err != CL_SUCCESS) {
+        printf("Error: Failed to read back statistics!\n");
+        return 0;
+    }
+
+    for (int generation = 0; generation < batch.count; generation++) {
+        statsStream->write(batch.firstGeneration + generation, batch.host.data() + generation * STATS_SLOT_SIZE);
+    }
+    statsStream->flush();
+    return 1;
+}
+
+// Every generation is followed by generationStats on (previous, current). The ping-pong
+// updates leave the previous generation in next_grid_mem, the bitboard and padded updates
+// overwrite grid_mem in place, so it is copied first. The counters are read back without
+// waiting and written out when the ring comes back round to the batch.
+uint enqueueGenerationsWithStats(int count, cl_event *first_event, cl_event *last_event) {
+    // The counter buffers hold GENERATIONS_PER_FRAME generations, longer runs take several batches
+    if (count > GENERATIONS_PER_FRAME) {
+        for (int done = 0; done < count; done += GENERATIONS_PER_FRAME) {
+            int batchCount = std::min(GENERATIONS_PER_FRAME, count - done);
+            cl_event *first = done == 0 ? first_event : NULL;
+            cl_event *last = done + batchCount == count ? last_event : NULL;
+            if (!enqueueGenerationsWithStats(batchCount, first, last)) return 0;
+        }
+        return 1;
+    }
+
+    StatsBatch &batch = statsBatches[nextStatsBatch];
+    if (!writeStatsBatch(batch)) return 0;
+
+    cl_uint zero = 0;
+    cl_int err = clEnqueueFillBuffer(gpu_commands, batch.counters, &zero, sizeof(zero), 0,
+                                     sizeof(cl_uint) * count * STATS_SLOT_SIZE, 0, NULL, NULL);
+    if (err != CL_SUCCESS) {
+        printf("Error: Failed to clear statistics!\n");
+        return 0;
+    }
+
+    bool copyPrevious = BITBOARD || PADDED;
+    int torus = BOUNDARY == BOUNDARY_TORUS;
+    size_t local[2] = {STATS_LOCAL_WIDTH, STATS_LOCAL_HEIGHT};
+    size_t global[2] = {(static_cast<size_t>(WIDTH) + local[0] - 1) / local[0] * local[0],
+                        (static_cast<size_t>(HEIGHT) + local[1] - 1) / local[1] * local[1]};
+    clSetKernelArg(stats_kernel, 2, sizeof(cl_mem), &batch.counters);
+    clSetKernelArg(stats_kernel, 3, sizeof(int), &WIDTH);
+    clSetKernelArg(stats_kernel, 4, sizeof(int), &HEIGHT);
+    clSetKernelArg(stats_kernel, 5, sizeof(int), &NUMBER_OF_SPECIES);
+    clSetKernelArg(stats_kernel, 6, sizeof(int), &torus);
+    clSetKernelArg(stats_kernel, 8, sizeof(cl_uint) * STATS_SLOT_SIZE, NULL);
+
+    for (int generation = 0; generation < count; generation++) {
+        if (copyPrevious) {
+            err = clEnqueueCopyBuffer(gpu_commands, grid_mem, stats_previous_mem, 0, 0,
+                                      sizeof(cell_t) * WIDTH * HEIGHT, 0, NULL, NULL);
+            if (err != CL_SUCCESS) {
+                printf("Error: Failed to copy the previous generation!\n");
+                return 0;
+            }
+        }
+
+        // Only profile the first and last update of the batch
+        cl_event *first = generation == 0 ? first_event : NULL;
+        cl_event *last = generation == count - 1 ? last_event : NULL;
+        if (!enqueueUpdate(1, first, last)) return 0;
+
+        cl_mem previous = copyPrevious ? stats_previous_mem : next_grid_mem;
+        clSetKernelArg(stats_kernel, 0, sizeof(cl_mem), &previous);
+        clSetKernelArg(stats_kernel, 1, sizeof(cl_mem), &grid_mem);
+        clSetKernelArg(stats_kernel, 7, sizeof(int), &generation);
+        err = clEnqueueNDRangeKernel(gpu_commands, stats_kernel, 2, NULL, global, local, 0, NULL, NULL);
+        if (err != CL_SUCCESS) {
+            printf("Error: Failed to launch statistics kernel!\n");
+            return 0;
+        }
+    }
+
+    err = clEnqueueReadBuffer(gpu_commands, batch.counters, CL_FALSE, 0, sizeof(cl_uint) * count * STATS_SLOT_SIZE,
+                              batch.host.data(), 0, NULL, &batch.read_event);
+    if (err != CL_SUCCESS) {
+        printf("Error: Failed to read back statistics!\n");
+        return 0;
+    }
+    batch.firstGeneration = statsGeneration + 1;
+    batch.count = count;
+    statsGeneration += count;
+    nextStatsBatch = (nextStatsBatch + 1) % STATS_RING_SIZE;
+    return 1;
+}
@@ -0,0 +1,54 @@
+#ifndef FINAL_PROJECT_ENGINE_H
+#define FINAL_PROJECT_ENGINE_H
+
+#include <vector>
+#include <OpenCL/opencl.h>
+
+#include "Configs.h"
+
+// The simulation itself, with no window attached: engine selection, the host
+// grid, and the OpenCL path that keeps generations on the device. Used by the
+// main executable and the benchmark.
+
+// ----------- OPENCL ----------- //
+extern cl_command_queue gpu_commands;
+extern cl_command_queue cpu_commands;
+extern cl_mem cpu_pixel_buffer_mem[MAX_PIPELINE_DEPTH];    // Colours written by enqueuePixelUpdate, per frame in flight
+
+// ----------- ENGINE SELECTION ----------- //
+void initialiseEngine();        // Falls back to the CPU engine when ENGINE can't be set up
+void tuneEngine();              // Autotunes the tiled kernel, needs the grid on the device
+void cleanupEngine();           // Releases everything, initialiseEngine() may be called again afterwards
+
+// ----------- GAME OF LIFE ----------- //
+extern std::vector<cell_t> grid;    // Host copy of the species IDs, only synced when needed
+
+uint initialiseGrid();            // Seeds the grid, or loads PATTERN_PATH, on the current engine
+uint uploadGridToDevice();
+uint readGridToHost();
+uint enqueueGenerations(int count, cl_event *first_event, cl_event *last_event);
+uint stepGenerations(int count);                    // Runs count generations and waits for them
+uint enqueuePixelUpdate(cl_event *pixel_event, int slot);   // OpenCL engine only, pixel_event may be NULL
+
+// OpenCL engine only: count generations, with the last one coloured into cpu_pixel_buffer_mem[slot].
+// With FUSED_PIXELS the update writes the pixels itself, otherwise the grid is copied and coloured
+// on the "CPU" queue. Any of the events may be NULL.
+uint enqueueFrame(int count, cl_event *first_event, cl_event *last_event, cl_event *pixel_event, int slot);
+uint stepFrame(int count);      // enqueueFrame() into slot 0, then waits for both queues
+
+// ----------- STATISTICS ----------- //
+// With STATS_PATH set, every generation's per-species statistics (see Stats.h) are streamed to it.
+// The OpenCL engine counts them on the device alongside the update and reads them back asynchronously.
+bool startStats(uint64_t generation);       // Opens the stream, generation is the grid's current generation
+void setStatsGeneration(uint64_t generation);   // The grid was moved to generation without running the rest
+void finishStats();                         // Writes the batches still being read back and closes the stream
+
+// ----------- CYCLE DETECTION ----------- //
+// Fingerprints for CycleDetector, reduced on the device for the OpenCL engine.
+// The OpenCL engine can fingerprint up to GENERATIONS_PER_FRAME generations per call.
+uint gridFingerprint(uint64_t &fingerprint);        // Fingerprint of the current grid
+// Runs count generations one at a time, fingerprinting each into fingerprints[0..count).
+// With colour, the last one is also coloured into cpu_pixel_buffer_mem[0] like stepFrame().
+uint stepGenerationsFingerprinted(int count, uint64_t *fingerprints, bool colour);
+
+#endif
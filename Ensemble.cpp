@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <OpenCL/opencl.h>
+
+#include "Ensemble.h"
+#include "Configs.h"
+#include "CycleDetector.h"
+#include "KernelSource.h"
+#include "ProgramCache.h"
+#include "Seeding.h"
+
+namespace {
+    // Work-group shape, the launch is rounded up to it so no group spans two instances
+    constexpr size_t LOCAL_WIDTH = 16;
+    constexpr size_t LOCAL_HEIGHT = 8;
+
+    // Must match EnsembleInstance and EnsembleStatus in KernelSource.h
+    struct EnsembleInstance {
+        cl_int offset;
+        cl_int width;
+        cl_int height;
+        cl_int numSpecies;
+    };
+    struct EnsembleStatus {
+        cl_uint population[2];
+        cl_int lastChanged;
+        cl_uint reserved;
+    };
+    static_assert(sizeof(EnsembleInstance) == 16 && sizeof(EnsembleStatus) == 16,
+                  "Ensemble descriptors must stay 16 bytes");
+
+    struct InstanceParameters {
+        int width;
+        int height;
+        int numSpecies;
+        unsigned int seed;
+    };
+
+    // Byte offsets into the state buffer: half 0, the status records, half 1
+    struct EnsembleLayout {
+        size_t halfBytes = 0;
+        size_t statusBase = 0;
+        size_t halfBase[2] = {0, 0};
+        size_t totalBytes = 0;
+    };
+
+    struct EnsembleState {
+        cl_device_id device = NULL;
+        cl_context context = NULL;
+        cl_command_queue queue = NULL;
+        cl_program program = NULL;
+        cl_kernel kernel = NULL;
+        cl_mem state = NULL;
+        cl_mem instances = NULL;
+
+        ~EnsembleState() {
+            if (instances) clReleaseMemObject(instances);
+            if (state) clReleaseMemObject(state);
+            if (kernel) clReleaseKernel(kernel);
+            if (program) clReleaseProgram(program);
+            if (queue) clReleaseCommandQueue(queue);
+            if (context) clReleaseContext(context);
+        }
+    };
+
+    // One instance per line: width height species seed, '#' starts a comment
+    bool readInstanceFile(const char *path, std::vector<InstanceParameters> &instances) {
+        std::ifstream file(path);
+        if (!file) {
+            printf("Error: Failed to open ensemble file %s!\n", path);
+            return false;
+        }
+
+        std::string line;
+        for (int lineNumber = 1; std::getline(file, line); lineNumber++) {
+            line = line.substr(0, line.find('#'));
+            if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+
+            std::istringstream fields(line);
+            InstanceParameters instance;
+            std::string trailing;
+            if (!(fields >> instance.width >> instance.height >> instance.numSpecies >> instance.seed) ||
+                fields >> trailing || instance.width < 1 || instance.height < 1 ||
+                instance.numSpecies < 5 || instance.numSpecies > 10) {
+                printf("Error: Line %d of %s must be 'width height species seed' with 5-10 species!\n",
+                       lineNumber, path);
+                return false;
+            }
+            instances.push_back(instance);
+        }
+
+        if (instances.empty()) {
+            printf("Error: Ensemble file %s lists no instances!\n", path);
+            return false;
+        }
+        return true;
+    }
+
+    bool initialiseEnsembleDevice(EnsembleState &state) {
+        cl_int err;
+
+        // Prefer a GPU, the point of batching is filling a wide device
+        err = clGetDeviceIDs(NULL, CL_DEVICE_TYPE_GPU, 1, &state.device, NULL);
+        if (err != CL_SUCCESS) err = clGetDeviceIDs(NULL, CL_DEVICE_TYPE_ALL, 1, &state.device, NULL);
+        if (err != CL_SUCCESS) {
+            printf("Error: Failed to find an OpenCL device for the ensemble!\n");
+            return false;
+        }
+
+        state.context = clCreateContext(0, 1, &state.device, NULL, NULL, &err);
+        if (!state.context) {
+            printf("Error: Failed to create a compute context!\n");
+            return false;
+        }
+        state.queue = clCreateCommandQueue(state.context, state.device, 0, &err);
+        if (!state.queue) {
+            printf("Error: Failed to create a command queue!\n");
+            return false;
+        }
+
+        const char *sources[2] = {cellRuleSource, ensembleKernelSource};
+        state.program = buildProgram(state.context, state.device, sources, 2, NULL);
+        if (!state.program) {
+            printf("Error: Failed to build ensemble program!\n");
+            return false;
+        }
+        state.kernel = clCreateKernel(state.program, "gameOfLifeEnsemble", &err);
+        if (!state.kernel) {
+            printf("Error: Failed to create ensemble kernel!\n");
+            return false;
+        }
+        return true;
+    }
+
+    // Seed every instance into half 0 the same way as initialiseGrid, and reset its status
+    void seedInstances(const std::vector<InstanceParameters> &parameters,
+                       const std::vector<EnsembleInstance> &instances,
+                       const EnsembleLayout &layout, std::vector<unsigned char> &host) {
+        for (size_t i = 0; i < instances.size(); i++) {
+            cell_t *grid = reinterpret_cast<cell_t *>(host.data() + layout.halfBase[0] + instances[i].offset);
+            seedCells(grid, static_cast<size_t>(instances[i].width) * instances[i].height, parameters[i].seed,
+                      instances[i].numSpecies);
+
+            // Generation -1 counts as odd, so a run of 0 generations reports the seeded population
+            EnsembleStatus *status = reinterpret_cast<EnsembleStatus *>(host.data() + layout.statusBase) + i;
+            status->population[0] = 0;
+            status->population[1] = static_cast<cl_uint>(instances[i].width * instances[i].height);
+            status->lastChanged = -1;
+            status->reserved = 0;
+        }
+    }
+}
+
+bool runEnsemble() {
+    std::vector<InstanceParameters> parameters;
+    if (ENSEMBLE_PATH != nullptr) {
+        if (!readInstanceFile(ENSEMBLE_PATH, parameters)) return false;
+    }
+    else {
+        for (int i = 0; i < ENSEMBLE_SIZE; i++) {
+            parameters.push_back({WIDTH, HEIGHT, NUMBER_OF_SPECIES, SEED + static_cast<unsigned int>(i)});
+        }
+    }
+
+    // Grids are packed back to back in each half, the kernel indexes the buffer with int
+    EnsembleLayout layout;
+    std::vector<EnsembleInstance> instances;
+    size_t maxWidth = 0, maxHeight = 0;
+    for (const InstanceParameters &instance : parameters) {
+        size_t cells = static_cast<size_t>(instance.width) * instance.height;
+        if (layout.halfBytes + cells > INT_MAX / 2) {
+            printf("Error: The ensemble's grids are too large for one buffer!\n");
+            return false;
+        }
+        instances.push_back({static_cast<cl_int>(layout.halfBytes), instance.width, instance.height,
+                             instance.numSpecies});
+        layout.halfBytes += cells;
+        maxWidth = std::max(maxWidth, static_cast<size_t>(instance.width));
+        maxHeight = std::max(maxHeight, static_cast<size_t>(instance.height));
+    }
+    layout.statusBase = (layout.halfBytes + sizeof(EnsembleStatus) - 1) / sizeof(EnsembleStatus) * sizeof(EnsembleStatus);
+    layout.halfBase[0] = 0;
+    layout.halfBase[1] = layout.statusBase + sizeof(EnsembleStatus) * instances.size();
+    layout.totalBytes = layout.halfBase[1] + layout.halfBytes;
+    if (layout.totalBytes > INT_MAX) {
+        printf("Error: The ensemble's grids are too large for one buffer!\n");
+        return false;
+    }
+
+    EnsembleState state;
+    if (!initialiseEnsembleDevice(state)) return false;
+
+    std::vector<unsigned char> host(layout.totalBytes);
+    seedInstances(parameters, instances, layout, host);
+
+    cl_int err;
+    state.state = clCreateBuffer(state.context, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+                                 layout.totalBytes, host.data(), &err);
+    state.instances = clCreateBuffer(state.context, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+                                     sizeof(EnsembleInstance) * instances.size(), instances.data(), &err);
+    if (!state.state || !state.instances) {
+        printf("Error: Failed to allocate ensemble memory!\n");
+        return false;
+    }
+
+    std::cout << "Running " << GENERATIONS << " generations of " << instances.size() << " instances ("
+              << layout.halfBytes << " cells) in one " << maxWidth << "x" << maxHeight << "x"
+              << instances.size() << " launch per generation\n";
+
+    size_t local[3] = {LOCAL_WIDTH, LOCAL_HEIGHT, 1};
+    size_t global[3] = {(maxWidth + LOCAL_WIDTH - 1) / LOCAL_WIDTH * LOCAL_WIDTH,
+                        (maxHeight + LOCAL_HEIGHT - 1) / LOCAL_HEIGHT * LOCAL_HEIGHT,
+                        instances.size()};
+    int statusBase = static_cast<int>(layout.statusBase);
+    clSetKernelArg(state.kernel, 0, sizeof(cl_mem), &state.state);
+    clSetKernelArg(state.kernel, 1, sizeof(cl_mem), &state.instances);
+    clSetKernelArg(state.kernel, 4, sizeof(int), &statusBase);
+
+    int current = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int generation = 0; generation < GENERATIONS; generation++) {
+        int currentBase = static_cast<int>(layout.halfBase[current]);
+        int nextBase = static_cast<int>(layout.halfBase[1 - current]);
+        clSetKernelArg(state.kernel, 2, sizeof(int), &currentBase);
+        clSetKernelArg(state.kernel, 3, sizeof(int), &nextBase);
+        clSetKernelArg(state.kernel, 5, sizeof(int), &generation);
+        err = clEnqueueNDRangeKernel(state.queue, state.kernel, 3, NULL, global, local, 0, NULL, NULL);
+        if (err != CL_SUCCESS) {
+            printf("Error: Failed to launch ensemble kernel!\n");
+            return false;
+        }
+        current = 1 - current;
+
+        // Nothing comes back between generations, just keep the device fed
+        if ((generation + 1) % GENERATIONS_PER_FRAME == 0) clFlush(state.queue);
+    }
+
+    // The status records sit next to either half, so one read covers the final grids and the flags
+    size_t readBegin = current == 0 ? 0 : layout.statusBase;
+    size_t readEnd = current == 0 ? layout.halfBase[1] : layout.totalBytes;
+    err = clEnqueueReadBuffer(state.queue, state.state, CL_TRUE, readBegin, readEnd - readBegin,
+                              host.data() + readBegin, 0, NULL, NULL);
+    if (err != CL_SUCCESS) {
+        printf("Error: Failed to read back the ensemble!\n");
+        return false;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    // An instance's last launch was the one that found no change, or the final generation
+    int settledCount = 0;
+    printf("instance,width,height,species,seed,population,status,settled_generation,fingerprint\n");
+    for (size_t i = 0; i < instances.size(); i++) {
+        const EnsembleStatus &status = reinterpret_cast<const EnsembleStatus *>(host.data() + layout.statusBase)[i];
+        bool settled = status.lastChanged < GENERATIONS - 1;
+        int lastLaunch = std::min(status.lastChanged + 1, GENERATIONS - 1);
+        cl_uint population = status.population[lastLaunch & 1];
+
+        const cell_t *grid = reinterpret_cast<const cell_t *>(host.data() + layout.halfBase[current] + instances[i].offset);
+        uint64_t fingerprint = 0;
+        for (int cellIndex = 0; cellIndex < instances[i].width * instances[i].height; cellIndex++) {
+            if (grid[cellIndex] != -1) fingerprint ^= cellFingerprint(cellIndex, grid[cellIndex]);
+        }
+
+        const char *outcome = !settled ? "running" : population == 0 ? "extinct" : "settled";
+        settledCount += settled ? 1 : 0;
+        printf("%zu,%d,%d,%d,%u,%u,%s,", i, instances[i].width, instances[i].height, instances[i].numSpecies,
+               parameters[i].seed, population, outcome);
+        if (settled) printf("%d", status.lastChanged + 1);
+        printf(",%016llx\n", static_cast<unsigned long long>(fingerprint));
+    }
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double cellUpdates = static_cast<double>(layout.halfBytes) * GENERATIONS;
+
+    std::cout << "Ensemble Run Info:\n";
+    std::cout << "\tTotal runtime:\t\t\t" << seconds << "s\n";
+    std::cout << "\tGenerations/second:\t\t" << GENERATIONS / seconds << "\n";
+    std::cout << "\tCells/second:\t\t\t" << cellUpdates / seconds << "\n";
+    std::cout << "\tSettled or extinct:\t\t" << settledCount << " of " << instances.size() << "\n";
+    return true;
+}
@@ -0,0 +1,21 @@
+#ifndef FINAL_PROJECT_ENSEMBLE_H
+#define FINAL_PROJECT_ENSEMBLE_H
+
+// Ensemble runs: many small, independent grids stepped together for
+// parameter studies. Every instance has its own size, species count and seed,
+// and all of them live in one device buffer that a single 3D NDRange launch
+// updates per generation, so small grids still fill the device and the
+// program is only built once. Each instance is seeded and updated exactly as
+// a standalone run with the same parameters would be.
+//
+// The buffer holds the two halves of the ping-pong with the per-instance
+// status records between them, so the final grids and the status records are
+// read back together in one transfer whichever half ends up current. An
+// instance whose grid stopped changing is reported as settled (or extinct,
+// if nothing is left alive) and costs nothing more to run.
+
+// Run GENERATIONS generations of ENSEMBLE_SIZE copies of the WIDTH x HEIGHT grid
+// with consecutive seeds from SEED, or of the instances listed in ENSEMBLE_PATH
+bool runEnsemble();
+
+#endif
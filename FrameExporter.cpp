@@ -0,0 +1,213 @@
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+#include "FrameExporter.h"
+#include "Trace.h"
+
+namespace {
+    constexpr size_t RING_SIZE = 4;         // Frames buffered between the simulation and the writer
+    constexpr int DELTA_TILE_SIZE = 32;     // Delta mode compares and stores 32x32 pixel tiles
+    constexpr uint32_t DELTA_VERSION = 1;
+
+    // Delta stream header, followed per frame by: generation (u64), changed tile count (u32),
+    // then for each changed tile its index (u32) and its RGB rows, clipped at the grid edge
+    struct DeltaHeader {
+        char magic[8];          // "GOLDELTA"
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint32_t tileSize;
+    };
+    static_assert(sizeof(DeltaHeader) == 24, "Delta header must stay 24 bytes");
+
+    // BT.601 limited-range RGB to YCbCr
+    inline unsigned char lumaOf(int r, int g, int b) { return static_cast<unsigned char>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16); }
+    inline unsigned char blueDifferenceOf(int r, int g, int b) { return static_cast<unsigned char>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128); }
+    inline unsigned char redDifferenceOf(int r, int g, int b) { return static_cast<unsigned char>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128); }
+}
+
+FrameExporter::FrameExporter(const char *path, FrameFormat format, int width, int height)
+        : format(format), width(width), height(height), ring(RING_SIZE) {
+    // Also works for a named pipe, which blocks here until a reader opens it
+    output = std::fopen(path, "wb");
+    if (output == nullptr) {
+        printf("Error: Failed to open %s for frame export!\n", path);
+        return;
+    }
+
+    for (Frame &frame : ring) frame.pixels.resize(static_cast<size_t>(width) * height * 3);
+
+    bool headerWritten = true;
+    if (format == FRAME_Y4M) {
+        headerWritten = std::fprintf(output, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, FRAME_RATE) > 0;
+    }
+    else if (format == FRAME_DELTA) {
+        DeltaHeader header = {};
+        std::memcpy(header.magic, "GOLDELTA", 8);
+        header.version = DELTA_VERSION;
+        header.width = width;
+        header.height = height;
+        header.tileSize = DELTA_TILE_SIZE;
+        headerWritten = std::fwrite(&header, sizeof(header), 1, output) == 1;
+    }
+    if (!headerWritten) {
+        printf("Error: Failed to write the frame export header!\n");
+        std::fclose(output);
+        output = nullptr;
+        return;
+    }
+
+    writer = std::thread(&FrameExporter::writerLoop, this);
+}
+
+FrameExporter::~FrameExporter() {
+    if (output == nullptr) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    frameQueued.notify_one();
+    writer.join();
+
+    std::fclose(output);
+    std::cout << "Exported " << written << " frames (" << dropped << " dropped while the writer was busy)\n";
+}
+
+unsigned char *FrameExporter::acquireFrame() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (output == nullptr || failed || queued == ring.size()) {
+        dropped++;
+        acquired = false;
+        return nullptr;
+    }
+
+    // The buffer after the newest queued frame is free, the writer never touches it
+    acquired = true;
+    return ring[(oldest + queued) % ring.size()].pixels.data();
+}
+
+void FrameExporter::submitFrame(uint64_t generation) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!acquired) return;
+        ring[(oldest + queued) % ring.size()].generation = generation;
+        queued++;
+        acquired = false;
+    }
+    frameQueued.notify_one();
+}
+
+void FrameExporter::writerLoop() {
+    traceNameThread("Frame writer");
+    while (true) {
+        Frame *frame;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            frameQueued.wait(lock, [this] { return queued > 0 || stopping; });
+            if (queued == 0) return;
+            frame = &ring[oldest];
+        }
+
+        // The frame stays counted as queued while it is written, so it can't be handed out again
+        bool ok = writeFrame(*frame);
+
+        std::lock_guard<std::mutex> lock(mutex);
+        oldest = (oldest + 1) % ring.size();
+        queued--;
+        if (!ok && !failed) {
+            printf("Error: Failed to write frame, stopping export!\n");
+            failed = true;
+        }
+        if (ok) written++;
+    }
+}
+
+bool FrameExporter::writeFrame(const Frame &frame) {
+    TraceScope scope("Write frame");
+    if (failed) return false;
+    switch (format) {
+        case FRAME_PPM: return writePpm(frame);
+        case FRAME_Y4M: return writeY4m(frame);
+        case FRAME_DELTA: return writeDelta(frame);
+    }
+    return false;
+}
+
+// Pixel rows are bottom-up like glDrawPixels, image formats are top-down
+bool FrameExporter::writePpm(const Frame &frame) {
+    if (std::fprintf(output, "P6\n%d %d\n255\n", width, height) < 0) return false;
+
+    size_t rowBytes = static_cast<size_t>(width) * 3;
+    for (int y = height - 1; y >= 0; y--) {
+        if (std::fwrite(frame.pixels.data() + y * rowBytes, 1, rowBytes, output) != rowBytes) return false;
+    }
+    return std::fflush(output) == 0;
+}
+
+bool FrameExporter::writeY4m(const Frame &frame) {
+    size_t planeSize = static_cast<size_t>(width) * height;
+    scratch.resize(planeSize * 3);
+    unsigned char *luma = scratch.data();
+    unsigned char *blueDifference = luma + planeSize;
+    unsigned char *redDifference = blueDifference + planeSize;
+
+    size_t outIndex = 0;
+    for (int y = height - 1; y >= 0; y--) {
+        const unsigned char *pixel = frame.pixels.data() + static_cast<size_t>(y) * width * 3;
+        for (int x = 0; x < width; x++, pixel += 3, outIndex++) {
+            luma[outIndex] = lumaOf(pixel[0], pixel[1], pixel[2]);
+            blueDifference[outIndex] = blueDifferenceOf(pixel[0], pixel[1], pixel[2]);
+            redDifference[outIndex] = redDifferenceOf(pixel[0], pixel[1], pixel[2]);
+        }
+    }
+
+    if (std::fputs("FRAME\n", output) < 0) return false;
+    if (std::fwrite(scratch.data(), 1, scratch.size(), output) != scratch.size()) return false;
+    return std::fflush(output) == 0;
+}
+
+// Tiles in grid row order, tile index = tileY * tilesX + tileX. The first frame stores every tile.
+bool FrameExporter::writeDelta(const Frame &frame) {
+    int tilesX = (width + DELTA_TILE_SIZE - 1) / DELTA_TILE_SIZE;
+    int tilesY = (height + DELTA_TILE_SIZE - 1) / DELTA_TILE_SIZE;
+    size_t rowBytes = static_cast<size_t>(width) * 3;
+    bool keyframe = previousFrame.empty();
+
+    std::vector<uint32_t> changedTiles;
+    for (int tileY = 0; tileY < tilesY; tileY++) {
+        for (int tileX = 0; tileX < tilesX; tileX++) {
+            int x0 = tileX * DELTA_TILE_SIZE;
+            int y0 = tileY * DELTA_TILE_SIZE;
+            size_t tileRowBytes = static_cast<size_t>(std::min(DELTA_TILE_SIZE, width - x0)) * 3;
+            int tileRows = std::min(DELTA_TILE_SIZE, height - y0);
+
+            bool changed = keyframe;
+            for (int row = 0; row < tileRows && !changed; row++) {
+                size_t offset = (y0 + row) * rowBytes + x0 * 3;
+                changed = std::memcmp(frame.pixels.data() + offset, previousFrame.data() + offset, tileRowBytes) != 0;
+            }
+            if (changed) changedTiles.push_back(static_cast<uint32_t>(tileY * tilesX + tileX));
+        }
+    }
+
+    uint32_t changedCount = static_cast<uint32_t>(changedTiles.size());
+    if (std::fwrite(&frame.generation, sizeof(frame.generation), 1, output) != 1) return false;
+    if (std::fwrite(&changedCount, sizeof(changedCount), 1, output) != 1) return false;
+    for (uint32_t tileIndex : changedTiles) {
+        int x0 = (tileIndex % tilesX) * DELTA_TILE_SIZE;
+        int y0 = (tileIndex / tilesX) * DELTA_TILE_SIZE;
+        size_t tileRowBytes = static_cast<size_t>(std::min(DELTA_TILE_SIZE, width - x0)) * 3;
+        int tileRows = std::min(DELTA_TILE_SIZE, height - y0);
+
+        if (std::fwrite(&tileIndex, sizeof(tileIndex), 1, output) != 1) return false;
+        for (int row = 0; row < tileRows; row++) {
+            const unsigned char *source = frame.pixels.data() + (y0 + row) * rowBytes + x0 * 3;
+            if (std::fwrite(source, 1, tileRowBytes, output) != tileRowBytes) return false;
+        }
+    }
+
+    previousFrame = frame.pixels;
+    return std::fflush(output) == 0;
+}
@@ -0,0 +1,70 @@
+#ifndef FINAL_PROJECT_FRAMEEXPORTER_H
+#define FINAL_PROJECT_FRAMEEXPORTER_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Configs.h"
+
+// Streams RGB frames (the writeViewport layout) to a file or named pipe
+// as concatenated binary PPMs, a Y4M video, or a delta stream that only
+// stores the tiles that changed since the previous frame.
+//
+// Frames live in a small ring of reusable buffers. The simulation fills a
+// free buffer and submits it; a dedicated writer thread does the conversion,
+// encoding and I/O. When every buffer is still queued the frame is dropped
+// instead of blocking the simulation.
+class FrameExporter {
+public:
+    FrameExporter(const char *path, FrameFormat format, int width, int height);
+    ~FrameExporter();   // Writes every queued frame, then closes the output and reports totals
+
+    FrameExporter(const FrameExporter&) = delete;
+    FrameExporter& operator=(const FrameExporter&) = delete;
+
+    bool isOpen() const { return output != nullptr; }
+
+    // WIDTH x HEIGHT x 3 bytes to fill with the next frame, nullptr if the writer is behind
+    unsigned char *acquireFrame();
+    // Queue the frame returned by the last acquireFrame()
+    void submitFrame(uint64_t generation);
+
+private:
+    struct Frame {
+        std::vector<unsigned char> pixels;
+        uint64_t generation = 0;
+    };
+
+    void writerLoop();
+    bool writeFrame(const Frame &frame);
+    bool writePpm(const Frame &frame);
+    bool writeY4m(const Frame &frame);
+    bool writeDelta(const Frame &frame);
+
+    FrameFormat format;
+    int width;
+    int height;
+    FILE *output = nullptr;
+
+    std::vector<Frame> ring;
+    size_t oldest = 0;          // Next frame for the writer
+    size_t queued = 0;          // Frames submitted and not yet written
+    bool acquired = false;
+    std::mutex mutex;
+    std::condition_variable frameQueued;
+    std::thread writer;
+    bool stopping = false;
+    bool failed = false;
+    uint64_t dropped = 0;
+
+    // Writer thread only
+    std::vector<unsigned char> scratch;         // Y4M planes
+    std::vector<unsigned char> previousFrame;   // Last frame written in delta mode
+    uint64_t written = 0;
+};
+
+#endif
@@ -1,10 +1,37 @@
 #ifndef FINAL_PROJECT_KERNELSOURCE_H
 #define FINAL_PROJECT_KERNELSOURCE_H
 
+// Run constants for the whole-grid kernels (gameOfLife, writeViewport,
+// gameOfLifeColoured, gameOfLifeTiled, gameOfLifeActiveTiles, generationStats
+// and the padded kernels), which must be built with this source in front of
+// them. The engine builds them with -D GOL_WIDTH/GOL_HEIGHT/GOL_NUM_SPECIES, so
+// the compiler sees a fixed grid and species count and can unroll the species
+// loops and fold the bounds checks. Without the defines the kernel arguments of
+// the same name are used.
+const char *const specialisationSource = R"(
+        #ifdef GOL_WIDTH
+        #define GRID_WIDTH GOL_WIDTH
+        #else
+        #define GRID_WIDTH width
+        #endif
+
+        #ifdef GOL_HEIGHT
+        #define GRID_HEIGHT GOL_HEIGHT
+        #else
+        #define GRID_HEIGHT height
+        #endif
+
+        #ifdef GOL_NUM_SPECIES
+        #define NUM_SPECIES GOL_NUM_SPECIES
+        #else
+        #define NUM_SPECIES num_species
+        #endif
+)";
+
 // GPU kernel code
-const char *gpuKernelSource = R"(
-        __kernel void gameOfLife(__global const int* current_species,
-                                __global int* next_species,
+const char *const gpuKernelSource = R"(
+        __kernel void gameOfLife(__global const char* current_species,
+                                __global char* next_species,
                                 const int width, const int height,
                                 const int num_species) {
 
@@ -12,10 +39,10 @@ const char *gpuKernelSource = R"(
             int y = get_global_id(1);
 
             // Return if (x, y) is outside of grid
-            if (x >= width || y >= height) return;
+            if (x >= GRID_WIDTH || y >= GRID_HEIGHT) return;
 
             // Get linear cell index
-            int cellIndex = y * width + x;
+            int cellIndex = y * GRID_WIDTH + x;
 
             // Store local copy of species info
             int current_cell_species = current_species[cellIndex];
@@ -35,8 +62,8 @@ const char *gpuKernelSource = R"(
                 for(int i = 0; i < 8; i++) {
                     neighbourXCoord = xCoords[i];
                     neighbourYCoord = yCoords[i];
-                    if(neighbourXCoord >= 0 && neighbourXCoord < width && neighbourYCoord >= 0 && neighbourYCoord < height) {
-                        int neighbourIndex = neighbourYCoord * width + neighbourXCoord;
+                    if(neighbourXCoord >= 0 && neighbourXCoord < GRID_WIDTH && neighbourYCoord >= 0 && neighbourYCoord < GRID_HEIGHT) {
+                        int neighbourIndex = neighbourYCoord * GRID_WIDTH + neighbourXCoord;
                         if (current_species[neighbourIndex] == target_species) {
                             count++;
                         }
@@ -52,8 +79,8 @@ const char *gpuKernelSource = R"(
                         neighbourXCoord = xCoords[i];
                         neighbourYCoord = yCoords[i];
 
-                        if (neighbourXCoord >= 0 && neighbourXCoord < width && neighbourYCoord >= 0 && neighbourYCoord < height) {
-                            int neighbourIndex = neighbourYCoord * width + neighbourXCoord;
+                        if (neighbourXCoord >= 0 && neighbourXCoord < GRID_WIDTH && neighbourYCoord >= 0 && neighbourYCoord < GRID_HEIGHT) {
+                            int neighbourIndex = neighbourYCoord * GRID_WIDTH + neighbourXCoord;
                             int species_id = current_species[neighbourIndex];
                             if (species_id > 0) {
                                 species_count[species_id - 1]++;
@@ -67,7 +94,7 @@ const char *gpuKernelSource = R"(
 
                 // Store the index of all the species that satisfy the
                 // condition for new life.
-                for (int i = 0; i < num_species; i++) {
+                for (int i = 0; i < NUM_SPECIES; i++) {
                     if (species_count[i] == 3) {
                         reproductionConditionMet[num_candidates++] = i + 1;
                     }
@@ -85,72 +112,928 @@ const char *gpuKernelSource = R"(
                     // Pick candidate
                     int selected = reproductionConditionMet[hash % num_candidates];
 
-                    next_species[cellIndex] = selected;
+                    next_species[cellIndex] = (char)selected;
                 }
             }
         }
 )";
 
-const char *cpuKernelSource = R"(
-        __kernel void writeToPixelBuffer(__global const int* species_data,
-                                __global uchar *cpu_pixel_buffer,
-                                const int width, const int height) {
+const char *const cpuKernelSource = R"(
+        #define OUTSIDE_COLOUR (uchar3)(32, 32, 32)
+
+        // Pyramid texel of a cell, see Viewport.h
+        uchar2 cellTexel(int species) {
+            return (species >= 1 && species <= 10) ? (uchar2)((uchar)species, 255) : (uchar2)(0, 0);
+        }
+
+        // Texel of a 2 x 2 block of count children, the others are (0, 0). Matches Viewport.h.
+        uchar2 reduceTexels(uchar2 children[4], int count) {
+            uint weight[11] = {0};
+            uint density = 0;
+            for (int i = 0; i < 4; i++) {
+                density += children[i].y;
+                weight[children[i].x] += children[i].y;
+            }
+
+            // Ties go to the lowest species
+            uchar species = 0;
+            uint best = 0;
+            for (int candidate = 1; candidate <= 10; candidate++) {
+                if (weight[candidate] > best) {
+                    best = weight[candidate];
+                    species = (uchar)candidate;
+                }
+            }
+            return (uchar2)(species, (uchar)(density / count));
+        }
+
+        // Texels [x0, x1) x [y0, y1) of one pyramid level from the level below it,
+        // which is the grid itself when from_grid is set
+        __kernel void downsampleLevel(__global const char* species_data, __global uchar2* pyramid,
+                                      const int from_grid, const int source_offset,
+                                      const int source_width, const int source_height,
+                                      const int target_offset, const int target_width,
+                                      const int x0, const int y0, const int x1, const int y1) {
+            int x = x0 + get_global_id(0);
+            int y = y0 + get_global_id(1);
+            if (x >= x1 || y >= y1) return;
+
+            uchar2 children[4] = {(uchar2)(0, 0), (uchar2)(0, 0), (uchar2)(0, 0), (uchar2)(0, 0)};
+            int count = 0;
+            for (int dy = 0; dy < 2; dy++) {
+                for (int dx = 0; dx < 2; dx++) {
+                    int sx = 2 * x + dx;
+                    int sy = 2 * y + dy;
+                    if (sx >= source_width || sy >= source_height) continue;
+                    int sourceIndex = sy * source_width + sx;
+                    children[count++] = from_grid ? cellTexel(species_data[sourceIndex])
+                                                  : pyramid[source_offset + sourceIndex];
+                }
+            }
+            pyramid[target_offset + y * target_width + x] = reduceTexels(children, count);
+        }
+
+        // Colour the window's pixels. Level 0 reads the grid, magnified 2^magnify times,
+        // higher levels read their pyramid texels one per pixel.
+        __kernel void writeViewport(__global const char* species_data,
+                                    __global const uchar2* pyramid,
+                                    __global uchar *cpu_pixel_buffer,
+                                    const int width, const int height,
+                                    __constant uchar *palette,
+                                    const int view_width, const int view_height,
+                                    const int level, const int level_offset,
+                                    const int level_width, const int level_height,
+                                    const int origin_x, const int origin_y, const int magnify) {
 
             int x = get_global_id(0);
             int y = get_global_id(1);
 
-            // Return if (x, y) is outside of grid
-            if (x >= width || y >= height) return;
+            // Return if (x, y) is outside of the window
+            if (x >= view_width || y >= view_height) return;
 
-            // Get linear cell index
-            int cellIndex = y * width + x;
+            int texelX = origin_x + (x >> magnify);
+            int texelY = origin_y + (y >> magnify);
 
-            int speciesID = species_data[cellIndex];
             uchar3 cellColour;
-            switch(speciesID) {
-                case -1:
-                    cellColour = (uchar3)(53,27,8);     // DEAD: Saddle brown
-                    break;
-                case 1:
-                    cellColour = (uchar3)(216,191,216); // SPECIES 1: Thistle
-                    break;
-                case 2:
-                    cellColour = (uchar3)(95,158,160);  // SPECIES 2: Cadet blue
-                    break;
-                case 3:
-                    cellColour = (uchar3)(46,139,87);   // SPECIES 3: Sea green
-                    break;
-                case 4:
-                    cellColour = (uchar3)(245,222,179); // SPECIES 4: Wheat
-                    break;
-                case 5:
-                    cellColour = (uchar3)(189,183,107); // SPECIES 5: Dark khaki
-                    break;
-                case 6:
-                    cellColour = (uchar3)(255,215,0);   // SPECIES 6: Gold
-                    break;
-                case 7:
-                    cellColour = (uchar3)(255,69,0);    // SPECIES 7: Orange red
-                    break;
-                case 8:
-                    cellColour = (uchar3)(178,34,34);   // SPECIES 8: Firebrick
-                    break;
-                case 9:
-                    cellColour = (uchar3)(219,112,147); // SPECIES 9: Pale violet red
-                    break;
-                case 10:
-                    cellColour = (uchar3)(139,0,0);     // SPECIES 10: Dark red
-                    break;
-                default:
+            if (texelX < 0 || texelX >= level_width || texelY < 0 || texelY >= level_height) {
+                cellColour = OUTSIDE_COLOUR;
+            } else if (level == 0) {
+                // Palette built from CELL_COLOURS, index 0 is the dead colour
+                int speciesID = species_data[texelY * GRID_WIDTH + texelX];
+                int paletteIndex = speciesID == -1 ? 0 : speciesID;
+                if (paletteIndex < 0 || paletteIndex > 10) {
                     cellColour = (uchar3)(255, 0, 255); // ERROR: Magenta
+                } else {
+                    cellColour = (uchar3)(palette[paletteIndex * 3 + 0],
+                                          palette[paletteIndex * 3 + 1],
+                                          palette[paletteIndex * 3 + 2]);
+                }
+            } else {
+                // Species colour blended with the dead colour by the block's live fraction
+                uchar2 texel = pyramid[level_offset + texelY * level_width + texelX];
+                uint3 live = (uint3)(palette[texel.x * 3 + 0], palette[texel.x * 3 + 1], palette[texel.x * 3 + 2]);
+                uint3 dead = (uint3)(palette[0], palette[1], palette[2]);
+                uint3 blended = (live * texel.y + dead * (255 - texel.y) + 127) / 255;
+                cellColour = convert_uchar3(blended);
             }
 
-            // Each cell is 3 bytes in pixel buffer (r, g, b)
-            int pixelBufferIndex = cellIndex * 3;
+            // Each pixel is 3 bytes in pixel buffer (r, g, b)
+            int pixelBufferIndex = (y * view_width + x) * 3;
             cpu_pixel_buffer[pixelBufferIndex + 0] = cellColour.x;
             cpu_pixel_buffer[pixelBufferIndex + 1] = cellColour.y;
             cpu_pixel_buffer[pixelBufferIndex + 2] = cellColour.z;
         }
 )";
 
+// Update and colour in one pass: the last generation of a frame writes its pixels
+// directly, so the grid is never copied or read a second time. Needs cellRuleSource.
+const char *const fusedKernelSource = R"(
+        __kernel void gameOfLifeColoured(__global const char* current_species,
+                                         __global char* next_species,
+                                         const int width, const int height,
+                                         const int num_species,
+                                         __constant uchar* palette,
+                                         __global uchar* pixel_buffer,
+                                         const int write_pixels) {
+
+            int x = get_global_id(0);
+            int y = get_global_id(1);
+
+            // Return if (x, y) is outside of grid
+            if (x >= GRID_WIDTH || y >= GRID_HEIGHT) return;
+
+            int cellIndex = y * GRID_WIDTH + x;
+            char next_cell_species = nextCellState(current_species, GRID_WIDTH, GRID_HEIGHT, NUM_SPECIES, x, y, cellIndex);
+            next_species[cellIndex] = next_cell_species;
+
+            // Generations in between frames are never drawn
+            if (!write_pixels) return;
+
+            // The next state is always dead or a valid species, index 0 is the dead colour
+            int paletteIndex = next_cell_species == -1 ? 0 : next_cell_species;
+            int pixelBufferIndex = cellIndex * 3;
+            pixel_buffer[pixelBufferIndex + 0] = palette[paletteIndex * 3 + 0];
+            pixel_buffer[pixelBufferIndex + 1] = palette[paletteIndex * 3 + 1];
+            pixel_buffer[pixelBufferIndex + 2] = palette[paletteIndex * 3 + 2];
+        }
+)";
+
+// Bit-sliced bitboard kernels: one bitplane per species, 64 cells per ulong.
+// Kept separate from gameOfLife, which stays the reference implementation.
+const char *const bitboardKernelSource = R"(
+        // 32-bit PCG hash, same tie-break as gameOfLife
+        uint pcgHash(uint seed) {
+            uint state = seed * 747796405u + 2891336453u;
+            uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+            return (word >> 22u) ^ word;
+        }
+
+        void fullAdder(ulong a, ulong b, ulong c, ulong *sum, ulong *carry) {
+            ulong partial = a ^ b;
+            *sum = partial ^ c;
+            *carry = (a & b) | (partial & c);
+        }
+
+        __kernel void packBitplanes(__global const char* species,
+                                    __global ulong* planes,
+                                    const int width, const int height,
+                                    const int words_per_row, const int num_species) {
+            int w = get_global_id(0);
+            int y = get_global_id(1);
+            if (w >= words_per_row || y >= height) return;
+
+            ulong words[10] = {0};
+            int x_begin = w * 64;
+            int x_end = min(x_begin + 64, width);
+            for (int x = x_begin; x < x_end; x++) {
+                int species_id = species[y * width + x];
+                if (species_id > 0 && species_id <= num_species) {
+                    words[species_id - 1] |= (ulong)1 << (x - x_begin);
+                }
+            }
+
+            size_t plane_size = (size_t)words_per_row * height;
+            for (int i = 0; i < num_species; i++) {
+                planes[i * plane_size + y * words_per_row + w] = words[i];
+            }
+        }
+
+        __kernel void unpackBitplanes(__global const ulong* planes,
+                                      __global char* species,
+                                      const int width, const int height,
+                                      const int words_per_row, const int num_species) {
+            int w = get_global_id(0);
+            int y = get_global_id(1);
+            if (w >= words_per_row || y >= height) return;
+
+            size_t plane_size = (size_t)words_per_row * height;
+            ulong words[10];
+            for (int i = 0; i < num_species; i++) {
+                words[i] = planes[i * plane_size + y * words_per_row + w];
+            }
+
+            int x_begin = w * 64;
+            int x_end = min(x_begin + 64, width);
+            for (int x = x_begin; x < x_end; x++) {
+                char species_id = -1;
+                for (int i = 0; i < num_species; i++) {
+                    if ((words[i] >> (x - x_begin)) & 1) species_id = (char)(i + 1);
+                }
+                species[y * width + x] = species_id;
+            }
+        }
+
+        __kernel void bitboardGameOfLife(__global const ulong* current_planes,
+                                         __global ulong* next_planes,
+                                         const int width, const int height,
+                                         const int words_per_row, const int num_species) {
+            int w = get_global_id(0);
+            int y = get_global_id(1);
+            if (w >= words_per_row || y >= height) return;
+
+            size_t plane_size = (size_t)words_per_row * height;
+            size_t word_index = (size_t)y * words_per_row + w;
+            ulong valid = (w == words_per_row - 1 && width % 64 != 0) ? (((ulong)1 << (width % 64)) - 1) : ~(ulong)0;
+
+            ulong occupied = 0;
+            for (int i = 0; i < num_species; i++) {
+                occupied |= current_planes[i * plane_size + word_index];
+            }
+            ulong dead = ~occupied & valid;
+
+            ulong births[10];
+            ulong seen = 0, tied = 0;
+
+            for (int i = 0; i < num_species; i++) {
+                __global const ulong* plane = current_planes + i * plane_size;
+
+                // Shifted neighbour words: x - 1, x + 1 for every row, plus the rows above and below
+                ulong neighbours[8];
+                int n = 0;
+                for (int row = y - 1; row <= y + 1; row++) {
+                    ulong centre = 0, left = 0, right = 0;
+                    if (row >= 0 && row < height) {
+                        centre = plane[row * words_per_row + w];
+                        left = w > 0 ? plane[row * words_per_row + w - 1] : 0;
+                        right = w + 1 < words_per_row ? plane[row * words_per_row + w + 1] : 0;
+                    }
+                    neighbours[n++] = (centre << 1) | (left >> 63);
+                    neighbours[n++] = (centre >> 1) | (right << 63);
+                    if (row != y) neighbours[n++] = centre;
+                }
+
+                // Bit-sliced neighbour count = ones + 2 * twos + 4 * fours + 8 * eights
+                ulong sum_a, carry_a, sum_b, carry_b, carry_ones, ones, sum_twos, carry_twos;
+                fullAdder(neighbours[0], neighbours[1], neighbours[2], &sum_a, &carry_a);
+                fullAdder(neighbours[3], neighbours[4], neighbours[5], &sum_b, &carry_b);
+                ulong sum_c = neighbours[6] ^ neighbours[7];
+                ulong carry_c = neighbours[6] & neighbours[7];
+                fullAdder(sum_a, sum_b, sum_c, &ones, &carry_ones);
+                fullAdder(carry_a, carry_b, carry_c, &sum_twos, &carry_twos);
+                ulong twos = sum_twos ^ carry_ones;
+                ulong carry_fours = sum_twos & carry_ones;
+                ulong fours = carry_twos ^ carry_fours;
+                ulong eights = carry_twos & carry_fours;
+
+                // Survival with 2 or 3 neighbours, birth with exactly 3
+                ulong two_or_three = twos & ~fours & ~eights;
+                births[i] = dead & two_or_three & ones;
+                tied |= seen & births[i];
+                seen |= births[i];
+
+                next_planes[i * plane_size + word_index] = (plane[word_index] & two_or_three) | (births[i] & ~tied);
+            }
+
+            // Resolve cells where several species can be born with the PCG hash
+            if (tied) {
+                for (int i = 0; i < num_species; i++) {
+                    next_planes[i * plane_size + word_index] &= ~tied;
+                }
+                while (tied) {
+                    ulong cell_bit = tied & (~tied + 1);
+                    int bit = 63 - clz(cell_bit);
+
+                    int reproductionConditionMet[10];
+                    int num_candidates = 0;
+                    for (int i = 0; i < num_species; i++) {
+                        if (births[i] & cell_bit) reproductionConditionMet[num_candidates++] = i;
+                    }
+
+                    uint hash = pcgHash((uint)(y * width + w * 64 + bit));
+                    int selected = reproductionConditionMet[hash % num_candidates];
+                    next_planes[selected * plane_size + word_index] |= cell_bit;
+
+                    tied &= tied - 1;
+                }
+            }
+        }
+)";
+
+// Tiled variant of gameOfLife: each work-group loads its tile plus a 1-cell
+// halo into local memory once, instead of every work-item reading its 8
+// neighbours from global memory. Cells outside the grid are loaded as dead,
+// which counts the same as the bounds checks in gameOfLife.
+const char *const tiledKernelSource = R"(
+        __kernel void gameOfLifeTiled(__global const char* current_species,
+                                      __global char* next_species,
+                                      const int width, const int height,
+                                      const int num_species,
+                                      __local char* tile) {
+
+            int x = get_global_id(0);
+            int y = get_global_id(1);
+            int local_x = get_local_id(0);
+            int local_y = get_local_id(1);
+            int local_width = get_local_size(0);
+            int local_height = get_local_size(1);
+
+            // Tile covers the work-group plus a 1-cell halo on every side
+            int tile_width = local_width + 2;
+            int tile_size = tile_width * (local_height + 2);
+            int tile_origin_x = get_group_id(0) * local_width - 1;
+            int tile_origin_y = get_group_id(1) * local_height - 1;
+
+            for (int i = local_y * local_width + local_x; i < tile_size; i += local_width * local_height) {
+                int global_x = tile_origin_x + i % tile_width;
+                int global_y = tile_origin_y + i / tile_width;
+                bool inside = global_x >= 0 && global_x < GRID_WIDTH && global_y >= 0 && global_y < GRID_HEIGHT;
+                tile[i] = inside ? current_species[global_y * GRID_WIDTH + global_x] : (char)-1;
+            }
+            barrier(CLK_LOCAL_MEM_FENCE);
+
+            // Return if (x, y) is outside of grid, only after helping load the tile
+            if (x >= GRID_WIDTH || y >= GRID_HEIGHT) return;
+
+            int cellIndex = y * GRID_WIDTH + x;
+            int centre = (local_y + 1) * tile_width + (local_x + 1);
+            int current_cell_species = tile[centre];
+            int neighbours[8] = {centre - tile_width - 1, centre - tile_width, centre - tile_width + 1,
+                                 centre - 1, centre + 1,
+                                 centre + tile_width - 1, centre + tile_width, centre + tile_width + 1};
+
+            if (current_cell_species != -1) {
+                int count = 0;
+                for (int i = 0; i < 8; i++) {
+                    if (tile[neighbours[i]] == current_cell_species) count++;
+                }
+                next_species[cellIndex] = (count < 2 || count > 3) ? (char)-1 : (char)current_cell_species;
+                return;
+            }
+
+            // Cell is dead - check for birth
+            int species_count[10] = {0};
+            for (int i = 0; i < 8; i++) {
+                int species_id = tile[neighbours[i]];
+                if (species_id > 0) species_count[species_id - 1]++;
+            }
+
+            int reproductionConditionMet[10];
+            int num_candidates = 0;
+            for (int i = 0; i < NUM_SPECIES; i++) {
+                if (species_count[i] == 3) {
+                    reproductionConditionMet[num_candidates++] = i + 1;
+                }
+            }
+
+            char next_cell_species = -1;
+            if (num_candidates > 0) {
+                // Same 32-bit PCG hash tie-break as gameOfLife
+                uint seed = cellIndex;
+                uint state = seed * 747796405u + 2891336453u;
+                uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+                uint hash = (word >> 22u) ^ word;
+                next_cell_species = (char)reproductionConditionMet[hash % num_candidates];
+            }
+            next_species[cellIndex] = next_cell_species;
+        }
+)";
+
+// Ghost-cell padded variant of gameOfLife, see PaddedGrid.h. The grid is kept
+// (width + 2) x (height + 2) with a one-cell border, so gameOfLifePadded reads
+// all 8 neighbours without the bounds checks. fillGhostCells refills the border
+// with dead cells, or with the opposite edge when torus is set.
+const char *const paddedKernelSource = R"(
+        __kernel void padGrid(__global const char* species,
+                              __global char* padded,
+                              const int width, const int height) {
+            int x = get_global_id(0);
+            int y = get_global_id(1);
+            if (x >= GRID_WIDTH || y >= GRID_HEIGHT) return;
+
+            padded[(y + 1) * (GRID_WIDTH + 2) + x + 1] = species[y * GRID_WIDTH + x];
+        }
+
+        __kernel void unpadGrid(__global const char* padded,
+                                __global char* species,
+                                const int width, const int height) {
+            int x = get_global_id(0);
+            int y = get_global_id(1);
+            if (x >= GRID_WIDTH || y >= GRID_HEIGHT) return;
+
+            species[y * GRID_WIDTH + x] = padded[(y + 1) * (GRID_WIDTH + 2) + x + 1];
+        }
+
+        // One work-item per ghost cell: the top and bottom rows, then the left and right columns
+        __kernel void fillGhostCells(__global char* padded,
+                                     const int width, const int height,
+                                     const int torus) {
+            int i = get_global_id(0);
+            int pitch = GRID_WIDTH + 2;
+            if (i >= 2 * pitch + 2 * GRID_HEIGHT) return;
+
+            int padded_x, padded_y;
+            if (i < 2 * pitch) {
+                padded_x = i % pitch;
+                padded_y = i < pitch ? 0 : GRID_HEIGHT + 1;
+            } else {
+                int j = i - 2 * pitch;
+                padded_x = j < GRID_HEIGHT ? 0 : GRID_WIDTH + 1;
+                padded_y = j % GRID_HEIGHT + 1;
+            }
+
+            // Ghosts only read interior cells, so the border fills in one launch
+            char species_id = -1;
+            if (torus) {
+                int source_x = (padded_x + GRID_WIDTH - 1) % GRID_WIDTH;
+                int source_y = (padded_y + GRID_HEIGHT - 1) % GRID_HEIGHT;
+                species_id = padded[(source_y + 1) * pitch + source_x + 1];
+            }
+            padded[padded_y * pitch + padded_x] = species_id;
+        }
+
+        __kernel void gameOfLifePadded(__global const char* current_padded,
+                                       __global char* next_padded,
+                                       const int width, const int height,
+                                       const int num_species) {
+
+            int x = get_global_id(0);
+            int y = get_global_id(1);
+
+            // Return if (x, y) is outside of grid
+            if (x >= GRID_WIDTH || y >= GRID_HEIGHT) return;
+
+            // The tie-break stays keyed on the unpadded index
+            int cellIndex = y * GRID_WIDTH + x;
+            int pitch = GRID_WIDTH + 2;
+            int centre = (y + 1) * pitch + x + 1;
+            int current_cell_species = current_padded[centre];
+            int neighbours[8] = {centre - pitch - 1, centre - pitch, centre - pitch + 1,
+                                 centre - 1, centre + 1,
+                                 centre + pitch - 1, centre + pitch, centre + pitch + 1};
+
+            if (current_cell_species != -1) {
+                int count = 0;
+                for (int i = 0; i < 8; i++) {
+                    if (current_padded[neighbours[i]] == current_cell_species) count++;
+                }
+                next_padded[centre] = (count < 2 || count > 3) ? (char)-1 : (char)current_cell_species;
+                return;
+            }
+
+            // Cell is dead - check for birth
+            int species_count[10] = {0};
+            for (int i = 0; i < 8; i++) {
+                int species_id = current_padded[neighbours[i]];
+                if (species_id > 0) species_count[species_id - 1]++;
+            }
+
+            int reproductionConditionMet[10];
+            int num_candidates = 0;
+            for (int i = 0; i < NUM_SPECIES; i++) {
+                if (species_count[i] == 3) {
+                    reproductionConditionMet[num_candidates++] = i + 1;
+                }
+            }
+
+            char next_cell_species = -1;
+            if (num_candidates > 0) {
+                // Same 32-bit PCG hash tie-break as gameOfLife
+                uint seed = cellIndex;
+                uint state = seed * 747796405u + 2891336453u;
+                uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+                uint hash = (word >> 22u) ^ word;
+                next_cell_species = (char)reproductionConditionMet[hash % num_candidates];
+            }
+            next_padded[centre] = next_cell_species;
+        }
+)";
+
+// Single-cell version of the gameOfLife rule, shared by the kernels below
+// that don't update the whole grid in one launch
+const char *const cellRuleSource = R"(
+        // Same rule as gameOfLife for a single cell. cell_key is the index of the
+        // cell in the whole grid, which seeds the PCG tie-break.
+        char nextCellState(__global const char* current_species, int width, int height,
+                           int num_species, int x, int y, uint cell_key) {
+            int current_cell_species = current_species[y * width + x];
+            int species_count[10] = {0};
+            int count = 0;
+
+            for (int ny = y - 1; ny <= y + 1; ny++) {
+                for (int nx = x - 1; nx <= x + 1; nx++) {
+                    if ((nx == x && ny == y) || nx < 0 || nx >= width || ny < 0 || ny >= height) continue;
+                    int species_id = current_species[ny * width + nx];
+                    if (species_id == current_cell_species) count++;
+                    if (species_id > 0) species_count[species_id - 1]++;
+                }
+            }
+
+            if (current_cell_species != -1) {
+                return (count < 2 || count > 3) ? (char)-1 : (char)current_cell_species;
+            }
+
+            int reproductionConditionMet[10];
+            int num_candidates = 0;
+            for (int i = 0; i < num_species; i++) {
+                if (species_count[i] == 3) reproductionConditionMet[num_candidates++] = i + 1;
+            }
+            if (num_candidates == 0) return -1;
+
+            uint seed = cell_key;
+            uint state = seed * 747796405u + 2891336453u;
+            uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+            uint hash = (word >> 22u) ^ word;
+            return (char)reproductionConditionMet[hash % num_candidates];
+        }
+)";
+
+// Active-tile kernels: only tiles that changed, or border a tile that changed,
+// in the last generation are recomputed. The tile size must match
+// ACTIVE_TILE_WIDTH x ACTIVE_TILE_HEIGHT in ActiveTiles.h. Needs cellRuleSource.
+const char *const activeTileKernelSource = R"(
+        #define ACTIVE_TILE_WIDTH 64
+        #define ACTIVE_TILE_HEIGHT 16
+
+        // Compact tiles that changed, or have a neighbour that changed, into a work list
+        __kernel void buildActiveTileList(__global const uchar* tile_changed,
+                                          __global int* tile_list,
+                                          __global int* tile_count,
+                                          const int tiles_x, const int tiles_y) {
+            int tile_x = get_global_id(0);
+            int tile_y = get_global_id(1);
+            if (tile_x >= tiles_x || tile_y >= tiles_y) return;
+
+            bool active = false;
+            for (int y = max(tile_y - 1, 0); y <= min(tile_y + 1, tiles_y - 1); y++) {
+                for (int x = max(tile_x - 1, 0); x <= min(tile_x + 1, tiles_x - 1); x++) {
+                    if (tile_changed[y * tiles_x + x]) active = true;
+                }
+            }
+
+            if (active) {
+                tile_list[atomic_inc(tile_count)] = tile_y * tiles_x + tile_x;
+            }
+        }
+
+        // One work-group per list slot, launched for every tile. OpenCL has no
+        // indirect dispatch, so groups past the device-side count exit at once.
+        __kernel void gameOfLifeActiveTiles(__global const char* current_species,
+                                            __global char* next_species,
+                                            const int width, const int height,
+                                            const int num_species, const int tiles_x,
+                                            __global const int* tile_list,
+                                            __global const int* tile_count,
+                                            __global uchar* next_tile_changed) {
+            int slot = get_group_id(1);
+            if (slot >= *tile_count) return;
+
+            int tile = tile_list[slot];
+            int x = (tile % tiles_x) * ACTIVE_TILE_WIDTH + get_local_id(0);
+            int y_begin = (tile / tiles_x) * ACTIVE_TILE_HEIGHT;
+            if (x >= GRID_WIDTH) return;
+
+            bool changed = false;
+            for (int y = y_begin + get_local_id(1); y < min(y_begin + ACTIVE_TILE_HEIGHT, GRID_HEIGHT); y += get_local_size(1)) {
+                int cellIndex = y * GRID_WIDTH + x;
+                char next_cell_species = nextCellState(current_species, GRID_WIDTH, GRID_HEIGHT, NUM_SPECIES, x, y, cellIndex);
+                next_species[cellIndex] = next_cell_species;
+                if (next_cell_species != current_species[cellIndex]) changed = true;
+            }
+
+            // Every writer stores the same value, so the race is harmless
+            if (changed) next_tile_changed[tile] = 1;
+        }
+)";
+
+// Strip update for out-of-core and multi-device runs. The input buffer holds
+// the strip plus one halo row above and below wherever the grid has them. The
+// strip is written output_row_offset rows into the output, so the output can
+// either hold just the strip or share the input's halo layout.
+// first_cell_key is the whole-grid index of the strip's first cell, so the
+// tie-break matches an in-core run. Needs cellRuleSource.
+const char *const stripKernelSource = R"(
+        __kernel void gameOfLifeStrip(__global const char* strip_with_halo,
+                                      __global char* next_strip,
+                                      const int width, const int buffer_rows,
+                                      const int halo_top, const int strip_rows,
+                                      const uint first_cell_key, const int num_species,
+                                      const int output_row_offset) {
+            int x = get_global_id(0);
+            int row = get_global_id(1);
+            if (x >= width || row >= strip_rows) return;
+
+            uint cell_key = first_cell_key + (uint)row * (uint)width + (uint)x;
+            next_strip[(row + output_row_offset) * width + x] = nextCellState(strip_with_halo, width, buffer_rows, num_species,
+                                                        x, row + halo_top, cell_key);
+        }
+)";
+
+// Generalised rule kernels, see Rule.h. Neighbours are counted per species
+// with two sliding-window passes, one work-item per line, so the cost per cell
+// doesn't depend on the radius. Lines run along (1, 0), (0, 1), (1, 1) or (1, -1).
+const char *const ruleKernelSource = R"(
+        int2 ruleLineStart(int line, int width, int height, int dx, int dy) {
+            if (dy == 0) return (int2)(0, line);
+            if (dx == 0) return (int2)(line, 0);
+            if (line < width) return (int2)(line, dy > 0 ? 0 : height - 1);
+            return (int2)(0, dy > 0 ? line - width + 1 : height - 2 - (line - width));
+        }
+
+        int ruleLineCount(int width, int height, int dx, int dy) {
+            if (dy == 0) return height;
+            if (dx == 0) return width;
+            return width + height - 1;
+        }
+
+        int speciesAt(__global const char* grid, int width, int height, int x, int y) {
+            return (x >= 0 && x < width && y >= 0 && y < height) ? grid[y * width + x] : -1;
+        }
+
+        // First pass: window sums of every species along one line of the sums planes,
+        // which extend padding cells past the grid on every side
+        __kernel void ruleSpeciesLineSums(__global const char* grid,
+                                          const int width, const int height,
+                                          const int num_species, const int padding,
+                                          const int dx, const int dy, const int lo, const int hi,
+                                          __global ushort* sums) {
+            int sums_width = width + 2 * padding;
+            int sums_height = height + 2 * padding;
+            int line = get_global_id(0);
+            if (line >= ruleLineCount(sums_width, sums_height, dx, dy)) return;
+
+            int2 start = ruleLineStart(line, sums_width, sums_height, dx, dy);
+            int x = start.x;
+            int y = start.y;
+            size_t plane_size = (size_t)sums_width * sums_height;
+
+            int window[10] = {0};
+            for (int t = lo; t <= hi; t++) {
+                int species = speciesAt(grid, width, height, x - padding + t * dx, y - padding + t * dy);
+                if (species > 0) window[species - 1]++;
+            }
+
+            for (; x >= 0 && x < sums_width && y >= 0 && y < sums_height; x += dx, y += dy) {
+                for (int species = 0; species < num_species; species++) {
+                    sums[species * plane_size + (size_t)y * sums_width + x] = (ushort)window[species];
+                }
+
+                int leaving = speciesAt(grid, width, height, x - padding + lo * dx, y - padding + lo * dy);
+                int entering = speciesAt(grid, width, height, x - padding + (hi + 1) * dx, y - padding + (hi + 1) * dy);
+                if (leaving > 0) window[leaving - 1]--;
+                if (entering > 0) window[entering - 1]++;
+            }
+        }
+
+        int sumAt(__global const ushort* sums, int sums_width, int sums_height, int padding, int x, int y) {
+            x += padding;
+            y += padding;
+            return (x >= 0 && x < sums_width && y >= 0 && y < sums_height) ? sums[(size_t)y * sums_width + x] : 0;
+        }
+
+        // Second pass: window sums of one species' sums along one line of the grid.
+        // Launched over (line, species).
+        __kernel void rulePlaneLineSums(__global const ushort* sums,
+                                        const int width, const int height, const int padding,
+                                        const int dx, const int dy, const int lo, const int hi,
+                                        const int shift_x, const int accumulate,
+                                        __global ushort* counts) {
+            int line = get_global_id(0);
+            int species = get_global_id(1);
+            if (line >= ruleLineCount(width, height, dx, dy)) return;
+
+            int sums_width = width + 2 * padding;
+            int sums_height = height + 2 * padding;
+            sums += species * (size_t)sums_width * sums_height;
+            counts += species * (size_t)width * height;
+
+            int2 start = ruleLineStart(line, width, height, dx, dy);
+            int x = start.x;
+            int y = start.y;
+
+            int window = 0;
+            for (int t = lo; t <= hi; t++) {
+                window += sumAt(sums, sums_width, sums_height, padding, x + shift_x + t * dx, y + t * dy);
+            }
+
+            for (; x >= 0 && x < width && y >= 0 && y < height; x += dx, y += dy) {
+                size_t cellIndex = (size_t)y * width + x;
+                counts[cellIndex] = (ushort)(accumulate ? counts[cellIndex] + window : window);
+                window += sumAt(sums, sums_width, sums_height, padding, x + shift_x + (hi + 1) * dx, y + (hi + 1) * dy)
+                        - sumAt(sums, sums_width, sums_height, padding, x + shift_x + lo * dx, y + lo * dy);
+            }
+        }
+
+        bool countAllowed(__constant uint* counts, int count_words, int count) {
+            return count >= 0 && count / 32 < count_words && ((counts[count / 32] >> (count % 32)) & 1u);
+        }
+
+        // Birth and survival from the per-species counts, which include the cell itself
+        __kernel void applyRule(__global const char* current_species,
+                                __global const ushort* counts,
+                                __global char* next_species,
+                                const int width, const int height,
+                                const int num_species,
+                                __constant uint* birth, __constant uint* survival,
+                                const int count_words, const int include_centre) {
+
+            int x = get_global_id(0);
+            int y = get_global_id(1);
+
+            // Return if (x, y) is outside of grid
+            if (x >= width || y >= height) return;
+
+            int cellIndex = y * width + x;
+            size_t plane_size = (size_t)width * height;
+            int current_cell_species = current_species[cellIndex];
+
+            if (current_cell_species != -1) {
+                int count = counts[(current_cell_species - 1) * plane_size + cellIndex] - (include_centre ? 0 : 1);
+                next_species[cellIndex] = countAllowed(survival, count_words, count) ? (char)current_cell_species : (char)-1;
+                return;
+            }
+
+            int reproductionConditionMet[10];
+            int num_candidates = 0;
+            for (int i = 0; i < num_species; i++) {
+                if (countAllowed(birth, count_words, counts[i * plane_size + cellIndex])) {
+                    reproductionConditionMet[num_candidates++] = i + 1;
+                }
+            }
+
+            char next_cell_species = -1;
+            if (num_candidates > 0) {
+                // Same 32-bit PCG hash tie-break as gameOfLife
+                uint seed = cellIndex;
+                uint state = seed * 747796405u + 2891336453u;
+                uint word = ((state >> ((state >> 28u) + 4u)) ^ state) * 277803737u;
+                uint hash = (word >> 22u) ^ word;
+                next_cell_species = (char)reproductionConditionMet[hash % num_candidates];
+            }
+            next_species[cellIndex] = next_cell_species;
+        }
+)";
+
+// Grid fingerprint for cycle detection, see CycleDetector.h. Each work-item XORs
+// the keys of a strided subset of the cells, and each work-group reduces its
+// work-items in local memory into one partial, which the host XORs together.
+// Each launch writes to partials[first_partial + group], so a whole batch of
+// generations is read back at once.
+const char *const fingerprintKernelSource = R"(
+        ulong cellFingerprint(uint cell_index, int species) {
+            ulong z = (((ulong)cell_index << 4) | (ulong)species) + 0x9E3779B97F4A7C15UL;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9UL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBUL;
+            return z ^ (z >> 31);
+        }
+
+        __kernel void gridFingerprint(__global const char* species,
+                                      __global ulong* partials,
+                                      const int cell_count, const int first_partial,
+                                      __local ulong* scratch) {
+            ulong fingerprint = 0;
+            for (int i = get_global_id(0); i < cell_count; i += get_global_size(0)) {
+                int species_id = species[i];
+                if (species_id != -1) fingerprint ^= cellFingerprint(i, species_id);
+            }
+
+            int local_id = get_local_id(0);
+            scratch[local_id] = fingerprint;
+            barrier(CLK_LOCAL_MEM_FENCE);
+            for (int stride = get_local_size(0) / 2; stride > 0; stride /= 2) {
+                if (local_id < stride) scratch[local_id] ^= scratch[local_id + stride];
+                barrier(CLK_LOCAL_MEM_FENCE);
+            }
+
+            if (local_id == 0) partials[first_partial + get_group_id(0)] = scratch[0];
+        }
+)";
+
+// Per-generation statistics, see Stats.h. Compares each cell's previous and
+// current state, counting into a __local histogram per work-group that is
+// merged into stats[slot] with one global atomic per non-zero counter. A birth
+// is contested when more than one species had exactly 3 neighbours, which is
+// only recounted for births. The slot layout must match Stats.h.
+const char *const statsKernelSource = R"(
+        #define STATS_FIELDS 4
+        #define STATS_SLOT_SIZE (10 * STATS_FIELDS)
+
+        __kernel void generationStats(__global const char* previous_species,
+                                      __global const char* current_species,
+                                      __global uint* stats,
+                                      const int width, const int height,
+                                      const int num_species, const int torus,
+                                      const int slot,
+                                      __local uint* histogram) {
+            int local_id = get_local_id(1) * get_local_size(0) + get_local_id(0);
+            int local_size = get_local_size(0) * get_local_size(1);
+            for (int i = local_id; i < STATS_SLOT_SIZE; i += local_size) histogram[i] = 0;
+            barrier(CLK_LOCAL_MEM_FENCE);
+
+            int x = get_global_id(0);
+            int y = get_global_id(1);
+            if (x < GRID_WIDTH && y < GRID_HEIGHT) {
+                int cellIndex = y * GRID_WIDTH + x;
+                int before = previous_species[cellIndex];
+                int after = current_species[cellIndex];
+
+                if (after != -1) atomic_inc(&histogram[(after - 1) * STATS_FIELDS + 0]);
+                if (before != -1 && after == -1) atomic_inc(&histogram[(before - 1) * STATS_FIELDS + 2]);
+                if (before == -1 && after != -1) {
+                    atomic_inc(&histogram[(after - 1) * STATS_FIELDS + 1]);
+
+                    int species_count[10] = {0};
+                    for (int ny = y - 1; ny <= y + 1; ny++) {
+                        for (int nx = x - 1; nx <= x + 1; nx++) {
+                            int sx = torus ? (nx + GRID_WIDTH) % GRID_WIDTH : nx;
+                            int sy = torus ? (ny + GRID_HEIGHT) % GRID_HEIGHT : ny;
+                            if ((nx == x && ny == y) || sx < 0 || sx >= GRID_WIDTH || sy < 0 || sy >= GRID_HEIGHT) continue;
+                            int species_id = previous_species[sy * GRID_WIDTH + sx];
+                            if (species_id > 0) species_count[species_id - 1]++;
+                        }
+                    }
+                    int num_candidates = 0;
+                    for (int i = 0; i < NUM_SPECIES; i++) {
+                        if (species_count[i] == 3) num_candidates++;
+                    }
+                    if (num_candidates > 1) atomic_inc(&histogram[(after - 1) * STATS_FIELDS + 3]);
+                }
+            }
+            barrier(CLK_LOCAL_MEM_FENCE);
+
+            for (int i = local_id; i < NUM_SPECIES * STATS_FIELDS; i += local_size) {
+                if (histogram[i] != 0) atomic_add(&stats[slot * STATS_SLOT_SIZE + i], histogram[i]);
+            }
+        }
+)";
+
+// Ensemble update, see Ensemble.h. One 3D launch steps every instance: x and y
+// are the cell, z the instance, and each instance reads its grid's offset,
+// size and species count from its descriptor. Work-groups never span two
+// instances, so each group counts its live cells and changes in local memory
+// and merges them into the instance's status with one global write. An
+// instance that didn't change last generation already holds its settled grid
+// in both halves and is skipped. Needs cellRuleSource.
+const char *const ensembleKernelSource = R"(
+        typedef struct {
+            int offset;                 // First cell of the instance's grid within a half
+            int width;
+            int height;
+            int num_species;
+        } EnsembleInstance;
+
+        typedef struct {
+            uint population[2];         // Live cells after even and odd generations
+            int last_changed;           // Last generation that changed the grid
+            uint reserved;
+        } EnsembleStatus;
+
+        __kernel void gameOfLifeEnsemble(__global char* state,
+                                         __global const EnsembleInstance* instances,
+                                         const int current_base, const int next_base,
+                                         const int status_base, const int generation) {
+            __local uint group_population;
+            __local int group_changed;
+
+            int x = get_global_id(0);
+            int y = get_global_id(1);
+            EnsembleInstance instance = instances[get_global_id(2)];
+            __global EnsembleStatus* status = (__global EnsembleStatus*)(state + status_base) + get_global_id(2);
+
+            // The same for the whole group, so no work-item is left waiting at the barriers
+            if (status->last_changed < generation - 1) return;
+
+            if (get_local_id(0) == 0 && get_local_id(1) == 0) {
+                group_population = 0;
+                group_changed = 0;
+            }
+            if (x == 0 && y == 0) status->population[(generation + 1) & 1] = 0;
+            barrier(CLK_LOCAL_MEM_FENCE);
+
+            if (x < instance.width && y < instance.height) {
+                __global const char* current = state + current_base + instance.offset;
+                int cellIndex = y * instance.width + x;
+                char next = nextCellState(current, instance.width, instance.height,
+                                          instance.num_species, x, y, (uint)cellIndex);
+                state[next_base + instance.offset + cellIndex] = next;
+
+                if (next != -1) atomic_inc(&group_population);
+                if (next != current[cellIndex]) group_changed = 1;
+            }
+            barrier(CLK_LOCAL_MEM_FENCE);
+
+            if (get_local_id(0) == 0 && get_local_id(1) == 0) {
+                if (group_population != 0) atomic_add(&status->population[generation & 1], group_population);
+                if (group_changed) status->last_changed = generation;
+            }
+        }
+)";
+
+// Counter-based grid seeding, see Seeding.h. Each work-item hashes its own
+// (seed, cell index), so the grid matches seedCells on the host.
+const char *const seedKernelSource = R"(
+        ulong seedMix(ulong z) {
+            z += 0x9E3779B97F4A7C15UL;
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9UL;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBUL;
+            return z ^ (z >> 31);
+        }
+
+        __kernel void seedGrid(__global char* species, const int cell_count,
+                               const ulong seed_key, const int num_species) {
+            int cellIndex = get_global_id(0);
+            if (cellIndex >= cell_count) return;
+            species[cellIndex] = (char)((seedMix(seed_key + cellIndex) >> 32) % num_species + 1);
+        }
+)";
+
 #endif
@@ -0,0 +1,389 @@
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <OpenCL/opencl.h>
+
+#include "MultiDevice.h"
+#include "KernelSource.h"
+#include "ProgramCache.h"
+
+namespace {
+    constexpr int REBALANCE_INTERVAL = 32;      // Generations between rebalancing checks
+    constexpr double REBALANCE_THRESHOLD = 0.02; // Minimum row shift, as a fraction of the grid, worth moving data for
+
+    struct Partition {
+        cl_device_id device = NULL;
+        bool subDevice = false;
+        cl_context context = NULL;
+        cl_command_queue queue = NULL;
+        cl_program program = NULL;
+        cl_kernel kernel = NULL;
+        cl_mem current = NULL;      // Rows [firstRow - haloTop, firstRow + rows + haloBottom)
+        cl_mem next = NULL;
+        size_t capacityRows = 0;
+
+        int firstRow = 0;
+        int rows = 0;
+        int haloTop = 0;
+        int haloBottom = 0;
+
+        std::vector<cell_t> topRow;     // Staging for the rows sent to the neighbours
+        std::vector<cell_t> bottomRow;
+        double kernelTime = 0;          // Microseconds since the last rebalance
+
+        int bufferRows() const { return haloTop + rows + haloBottom; }
+    };
+
+    std::vector<Partition> partitions;
+    int generationsSinceRebalance = 0;
+
+    void releaseBuffers(Partition &partition) {
+        if (partition.current) clReleaseMemObject(partition.current);
+        if (partition.next) clReleaseMemObject(partition.next);
+        partition.current = partition.next = NULL;
+        partition.capacityRows = 0;
+    }
+
+    // Assign row bands in proportion to weights, at least one row each
+    void assignRows(const std::vector<double> &weights) {
+        double totalWeight = 0;
+        for (double weight : weights) totalWeight += weight;
+
+        int firstRow = 0;
+        for (size_t i = 0; i < partitions.size(); i++) {
+            int remainingPartitions = static_cast<int>(partitions.size() - i - 1);
+            int rows = static_cast<int>(std::lround(HEIGHT * weights[i] / totalWeight));
+            rows = std::max(1, std::min(rows, HEIGHT - firstRow - remainingPartitions));
+            if (remainingPartitions == 0) rows = HEIGHT - firstRow;
+
+            Partition &partition = partitions[i];
+            partition.firstRow = firstRow;
+            partition.rows = rows;
+            partition.haloTop = firstRow > 0 ? 1 : 0;
+            partition.haloBottom = firstRow + rows < HEIGHT ? 1 : 0;
+            firstRow += rows;
+        }
+    }
+
+    bool allocateBuffers(Partition &partition) {
+        if (static_cast<size_t>(partition.bufferRows()) <= partition.capacityRows) return true;
+
+        releaseBuffers(partition);
+        cl_int err;
+        size_t bytes = static_cast<size_t>(partition.bufferRows()) * WIDTH;
+        partition.current = clCreateBuffer(partition.context, CL_MEM_READ_WRITE, bytes, NULL, &err);
+        partition.next = clCreateBuffer(partition.context, CL_MEM_READ_WRITE, bytes, NULL, &err);
+        if (!partition.current || !partition.next) {
+            printf("Error: Failed to allocate partition memory!\n");
+            return false;
+        }
+        partition.capacityRows = partition.bufferRows();
+        return true;
+    }
+
+    bool initialisePartition(Partition &partition) {
+        cl_int err;
+        partition.context = clCreateContext(0, 1, &partition.device, NULL, NULL, &err);
+        if (!partition.context) {
+            printf("Error: Failed to create a compute context!\n");
+            return false;
+        }
+
+        partition.queue = clCreateCommandQueue(partition.context, partition.device, CL_QUEUE_PROFILING_ENABLE, &err);
+        if (!partition.queue) {
+            printf("Error: Failed to create a command queue!\n");
+            return false;
+        }
+
+        const char *sources[2] = {cellRuleSource, stripKernelSource};
+        partition.program = buildProgram(partition.context, partition.device, sources, 2, NULL);
+        if (!partition.program) {
+            printf("Error: Failed to build partition program!\n");
+            return false;
+        }
+
+        partition.kernel = clCreateKernel(partition.program, "gameOfLifeStrip", &err);
+        if (!partition.kernel) {
+            printf("Error: Failed to create partition kernel!\n");
+            return false;
+        }
+
+        partition.topRow.resize(WIDTH);
+        partition.bottomRow.resize(WIDTH);
+        return true;
+    }
+
+    std::vector<cl_device_id> findDevices(int gpuCount, int cpuSubDevices, std::vector<bool> &isSubDevice) {
+        std::vector<cl_device_id> devices;
+
+        cl_uint platformCount = 0;
+        clGetPlatformIDs(0, NULL, &platformCount);
+        std::vector<cl_platform_id> platforms(platformCount);
+        clGetPlatformIDs(platformCount, platforms.data(), NULL);
+
+        // GPUs from every platform
+        for (cl_platform_id platform : platforms) {
+            cl_uint deviceCount = 0;
+            if (clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, 0, NULL, &deviceCount) != CL_SUCCESS) continue;
+            std::vector<cl_device_id> gpus(deviceCount);
+            clGetDeviceIDs(platform, CL_DEVICE_TYPE_GPU, deviceCount, gpus.data(), NULL);
+            devices.insert(devices.end(), gpus.begin(), gpus.end());
+        }
+        if (gpuCount > 0 && devices.size() > static_cast<size_t>(gpuCount)) devices.resize(gpuCount);
+        if (gpuCount < 0 && cpuSubDevices > 0) devices.clear();    // Sub-devices alone means CPU only
+        isSubDevice.assign(devices.size(), false);
+
+        // Split the first CPU device into near-equal sub-devices. Partitioning equally would create
+        // computeUnits / unitsPerSubDevice of them, more than asked for when N doesn't divide the units.
+        if (cpuSubDevices > 0) {
+            for (cl_platform_id platform : platforms) {
+                cl_device_id cpu;
+                if (clGetDeviceIDs(platform, CL_DEVICE_TYPE_CPU, 1, &cpu, NULL) != CL_SUCCESS) continue;
+
+                cl_uint computeUnits = 0;
+                cl_uint maxSubDevices = 0;
+                clGetDeviceInfo(cpu, CL_DEVICE_MAX_COMPUTE_UNITS, sizeof(cl_uint), &computeUnits, NULL);
+                clGetDeviceInfo(cpu, CL_DEVICE_PARTITION_MAX_SUB_DEVICES, sizeof(cl_uint), &maxSubDevices, NULL);
+                cl_uint count = std::min<cl_uint>(cpuSubDevices, std::min(computeUnits, maxSubDevices));
+                if (count == 0) {
+                    printf("Error: Failed to create CPU sub-devices!\n");
+                    break;
+                }
+
+                std::vector<cl_device_partition_property> properties = {CL_DEVICE_PARTITION_BY_COUNTS};
+                for (cl_uint i = 0; i < count; i++) {
+                    cl_uint units = computeUnits / count + (i < computeUnits % count ? 1 : 0);
+                    properties.push_back(static_cast<cl_device_partition_property>(units));
+                }
+                properties.push_back(CL_DEVICE_PARTITION_BY_COUNTS_LIST_END);
+                properties.push_back(0);
+
+                std::vector<cl_device_id> subDevices(count);
+                cl_uint created = 0;
+                if (clCreateSubDevices(cpu, properties.data(), count, subDevices.data(), &created) != CL_SUCCESS) {
+                    printf("Error: Failed to create CPU sub-devices!\n");
+                    break;
+                }
+                devices.insert(devices.end(), subDevices.begin(), subDevices.begin() + created);
+                isSubDevice.insert(isSubDevice.end(), created, true);
+                break;
+            }
+        }
+
+        return devices;
+    }
+
+    bool exchangeHalos() {
+        cl_int err = CL_SUCCESS;
+
+        // Boundary rows of every partition to the host
+        for (size_t i = 0; i < partitions.size(); i++) {
+            Partition &partition = partitions[i];
+            size_t firstInterior = static_cast<size_t>(partition.haloTop) * WIDTH;
+            size_t lastInterior = static_cast<size_t>(partition.haloTop + partition.rows - 1) * WIDTH;
+            if (i > 0) {
+                err |= clEnqueueReadBuffer(partition.queue, partition.current, CL_FALSE, firstInterior, WIDTH,
+                                           partition.topRow.data(), 0, NULL, NULL);
+            }
+            if (i + 1 < partitions.size()) {
+                err |= clEnqueueReadBuffer(partition.queue, partition.current, CL_FALSE, lastInterior, WIDTH,
+                                           partition.bottomRow.data(), 0, NULL, NULL);
+            }
+        }
+        for (Partition &partition : partitions) clFinish(partition.queue);
+
+        // ...and into the neighbours' halo rows
+        for (size_t i = 0; i < partitions.size(); i++) {
+            Partition &partition = partitions[i];
+            size_t bottomHalo = static_cast<size_t>(partition.haloTop + partition.rows) * WIDTH;
+            if (i > 0) {
+                err |= clEnqueueWriteBuffer(partition.queue, partition.current, CL_FALSE, 0, WIDTH,
+                                            partitions[i - 1].bottomRow.data(), 0, NULL, NULL);
+            }
+            if (i + 1 < partitions.size()) {
+                err |= clEnqueueWriteBuffer(partition.queue, partition.current, CL_FALSE, bottomHalo, WIDTH,
+                                            partitions[i + 1].topRow.data(), 0, NULL, NULL);
+            }
+        }
+
+        if (err != CL_SUCCESS) {
+            printf("Error: Failed to exchange halo rows!\n");
+            return false;
+        }
+        return true;
+    }
+
+    // Move rows towards the partitions that process them fastest
+    bool rebalance() {
+        std::vector<double> speeds;
+        for (const Partition &partition : partitions) {
+            speeds.push_back(partition.rows / std::max(partition.kernelTime, 1.0));
+        }
+
+        std::vector<Partition> previous = partitions;
+        assignRows(speeds);
+
+        int largestShift = 0;
+        for (size_t i = 0; i < partitions.size(); i++) {
+            largestShift = std::max(largestShift, std::abs(partitions[i].firstRow - previous[i].firstRow));
+        }
+        for (Partition &partition : partitions) partition.kernelTime = 0;
+        generationsSinceRebalance = 0;
+
+        if (largestShift <= std::max(1.0, HEIGHT * REBALANCE_THRESHOLD)) {
+            // Not worth moving data, keep the current split
+            for (size_t i = 0; i < partitions.size(); i++) {
+                partitions[i].firstRow = previous[i].firstRow;
+                partitions[i].rows = previous[i].rows;
+                partitions[i].haloTop = previous[i].haloTop;
+                partitions[i].haloBottom = previous[i].haloBottom;
+            }
+            return true;
+        }
+
+        // Gather with the old split and scatter with the new one
+        std::vector<Partition> newSplit = partitions;
+        partitions = previous;
+        std::vector<cell_t> grid(static_cast<size_t>(WIDTH) * HEIGHT);
+        if (!multiDeviceDownload(grid)) return false;
+        for (size_t i = 0; i < partitions.size(); i++) {
+            partitions[i].firstRow = newSplit[i].firstRow;
+            partitions[i].rows = newSplit[i].rows;
+            partitions[i].haloTop = newSplit[i].haloTop;
+            partitions[i].haloBottom = newSplit[i].haloBottom;
+        }
+
+        std::cout << "Rebalanced partitions:";
+        for (const Partition &partition : partitions) std::cout << " " << partition.rows;
+        std::cout << " rows\n";
+
+        return multiDeviceUpload(grid);
+    }
+}
+
+bool initialiseMultiDevice(int gpuCount, int cpuSubDevices) {
+    std::vector<bool> isSubDevice;
+    std::vector<cl_device_id> devices = findDevices(gpuCount, cpuSubDevices, isSubDevice);
+    if (devices.empty()) {
+        printf("Error: Failed to find any devices to partition the grid over!\n");
+        return false;
+    }
+
+    // Every partition needs at least one row
+    devices.resize(std::min(devices.size(), static_cast<size_t>(HEIGHT)));
+
+    partitions.resize(devices.size());
+    for (size_t i = 0; i < devices.size(); i++) {
+        partitions[i].device = devices[i];
+        partitions[i].subDevice = isSubDevice[i];
+        if (!initialisePartition(partitions[i])) return false;
+    }
+
+    // Start with an even split, rebalancing corrects it once kernel times are known
+    assignRows(std::vector<double>(partitions.size(), 1.0));
+
+    std::cout << "Multi-device engine initialized with " << partitions.size() << " partitions:\n";
+    for (const Partition &partition : partitions) {
+        char name[256] = {0};
+        clGetDeviceInfo(partition.device, CL_DEVICE_NAME, sizeof(name) - 1, name, NULL);
+        std::cout << "\t" << name << (partition.subDevice ? " (sub-device)" : "")
+                  << ": rows " << partition.firstRow << "-" << partition.firstRow + partition.rows - 1 << "\n";
+    }
+    return true;
+}
+
+void cleanupMultiDevice() {
+    for (Partition &partition : partitions) {
+        releaseBuffers(partition);
+        if (partition.kernel) clReleaseKernel(partition.kernel);
+        if (partition.program) clReleaseProgram(partition.program);
+        if (partition.queue) clReleaseCommandQueue(partition.queue);
+        if (partition.context) clReleaseContext(partition.context);
+        if (partition.subDevice) clReleaseDevice(partition.device);
+    }
+    partitions.clear();
+}
+
+bool multiDeviceUpload(const std::vector<cell_t> &grid) {
+    for (Partition &partition : partitions) {
+        if (!allocateBuffers(partition)) return false;
+
+        const cell_t *source = grid.data() + static_cast<size_t>(partition.firstRow - partition.haloTop) * WIDTH;
+        cl_int err = clEnqueueWriteBuffer(partition.queue, partition.current, CL_FALSE, 0,
+                                          static_cast<size_t>(partition.bufferRows()) * WIDTH,
+                                          source, 0, NULL, NULL);
+        if (err != CL_SUCCESS) {
+            printf("Error: Failed to write partition to device memory!\n");
+            return false;
+        }
+    }
+    for (Partition &partition : partitions) clFinish(partition.queue);
+    return true;
+}
+
+bool multiDeviceDownload(std::vector<cell_t> &grid) {
+    for (Partition &partition : partitions) {
+        cell_t *destination = grid.data() + static_cast<size_t>(partition.firstRow) * WIDTH;
+        cl_int err = clEnqueueReadBuffer(partition.queue, partition.current, CL_FALSE,
+                                         static_cast<size_t>(partition.haloTop) * WIDTH,
+                                         static_cast<size_t>(partition.rows) * WIDTH,
+                                         destination, 0, NULL, NULL);
+        if (err != CL_SUCCESS) {
+            printf("Error: Failed to read back partition!\n");
+            return false;
+        }
+    }
+    for (Partition &partition : partitions) clFinish(partition.queue);
+    return true;
+}
+
+bool multiDeviceStepGenerations(int count) {
+    for (int generation = 0; generation < count; generation++) {
+        if (partitions.size() > 1 && !exchangeHalos()) return false;
+
+        std::vector<cl_event> events(partitions.size());
+        for (size_t i = 0; i < partitions.size(); i++) {
+            Partition &partition = partitions[i];
+            int bufferRows = partition.bufferRows();
+            cl_uint firstCellKey = static_cast<cl_uint>(static_cast<size_t>(partition.firstRow) * WIDTH);
+
+            // Output keeps the halo layout so the buffers can ping-pong
+            clSetKernelArg(partition.kernel, 0, sizeof(cl_mem), &partition.current);
+            clSetKernelArg(partition.kernel, 1, sizeof(cl_mem), &partition.next);
+            clSetKernelArg(partition.kernel, 2, sizeof(int), &WIDTH);
+            clSetKernelArg(partition.kernel, 3, sizeof(int), &bufferRows);
+            clSetKernelArg(partition.kernel, 4, sizeof(int), &partition.haloTop);
+            clSetKernelArg(partition.kernel, 5, sizeof(int), &partition.rows);
+            clSetKernelArg(partition.kernel, 6, sizeof(cl_uint), &firstCellKey);
+            clSetKernelArg(partition.kernel, 7, sizeof(int), &NUMBER_OF_SPECIES);
+            clSetKernelArg(partition.kernel, 8, sizeof(int), &partition.haloTop);
+
+            size_t global[2] = {static_cast<size_t>(WIDTH), static_cast<size_t>(partition.rows)};
+            cl_int err = clEnqueueNDRangeKernel(partition.queue, partition.kernel, 2, NULL, global, NULL,
+                                                0, NULL, &events[i]);
+            if (err != CL_SUCCESS) {
+                printf("Error: Failed to launch partition kernel!\n");
+                return false;
+            }
+            clFlush(partition.queue);
+        }
+
+        // Devices run concurrently, collect their kernel times for rebalancing
+        for (size_t i = 0; i < partitions.size(); i++) {
+            Partition &partition = partitions[i];
+            clWaitForEvents(1, &events[i]);
+            cl_ulong start, end;
+            clGetEventProfilingInfo(events[i], CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, NULL);
+            clGetEventProfilingInfo(events[i], CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, NULL);
+            clReleaseEvent(events[i]);
+
+            partition.kernelTime += (double)(end - start) / 1000.0;
+            std::swap(partition.current, partition.next);
+        }
+
+        if (partitions.size() > 1 && ++generationsSinceRebalance >= REBALANCE_INTERVAL && !rebalance()) {
+            return false;
+        }
+    }
+    return true;
+}
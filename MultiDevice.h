@@ -0,0 +1,24 @@
+#ifndef FINAL_PROJECT_MULTIDEVICE_H
+#define FINAL_PROJECT_MULTIDEVICE_H
+
+#include <vector>
+
+#include "Configs.h"
+
+// Domain decomposition of one grid over several OpenCL devices, or over
+// sub-devices of a multicore CPU created with clCreateSubDevices. Each
+// partition owns a band of rows plus a halo row above and below, and has its
+// own context and command queue. Boundary rows are exchanged through the host
+// every generation, and partition heights are rebalanced periodically from
+// the measured per-device kernel times.
+
+// Use gpuCount GPUs (0 = every GPU found, -1 = only sub-devices if any are requested)
+// plus cpuSubDevices sub-devices of the CPU
+bool initialiseMultiDevice(int gpuCount, int cpuSubDevices);
+void cleanupMultiDevice();
+
+bool multiDeviceUpload(const std::vector<cell_t> &grid);
+bool multiDeviceDownload(std::vector<cell_t> &grid);
+bool multiDeviceStepGenerations(int count);
+
+#endif
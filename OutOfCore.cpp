@@ -0,0 +1,288 @@
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <OpenCL/opencl.h>
+
+#include "OutOfCore.h"
+#include "Configs.h"
+#include "KernelSource.h"
+#include "ProgramCache.h"
+#include "Seeding.h"
+#include "Pattern.h"
+
+namespace {
+    constexpr int NUM_QUEUES = 3;                       // Strips in flight at once
+    constexpr size_t AUTO_STRIP_BYTES = 64 << 20;       // Strip size when --strip-rows isn't given
+
+    struct StateFileHeader {
+        char magic[8];          // "GOLSTATE"
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint32_t numSpecies;
+        uint64_t generation;
+        uint32_t currentHalf;   // Which of the two grids holds the current generation
+        uint32_t reserved[7];
+    };
+    static_assert(sizeof(StateFileHeader) == 64, "State file header must stay 64 bytes");
+
+    constexpr uint32_t STATE_FILE_VERSION = 1;
+
+    struct StreamSlot {
+        cl_command_queue queue = NULL;
+        cl_mem input = NULL;        // Strip plus halo rows
+        cl_mem output = NULL;       // Next generation of the strip
+        cl_event done = NULL;       // Write-back of the last strip using this slot
+    };
+
+    struct OutOfCoreState {
+        int fd = -1;
+        unsigned char *mapping = nullptr;
+        size_t mappingSize = 0;
+
+        cl_device_id device = NULL;
+        cl_context context = NULL;
+        cl_program program = NULL;
+        cl_kernel kernel = NULL;
+        StreamSlot slots[NUM_QUEUES];
+
+        ~OutOfCoreState() {
+            for (StreamSlot &slot : slots) {
+                if (slot.done) clReleaseEvent(slot.done);
+                if (slot.input) clReleaseMemObject(slot.input);
+                if (slot.output) clReleaseMemObject(slot.output);
+                if (slot.queue) clReleaseCommandQueue(slot.queue);
+            }
+            if (kernel) clReleaseKernel(kernel);
+            if (program) clReleaseProgram(program);
+            if (context) clReleaseContext(context);
+            if (mapping) {
+                msync(mapping, mappingSize, MS_SYNC);
+                munmap(mapping, mappingSize);
+            }
+            if (fd >= 0) close(fd);
+        }
+
+        StateFileHeader *header() { return reinterpret_cast<StateFileHeader *>(mapping); }
+        cell_t *half(uint32_t index) {
+            size_t gridBytes = static_cast<size_t>(header()->width) * header()->height;
+            return reinterpret_cast<cell_t *>(mapping + sizeof(StateFileHeader) + index * gridBytes);
+        }
+    };
+
+    bool headerMatches(const StateFileHeader &header) {
+        return std::memcmp(header.magic, "GOLSTATE", 8) == 0 && header.version == STATE_FILE_VERSION &&
+               header.width == static_cast<uint32_t>(WIDTH) && header.height == static_cast<uint32_t>(HEIGHT) &&
+               header.numSpecies == static_cast<uint32_t>(NUMBER_OF_SPECIES) && header.currentHalf < 2;
+    }
+
+    // Flush the seeded grid, then mark the header valid for generation 0
+    bool stampStateFile(OutOfCoreState &state, const char *path) {
+        if (msync(state.mapping, state.mappingSize, MS_SYNC) != 0) {
+            printf("Error: Failed to write the grid to state file %s!\n", path);
+            return false;
+        }
+
+        StateFileHeader *header = state.header();
+        header->version = STATE_FILE_VERSION;
+        header->numSpecies = NUMBER_OF_SPECIES;
+        header->generation = 0;
+        header->currentHalf = 0;
+        std::memcpy(header->magic, "GOLSTATE", 8);
+        if (msync(state.mapping, sizeof(StateFileHeader), MS_SYNC) != 0) {
+            std::memset(header->magic, 0, sizeof(header->magic));
+            printf("Error: Failed to write the header of state file %s!\n", path);
+            return false;
+        }
+        return true;
+    }
+
+    bool openStateFile(OutOfCoreState &state, const char *path) {
+        size_t gridBytes = static_cast<size_t>(WIDTH) * HEIGHT;
+        state.mappingSize = sizeof(StateFileHeader) + 2 * gridBytes;
+
+        state.fd = open(path, O_RDWR | O_CREAT, 0644);
+        if (state.fd < 0) {
+            printf("Error: Failed to open state file %s!\n", path);
+            return false;
+        }
+
+        StateFileHeader existing = {};
+        bool resume = pread(state.fd, &existing, sizeof(existing), 0) == sizeof(existing) && headerMatches(existing);
+
+        if (ftruncate(state.fd, static_cast<off_t>(state.mappingSize)) != 0) {
+            printf("Error: Failed to size state file %s!\n", path);
+            return false;
+        }
+
+        void *mapping = mmap(nullptr, state.mappingSize, PROT_READ | PROT_WRITE, MAP_SHARED, state.fd, 0);
+        if (mapping == MAP_FAILED) {
+            printf("Error: Failed to map state file %s!\n", path);
+            return false;
+        }
+        state.mapping = static_cast<unsigned char *>(mapping);
+
+        if (resume) {
+            std::cout << "Resuming " << path << " at generation " << state.header()->generation << "\n";
+            return true;
+        }
+
+        // Seeded like initialiseGrid, so the grid matches an in-core run with the same seed or pattern.
+        // The magic is only written once the grid is on disk, so a run killed while seeding leaves
+        // a file the next run seeds again instead of resuming.
+        StateFileHeader *header = state.header();
+        std::memset(header, 0, sizeof(StateFileHeader));
+        header->width = WIDTH;
+        header->height = HEIGHT;
+
+        cell_t *grid = state.half(0);
+        if (PATTERN_PATH != nullptr) {
+            // A pattern that fails to load leaves the header unmarked, so a corrected re-run places it again
+            if (!loadPattern(PATTERN_PATH, grid, WIDTH, HEIGHT, NUMBER_OF_SPECIES, PATTERN_X, PATTERN_Y)) return false;
+        }
+        else {
+            std::cout << "Seeding " << path << " (" << WIDTH << "x" << HEIGHT << ", seed " << SEED << ")\n";
+            seedCells(grid, gridBytes, SEED, NUMBER_OF_SPECIES);
+        }
+        return stampStateFile(state, path);
+    }
+
+    bool initialiseStreaming(OutOfCoreState &state, int stripRows) {
+        cl_int err;
+
+        // Prefer a GPU, but any OpenCL device will do for streaming
+        err = clGetDeviceIDs(NULL, CL_DEVICE_TYPE_GPU, 1, &state.device, NULL);
+        if (err != CL_SUCCESS) err = clGetDeviceIDs(NULL, CL_DEVICE_TYPE_ALL, 1, &state.device, NULL);
+        if (err != CL_SUCCESS) {
+            printf("Error: Failed to find an OpenCL device for streaming!\n");
+            return false;
+        }
+
+        state.context = clCreateContext(0, 1, &state.device, NULL, NULL, &err);
+        if (!state.context) {
+            printf("Error: Failed to create a compute context!\n");
+            return false;
+        }
+
+        const char *sources[2] = {cellRuleSource, stripKernelSource};
+        state.program = buildProgram(state.context, state.device, sources, 2, NULL);
+        if (!state.program) {
+            printf("Error: Failed to build strip program!\n");
+            return false;
+        }
+        state.kernel = clCreateKernel(state.program, "gameOfLifeStrip", &err);
+        if (!state.kernel) {
+            printf("Error: Failed to create strip kernel!\n");
+            return false;
+        }
+
+        size_t inputBytes = static_cast<size_t>(stripRows + 2) * WIDTH;
+        size_t outputBytes = static_cast<size_t>(stripRows) * WIDTH;
+        for (StreamSlot &slot : state.slots) {
+            slot.queue = clCreateCommandQueue(state.context, state.device, 0, &err);
+            slot.input = clCreateBuffer(state.context, CL_MEM_READ_ONLY, inputBytes, NULL, &err);
+            slot.output = clCreateBuffer(state.context, CL_MEM_WRITE_ONLY, outputBytes, NULL, &err);
+            if (!slot.queue || !slot.input || !slot.output) {
+                printf("Error: Failed to create streaming queues and buffers!\n");
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Enqueue upload, kernel and write-back of rows [firstRow, firstRow + rows) on one slot
+    bool enqueueStrip(OutOfCoreState &state, StreamSlot &slot, const cell_t *current, cell_t *next,
+                      int firstRow, int rows) {
+        // The slot's buffers are free again once its previous write-back finished
+        if (slot.done) {
+            clWaitForEvents(1, &slot.done);
+            clReleaseEvent(slot.done);
+            slot.done = NULL;
+        }
+
+        int haloTop = firstRow > 0 ? 1 : 0;
+        int haloBottom = firstRow + rows < HEIGHT ? 1 : 0;
+        int bufferRows = haloTop + rows + haloBottom;
+        size_t width = static_cast<size_t>(WIDTH);
+
+        cl_int err = clEnqueueWriteBuffer(slot.queue, slot.input, CL_FALSE, 0, bufferRows * width,
+                                          current + (firstRow - haloTop) * width, 0, NULL, NULL);
+
+        // Whole-grid index of the strip's first cell, wrapped to 32 bits like the tie-break seed
+        cl_uint firstCellKey = static_cast<cl_uint>(static_cast<size_t>(firstRow) * width);
+        clSetKernelArg(state.kernel, 0, sizeof(cl_mem), &slot.input);
+        clSetKernelArg(state.kernel, 1, sizeof(cl_mem), &slot.output);
+        clSetKernelArg(state.kernel, 2, sizeof(int), &WIDTH);
+        clSetKernelArg(state.kernel, 3, sizeof(int), &bufferRows);
+        clSetKernelArg(state.kernel, 4, sizeof(int), &haloTop);
+        clSetKernelArg(state.kernel, 5, sizeof(int), &rows);
+        clSetKernelArg(state.kernel, 6, sizeof(cl_uint), &firstCellKey);
+        clSetKernelArg(state.kernel, 7, sizeof(int), &NUMBER_OF_SPECIES);
+        int outputRowOffset = 0;
+        clSetKernelArg(state.kernel, 8, sizeof(int), &outputRowOffset);
+
+        size_t global[2] = {width, static_cast<size_t>(rows)};
+        err |= clEnqueueNDRangeKernel(slot.queue, state.kernel, 2, NULL, global, NULL, 0, NULL, NULL);
+        err |= clEnqueueReadBuffer(slot.queue, slot.output, CL_FALSE, 0, rows * width,
+                                   next + firstRow * width, 0, NULL, &slot.done);
+        if (err != CL_SUCCESS) {
+            printf("Error: Failed to enqueue strip at row %d!\n", firstRow);
+            return false;
+        }
+
+        clFlush(slot.queue);
+        return true;
+    }
+}
+
+bool runOutOfCore(const char *path) {
+    // Strips are sized so one slot's buffers stay small whatever the grid size
+    int stripRows = STRIP_ROWS > 0 ? STRIP_ROWS
+                                   : static_cast<int>(std::max<size_t>(1, AUTO_STRIP_BYTES / WIDTH));
+    stripRows = std::min(stripRows, HEIGHT);
+
+    OutOfCoreState state;
+    if (!openStateFile(state, path) || !initialiseStreaming(state, stripRows)) {
+        return false;
+    }
+
+    std::cout << "Streaming " << GENERATIONS << " generations in strips of " << stripRows
+              << " rows over " << NUM_QUEUES << " command queues\n";
+
+    auto start = std::chrono::steady_clock::now();
+    for (int generation = 0; generation < GENERATIONS; generation++) {
+        StateFileHeader *header = state.header();
+        const cell_t *current = state.half(header->currentHalf);
+        cell_t *next = state.half(1 - header->currentHalf);
+
+        int strip = 0;
+        for (int firstRow = 0; firstRow < HEIGHT; firstRow += stripRows, strip++) {
+            int rows = std::min(stripRows, HEIGHT - firstRow);
+            if (!enqueueStrip(state, state.slots[strip % NUM_QUEUES], current, next, firstRow, rows)) {
+                return false;
+            }
+        }
+
+        // Every strip of this generation must be written back before it becomes the input
+        for (StreamSlot &slot : state.slots) clFinish(slot.queue);
+
+        header->currentHalf = 1 - header->currentHalf;
+        header->generation++;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double cellUpdates = static_cast<double>(WIDTH) * HEIGHT * GENERATIONS;
+
+    std::cout << "Out-of-core Run Info:\n";
+    std::cout << "\tTotal runtime:\t\t\t" << seconds << "s\n";
+    std::cout << "\tGenerations/second:\t\t" << GENERATIONS / seconds << "\n";
+    std::cout << "\tCells/second:\t\t\t" << cellUpdates / seconds << "\n";
+    std::cout << "\tStored generation:\t\t" << state.header()->generation << "\n";
+    return true;
+}
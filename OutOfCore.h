@@ -0,0 +1,15 @@
+#ifndef FINAL_PROJECT_OUTOFCORE_H
+#define FINAL_PROJECT_OUTOFCORE_H
+
+// Out-of-core simulation for grids larger than device memory or RAM.
+// The state lives in a memory-mapped file holding two grids (current and
+// next). Each generation is processed in horizontal strips with a halo row
+// above and below, and the strip uploads, kernels and write-backs are
+// pipelined over several command queues so transfers overlap compute.
+// The file is created and seeded if it doesn't match the requested grid,
+// otherwise the run resumes from the generation stored in it.
+
+// Run GENERATIONS generations of the WIDTH x HEIGHT grid stored in path
+bool runOutOfCore(const char *path);
+
+#endif
@@ -0,0 +1,91 @@
+#include <algorithm>
+
+#include "PaddedGrid.h"
+#include "CpuEngine.h"
+
+void padGrid(const cell_t *grid, cell_t *padded, int width, int rowBegin, int rowEnd) {
+    int pitch = paddedPitch(width);
+    for (int y = rowBegin; y < rowEnd; y++) {
+        std::copy(grid + static_cast<size_t>(y) * width, grid + static_cast<size_t>(y + 1) * width,
+                  padded + static_cast<size_t>(y + 1) * pitch + 1);
+    }
+}
+
+void unpadGrid(const cell_t *padded, cell_t *grid, int width, int rowBegin, int rowEnd) {
+    int pitch = paddedPitch(width);
+    for (int y = rowBegin; y < rowEnd; y++) {
+        const cell_t *row = padded + static_cast<size_t>(y + 1) * pitch + 1;
+        std::copy(row, row + width, grid + static_cast<size_t>(y) * width);
+    }
+}
+
+void fillGhostCells(cell_t *padded, int width, int height, Boundary boundary) {
+    int pitch = paddedPitch(width);
+    cell_t *top = padded;
+    cell_t *bottom = padded + static_cast<size_t>(height + 1) * pitch;
+
+    if (boundary == BOUNDARY_DEAD) {
+        std::fill(top, top + pitch, static_cast<cell_t>(-1));
+        std::fill(bottom, bottom + pitch, static_cast<cell_t>(-1));
+        for (int y = 1; y <= height; y++) {
+            padded[static_cast<size_t>(y) * pitch] = -1;
+            padded[static_cast<size_t>(y) * pitch + width + 1] = -1;
+        }
+        return;
+    }
+
+    // Columns first, so the row copies below carry the wrapped corners with them
+    for (int y = 1; y <= height; y++) {
+        cell_t *row = padded + static_cast<size_t>(y) * pitch;
+        row[0] = row[width];
+        row[width + 1] = row[1];
+    }
+    std::copy(padded + static_cast<size_t>(height) * pitch, padded + static_cast<size_t>(height + 1) * pitch, top);
+    std::copy(padded + pitch, padded + static_cast<size_t>(2) * pitch, bottom);
+}
+
+cell_t paddedNextCellState(const cell_t *current, int width, int numSpecies, int x, int y) {
+    int pitch = paddedPitch(width);
+    const int offsets[8] = {-pitch - 1, -pitch, -pitch + 1, -1, 1, pitch - 1, pitch, pitch + 1};
+    const cell_t *cell = current + static_cast<size_t>(y + 1) * pitch + x + 1;
+    int currentCellSpecies = *cell;
+
+    if (currentCellSpecies != -1) {
+        int count = 0;
+        for (int offset : offsets) {
+            if (cell[offset] == currentCellSpecies) count++;
+        }
+        return (count < 2 || count > 3) ? static_cast<cell_t>(-1) : static_cast<cell_t>(currentCellSpecies);
+    }
+
+    int speciesCount[10] = {0};
+    for (int offset : offsets) {
+        int speciesID = cell[offset];
+        if (speciesID > 0) speciesCount[speciesID - 1]++;
+    }
+
+    int reproductionConditionMet[10];
+    int numCandidates = 0;
+    for (int i = 0; i < numSpecies; i++) {
+        if (speciesCount[i] == 3) reproductionConditionMet[numCandidates++] = i + 1;
+    }
+
+    cell_t nextCellSpecies = -1;
+    if (numCandidates > 0) {
+        // Same PCG tie-break as the kernel, keyed on the unpadded cell index
+        uint32_t hash = pcgHash(static_cast<uint32_t>(y * width + x));
+        nextCellSpecies = static_cast<cell_t>(reproductionConditionMet[hash % numCandidates]);
+    }
+    return nextCellSpecies;
+}
+
+void paddedGameOfLifeRows(const cell_t *current, cell_t *next, int width,
+                          int numSpecies, int rowBegin, int rowEnd) {
+    int pitch = paddedPitch(width);
+    for (int y = rowBegin; y < rowEnd; y++) {
+        size_t rowStart = static_cast<size_t>(y + 1) * pitch + 1;
+        for (int x = 0; x < width; x++) {
+            next[rowStart + x] = paddedNextCellState(current, width, numSpecies, x, y);
+        }
+    }
+}
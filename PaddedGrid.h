@@ -0,0 +1,37 @@
+#ifndef FINAL_PROJECT_PADDEDGRID_H
+#define FINAL_PROJECT_PADDEDGRID_H
+
+#include <cstddef>
+
+#include "Configs.h"
+
+// Grid stored with a one-cell ghost border: (width + 2) x (height + 2) cells,
+// cell (x, y) at (y + 1) * (width + 2) + x + 1. The border holds dead cells
+// for BOUNDARY_DEAD and copies of the opposite edge for BOUNDARY_TORUS, so
+// the update reads all 8 neighbours without a bounds check. Cells keep their
+// unpadded index as the PCG tie-break key, a dead boundary matches gameOfLife.
+
+inline int paddedPitch(int width) {
+    return width + 2;
+}
+
+inline size_t paddedSize(int width, int height) {
+    return static_cast<size_t>(paddedPitch(width)) * (height + 2);
+}
+
+// Copy rows [rowBegin, rowEnd) between the grid and the padded interior
+void padGrid(const cell_t *grid, cell_t *padded, int width, int rowBegin, int rowEnd);
+void unpadGrid(const cell_t *padded, cell_t *grid, int width, int rowBegin, int rowEnd);
+
+// Refill the ghost border from the interior, only the torus changes it between generations
+void fillGhostCells(cell_t *padded, int width, int height, Boundary boundary);
+
+// Next state of unpadded cell (x, y), the ghost border of current must be filled
+cell_t paddedNextCellState(const cell_t *current, int width, int numSpecies, int x, int y);
+
+// Apply one generation of the multispecies rule to rows [rowBegin, rowEnd).
+// The ghost border of current must be filled, the border of next isn't written.
+void paddedGameOfLifeRows(const cell_t *current, cell_t *next, int width,
+                          int numSpecies, int rowBegin, int rowEnd);
+
+#endif
@@ -0,0 +1,173 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#include "Pattern.h"
+
+namespace {
+    // Reads the file a character at a time, counting lines for error messages
+    struct PatternReader {
+        FILE *file;
+        const char *path;
+        int line = 1;
+
+        int get() {
+            int c = std::getc(file);
+            if (c == '\n') line++;
+            return c;
+        }
+
+        void skipLine() {
+            for (int c = get(); c != '\n' && c != EOF; c = get()) {}
+        }
+
+        bool fail(const char *message) const {
+            printf("Error: %s line %d: %s!\n", path, line, message);
+            return false;
+        }
+    };
+
+    // Writes runs into the grid, or with no grid only measures the pattern
+    struct PatternTarget {
+        cell_t *grid;
+        int width;
+        int height;
+        long long originX;
+        long long originY;
+        long long patternWidth = 0;
+        long long patternHeight = 0;
+
+        void place(long long x, long long y, long long count, cell_t species) {
+            patternWidth = std::max(patternWidth, x + count);
+            patternHeight = std::max(patternHeight, y + 1);
+            if (grid == nullptr) return;
+
+            long long row = originY + y;
+            long long begin = std::max(originX + x, 0LL);
+            long long end = std::min(originX + x + count, static_cast<long long>(width));
+            if (row < 0 || row >= height || begin >= end) return;
+            cell_t *rowStart = grid + static_cast<size_t>(row) * width;
+            std::fill(rowStart + begin, rowStart + end, species);
+        }
+    };
+
+    bool parseRle(PatternReader &reader, PatternTarget &target, int numSpecies) {
+        long long x = 0, y = 0, run = 0;
+        for (int c = reader.get(); c != EOF && c != '!'; c = reader.get()) {
+            if (std::isdigit(c)) {
+                run = run * 10 + (c - '0');
+                if (run > (1LL << 40)) return reader.fail("run length too long");
+                continue;
+            }
+            if (std::isspace(c)) continue;
+
+            long long count = run > 0 ? run : 1;
+            run = 0;
+            if (c == '$') {
+                y += count;
+                x = 0;
+                continue;
+            }
+
+            int species;
+            if (c == 'b' || c == '.') species = -1;
+            else if (c == 'o') species = 1;
+            else if (c >= 'A' && c <= 'X') species = c - 'A' + 1;
+            else return reader.fail("unknown RLE tag");
+            if (species > numSpecies) return reader.fail("species beyond --species");
+
+            // Dead runs are already dead in the cleared grid
+            if (species != -1) target.place(x, y, count, static_cast<cell_t>(species));
+            x += count;
+        }
+        return true;
+    }
+
+    bool parsePlaintext(PatternReader &reader, PatternTarget &target) {
+        long long x = 0, y = 0;
+        for (int c = reader.get(); c != EOF; c = reader.get()) {
+            if (c == '!' && x == 0) {
+                reader.skipLine();
+                continue;
+            }
+            if (c == '\n') {
+                y++;
+                x = 0;
+            }
+            else if (c == 'O' || c == '*') {
+                target.place(x++, y, 1, 1);
+            }
+            else if (c == '.') {
+                x++;
+            }
+            else if (c != '\r') {
+                return reader.fail("unknown plaintext cell");
+            }
+        }
+        return true;
+    }
+}
+
+bool loadPattern(const char *path, cell_t *grid, int width, int height, int numSpecies,
+                 long long originX, long long originY) {
+    FILE *file = std::fopen(path, "rb");
+    if (file == nullptr) {
+        printf("Error: Failed to open pattern %s!\n", path);
+        return false;
+    }
+    PatternReader reader{file, path};
+
+    // Comments are '#' lines in RLE and '!' lines in plaintext, an RLE file then has its "x = " header
+    bool rle = false;
+    long long patternWidth = -1, patternHeight = -1;
+    for (int c = reader.get(); c != EOF; c = reader.get()) {
+        if (c == '#' || c == '!') {
+            reader.skipLine();
+            continue;
+        }
+        if (c == 'x') {
+            std::string header(1, static_cast<char>(c));
+            for (c = reader.get(); c != '\n' && c != EOF; c = reader.get()) header += static_cast<char>(c);
+            if (std::sscanf(header.c_str(), "x = %lld , y = %lld", &patternWidth, &patternHeight) != 2) {
+                std::fclose(file);
+                return reader.fail("malformed RLE header");
+            }
+            rle = true;
+        }
+        else {
+            std::ungetc(c, file);
+            if (c == '\n') reader.line--;
+        }
+        break;
+    }
+    long dataStart = std::ftell(file);
+    int dataLine = reader.line;
+
+    // Plaintext has no header, so measure it with a dry run before centring it
+    PatternTarget target{nullptr, width, height, 0, 0};
+    if (!rle && (originX < 0 || originY < 0)) {
+        if (!parsePlaintext(reader, target)) {
+            std::fclose(file);
+            return false;
+        }
+        patternWidth = target.patternWidth;
+        patternHeight = target.patternHeight;
+        std::fseek(file, dataStart, SEEK_SET);
+        reader.line = dataLine;
+    }
+
+    target.grid = grid;
+    target.originX = originX >= 0 ? originX : (width - patternWidth) / 2;
+    target.originY = originY >= 0 ? originY : (height - patternHeight) / 2;
+    std::fill(grid, grid + static_cast<size_t>(width) * height, static_cast<cell_t>(-1));
+
+    bool loaded = rle ? parseRle(reader, target, numSpecies) : parsePlaintext(reader, target);
+    std::fclose(file);
+    if (!loaded) return false;
+
+    std::cout << "Loaded " << path << " (" << target.patternWidth << "x" << target.patternHeight
+              << ") at " << target.originX << "," << target.originY << "\n";
+    return true;
+}
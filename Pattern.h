@@ -0,0 +1,18 @@
+#ifndef FINAL_PROJECT_PATTERN_H
+#define FINAL_PROJECT_PATTERN_H
+
+#include "Configs.h"
+
+// Pattern files in RLE (with Golly's multi-state letters A-J for species
+// 1-10) or plaintext (.cells) format, told apart by their first non-comment
+// line. The file is read a character at a time and each run is written
+// straight into the grid, clipped to its edges, so neither the file nor the
+// decoded pattern is ever held in memory. The RLE header's rule is ignored,
+// the run's --rule applies.
+
+// Clear the width x height grid to dead cells and place the pattern with its top-left
+// corner at (originX, originY), or centred when they are negative
+bool loadPattern(const char *path, cell_t *grid, int width, int height, int numSpecies,
+                 long long originX, long long originY);
+
+#endif
@@ -0,0 +1,110 @@
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+#include "ProgramCache.h"
+
+namespace {
+    const char *CACHE_DIRECTORY = "gol_program_cache";
+
+    std::string deviceString(cl_device_id device, cl_device_info param) {
+        char value[256] = {0};
+        clGetDeviceInfo(device, param, sizeof(value) - 1, value, NULL);
+        return value;
+    }
+
+    // FNV-1a, including the terminator so "ab" + "c" and "a" + "bc" hash differently
+    uint64_t hashString(uint64_t hash, const char *text) {
+        for (size_t i = 0; i <= std::strlen(text); i++) {
+            hash ^= static_cast<unsigned char>(text[i]);
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    std::string cachePath(cl_device_id device, const char *const *sources, int count, const char *options) {
+        uint64_t hash = 14695981039346656037ull;
+        hash = hashString(hash, deviceString(device, CL_DEVICE_NAME).c_str());
+        hash = hashString(hash, deviceString(device, CL_DRIVER_VERSION).c_str());
+        hash = hashString(hash, options);
+        for (int i = 0; i < count; i++) hash = hashString(hash, sources[i]);
+
+        char path[64];
+        std::snprintf(path, sizeof(path), "%s/%016llx.bin", CACHE_DIRECTORY, static_cast<unsigned long long>(hash));
+        return path;
+    }
+
+    cl_program loadCachedProgram(cl_context context, cl_device_id device, const std::string &path, const char *options) {
+        std::ifstream file(path, std::ios::binary);
+        std::vector<unsigned char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (binary.empty()) return NULL;
+
+        const unsigned char *data = binary.data();
+        size_t size = binary.size();
+        cl_int status, err;
+        cl_program program = clCreateProgramWithBinary(context, 1, &device, &size, &data, &status, &err);
+        if (!program) return NULL;
+
+        // A binary from an older driver may be refused, even with a matching version string
+        if (err != CL_SUCCESS || status != CL_SUCCESS || clBuildProgram(program, 1, &device, options, NULL, NULL) != CL_SUCCESS) {
+            clReleaseProgram(program);
+            return NULL;
+        }
+        return program;
+    }
+
+    void storeProgram(cl_program program, const std::string &path) {
+        size_t size = 0;
+        if (clGetProgramInfo(program, CL_PROGRAM_BINARY_SIZES, sizeof(size), &size, NULL) != CL_SUCCESS || size == 0) return;
+
+        std::vector<unsigned char> binary(size);
+        unsigned char *data = binary.data();
+        if (clGetProgramInfo(program, CL_PROGRAM_BINARIES, sizeof(data), &data, NULL) != CL_SUCCESS) return;
+
+        // Written under a temporary name, so a concurrent run never loads half a binary
+        mkdir(CACHE_DIRECTORY, 0755);
+        std::string temporary = path + ".tmp";
+        {
+            std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(size));
+            if (!file) {
+                std::remove(temporary.c_str());
+                return;
+            }
+        }
+        std::rename(temporary.c_str(), path.c_str());
+    }
+}
+
+cl_program buildProgram(cl_context context, cl_device_id device,
+                        const char *const *sources, int count, const char *options) {
+    if (options == NULL) options = "";
+
+    std::string path = cachePath(device, sources, count, options);
+    cl_program program = loadCachedProgram(context, device, path, options);
+    if (program) return program;
+
+    cl_int err;
+    program = clCreateProgramWithSource(context, count, const_cast<const char **>(sources), NULL, &err);
+    if (!program) return NULL;
+
+    if (clBuildProgram(program, 1, &device, options, NULL, NULL) != CL_SUCCESS) {
+        // Show the compiler's output, the build error alone says nothing about the cause
+        size_t logSize = 0;
+        clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, 0, NULL, &logSize);
+        std::vector<char> log(logSize + 1, '\0');
+        clGetProgramBuildInfo(program, device, CL_PROGRAM_BUILD_LOG, logSize, log.data(), NULL);
+        std::printf("%s\n", log.data());
+
+        clReleaseProgram(program);
+        return NULL;
+    }
+
+    storeProgram(program, path);
+    return program;
+}
@@ -0,0 +1,14 @@
+#ifndef FINAL_PROJECT_PROGRAMCACHE_H
+#define FINAL_PROJECT_PROGRAMCACHE_H
+
+#include <OpenCL/opencl.h>
+
+// Build a program for one device, reusing the binary an earlier run left in
+// gol_program_cache/. Binaries are keyed by device name, driver version, the
+// sources and the build options, so changing any of them builds from source
+// again. A stale or rejected binary is rebuilt and replaced. Returns NULL if
+// the program can't be built.
+cl_program buildProgram(cl_context context, cl_device_id device,
+                        const char *const *sources, int count, const char *options);
+
+#endif
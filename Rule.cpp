@@ -0,0 +1,291 @@
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "Rule.h"
+#include "CpuEngine.h"
+
+namespace {
+    // Largest neighbour count a rule can see, including the centre cell
+    int maxNeighbourCount(int radius, Neighbourhood neighbourhood) {
+        if (neighbourhood == NEIGHBOURHOOD_MOORE) return (2 * radius + 1) * (2 * radius + 1);
+        return 2 * radius * (radius + 1) + 1;
+    }
+
+    void allow(std::vector<uint32_t> &counts, int count) {
+        counts[count / 32] |= 1u << (count % 32);
+    }
+
+    bool parseInteger(const char *&text, int &value) {
+        if (!std::isdigit(static_cast<unsigned char>(*text))) return false;
+        char *end;
+        long parsed = std::strtol(text, &end, 10);
+        if (parsed > 1 << 20) return false;
+        value = static_cast<int>(parsed);
+        text = end;
+        return true;
+    }
+
+    // "B3/S23", "S23/B3", or with a trailing V for the von Neumann neighbourhood
+    bool parseBirthSurvival(const char *text, Rule &rule) {
+        size_t length = std::strlen(text);
+        rule = Rule();
+        if (length > 0 && std::toupper(static_cast<unsigned char>(text[length - 1])) == 'V') {
+            rule.neighbourhood = NEIGHBOURHOOD_VON_NEUMANN;
+            length--;
+        }
+
+        int maxCount = maxNeighbourCount(1, rule.neighbourhood) - 1;
+        rule.birth.assign(maxCount / 32 + 1, 0);
+        rule.survival.assign(maxCount / 32 + 1, 0);
+
+        bool seen[2] = {false, false};
+        std::vector<uint32_t> *counts = nullptr;
+        for (size_t i = 0; i < length; i++) {
+            char c = static_cast<char>(std::toupper(static_cast<unsigned char>(text[i])));
+            if ((c == 'B' || c == 'S') && (i == 0 || text[i - 1] == '/')) {
+                int part = c == 'B' ? 0 : 1;
+                if (seen[part]) return false;
+                seen[part] = true;
+                counts = part == 0 ? &rule.birth : &rule.survival;
+            }
+            else if (c == '/' && counts != nullptr && i + 1 < length) {
+                counts = nullptr;
+            }
+            else if (std::isdigit(static_cast<unsigned char>(c)) && counts != nullptr && c - '0' <= maxCount) {
+                allow(*counts, c - '0');
+            }
+            else {
+                return false;
+            }
+        }
+        return seen[0] && seen[1];
+    }
+
+    // Golly Larger than Life: "R5,C0,M1,S34..58,B34..45,NM"
+    bool parseLargerThanLife(const char *text, Rule &rule) {
+        rule = Rule();
+        int birth[2] = {-1, -1};
+        int survival[2] = {-1, -1};
+        bool haveRadius = false;
+
+        while (*text != '\0') {
+            char field = static_cast<char>(std::toupper(static_cast<unsigned char>(*text++)));
+            int value;
+            if (field == 'R' && parseInteger(text, value) && value >= 1 && value <= MAX_RULE_RADIUS) {
+                rule.radius = value;
+                haveRadius = true;
+            }
+            else if (field == 'C' && parseInteger(text, value) && value <= 2) {
+                // C0 and C2 are both plain two-state rules, Generations rules aren't supported
+            }
+            else if (field == 'M' && parseInteger(text, value) && value <= 1) {
+                rule.includeCentre = value == 1;
+            }
+            else if ((field == 'S' || field == 'B') && parseInteger(text, value)) {
+                int *range = field == 'S' ? survival : birth;
+                range[0] = range[1] = value;
+                if (std::strncmp(text, "..", 2) == 0) {
+                    text += 2;
+                    if (!parseInteger(text, range[1]) || range[1] < range[0]) return false;
+                }
+            }
+            else if (field == 'N' && (std::toupper(static_cast<unsigned char>(*text)) == 'M' ||
+                                      std::toupper(static_cast<unsigned char>(*text)) == 'N')) {
+                rule.neighbourhood = std::toupper(static_cast<unsigned char>(*text)) == 'M' ?
+                                     NEIGHBOURHOOD_MOORE : NEIGHBOURHOOD_VON_NEUMANN;
+                text++;
+            }
+            else {
+                return false;
+            }
+
+            if (*text == ',') text++;
+            else if (*text != '\0') return false;
+        }
+        if (!haveRadius || birth[0] < 0 || survival[0] < 0) return false;
+
+        // Only a live cell can count itself
+        int maxCount = maxNeighbourCount(rule.radius, rule.neighbourhood);
+        if (birth[1] > maxCount - 1 || survival[1] > maxCount - (rule.includeCentre ? 0 : 1)) return false;
+        rule.birth.assign(maxCount / 32 + 1, 0);
+        rule.survival.assign(maxCount / 32 + 1, 0);
+        for (int count = birth[0]; count <= birth[1]; count++) allow(rule.birth, count);
+        for (int count = survival[0]; count <= survival[1]; count++) allow(rule.survival, count);
+        return true;
+    }
+
+    // First and last count in a set, Larger than Life sets are always one range
+    void countRange(const std::vector<uint32_t> &counts, int &first, int &last) {
+        first = last = -1;
+        for (int count = 0; count < static_cast<int>(counts.size()) * 32; count++) {
+            if (!ruleAllows(counts, count)) continue;
+            if (first < 0) first = count;
+            last = count;
+        }
+    }
+}
+
+Rule RULE = [] {
+    Rule rule;
+    parseRule("B3/S23", rule);
+    return rule;
+}();
+
+bool parseRule(const char *text, Rule &rule) {
+    if (std::toupper(static_cast<unsigned char>(text[0])) == 'R') return parseLargerThanLife(text, rule);
+    return parseBirthSurvival(text, rule);
+}
+
+std::string ruleString(const Rule &rule) {
+    bool vonNeumann = rule.neighbourhood == NEIGHBOURHOOD_VON_NEUMANN;
+    if (rule.radius == 1 && !rule.includeCentre) {
+        std::string text = "B";
+        for (int count = 0; count <= 8; count++) {
+            if (ruleAllows(rule.birth, count)) text += static_cast<char>('0' + count);
+        }
+        text += "/S";
+        for (int count = 0; count <= 8; count++) {
+            if (ruleAllows(rule.survival, count)) text += static_cast<char>('0' + count);
+        }
+        return vonNeumann ? text + "V" : text;
+    }
+
+    int birth[2], survival[2];
+    countRange(rule.birth, birth[0], birth[1]);
+    countRange(rule.survival, survival[0], survival[1]);
+    char text[64];
+    std::snprintf(text, sizeof(text), "R%d,C0,M%d,S%d..%d,B%d..%d,N%c", rule.radius, rule.includeCentre ? 1 : 0,
+                  survival[0], survival[1], birth[0], birth[1], vonNeumann ? 'N' : 'M');
+    return text;
+}
+
+bool isLifeRule(const Rule &rule) {
+    return ruleString(rule) == "B3/S23";
+}
+
+// ----------- NEIGHBOUR COUNTS ----------- //
+
+std::vector<RuleCountPass> ruleCountPasses(const Rule &rule) {
+    int radius = rule.radius;
+    if (rule.neighbourhood == NEIGHBOURHOOD_MOORE) {
+        return {{1, 0, 0, 1, -radius, radius, 0, false}};
+    }
+
+    // Offsets (dx, dy) with |dx| + |dy| <= radius. Even ones are (t + s, t - s) with |t|, |s| <= radius / 2,
+    // odd ones are (t + s + 1, t - s) with 2t + 1 and 2s + 1 in [-radius, radius].
+    int half = radius / 2;
+    return {{1, 1, 1, -1, -half, half, 0, false},
+            {1, 1, 1, -1, -((radius + 1) / 2), (radius - 1) / 2, 1, true}};
+}
+
+int ruleCountPadding(const Rule &rule) {
+    // Diagonal sums just outside the grid still reach cells inside it
+    return rule.neighbourhood == NEIGHBOURHOOD_MOORE ? 0 : rule.radius + 1;
+}
+
+int ruleLineCount(int width, int height, int dx, int dy) {
+    if (dy == 0) return height;
+    if (dx == 0) return width;
+    return width + height - 1;
+}
+
+void ruleLineStart(int line, int width, int height, int dx, int dy, int &x, int &y) {
+    if (dy == 0) {
+        x = 0;
+        y = line;
+    }
+    else if (dx == 0) {
+        x = line;
+        y = 0;
+    }
+    else if (line < width) {
+        x = line;
+        y = dy > 0 ? 0 : height - 1;
+    }
+    else {
+        x = 0;
+        y = dy > 0 ? line - width + 1 : height - 2 - (line - width);
+    }
+}
+
+void ruleSpeciesLineSums(const cell_t *grid, int width, int height, int numSpecies, int padding,
+                         int dx, int dy, int lo, int hi, uint16_t *sums, int line) {
+    int sumsWidth = width + 2 * padding;
+    int sumsHeight = height + 2 * padding;
+    size_t planeSize = static_cast<size_t>(sumsWidth) * sumsHeight;
+
+    auto speciesAt = [&](int x, int y) {
+        return (x >= 0 && x < width && y >= 0 && y < height) ? grid[y * width + x] : -1;
+    };
+
+    int x, y;
+    ruleLineStart(line, sumsWidth, sumsHeight, dx, dy, x, y);
+
+    // Window sums per species, slid one cell at a time
+    int window[10] = {0};
+    for (int t = lo; t <= hi; t++) {
+        int species = speciesAt(x - padding + t * dx, y - padding + t * dy);
+        if (species > 0) window[species - 1]++;
+    }
+
+    for (; x >= 0 && x < sumsWidth && y >= 0 && y < sumsHeight; x += dx, y += dy) {
+        for (int species = 0; species < numSpecies; species++) {
+            sums[species * planeSize + static_cast<size_t>(y) * sumsWidth + x] = static_cast<uint16_t>(window[species]);
+        }
+
+        int leaving = speciesAt(x - padding + lo * dx, y - padding + lo * dy);
+        int entering = speciesAt(x - padding + (hi + 1) * dx, y - padding + (hi + 1) * dy);
+        if (leaving > 0) window[leaving - 1]--;
+        if (entering > 0) window[entering - 1]++;
+    }
+}
+
+void rulePlaneLineSums(const uint16_t *sums, int width, int height, int padding,
+                       int dx, int dy, int lo, int hi, int shiftX, bool accumulate,
+                       uint16_t *counts, int line) {
+    int sumsWidth = width + 2 * padding;
+    int sumsHeight = height + 2 * padding;
+
+    // Sums past the padding only cover cells outside the grid
+    auto sumAt = [&](int x, int y) {
+        x += padding;
+        y += padding;
+        return (x >= 0 && x < sumsWidth && y >= 0 && y < sumsHeight) ? sums[static_cast<size_t>(y) * sumsWidth + x] : 0;
+    };
+
+    int x, y;
+    ruleLineStart(line, width, height, dx, dy, x, y);
+
+    int window = 0;
+    for (int t = lo; t <= hi; t++) window += sumAt(x + shiftX + t * dx, y + t * dy);
+
+    for (; x >= 0 && x < width && y >= 0 && y < height; x += dx, y += dy) {
+        uint16_t &count = counts[static_cast<size_t>(y) * width + x];
+        count = static_cast<uint16_t>(accumulate ? count + window : window);
+        window += sumAt(x + shiftX + (hi + 1) * dx, y + (hi + 1) * dy) - sumAt(x + shiftX + lo * dx, y + lo * dy);
+    }
+}
+
+cell_t ruleNextCellState(const Rule &rule, const cell_t *current, const uint16_t *counts,
+                         size_t planeSize, int numSpecies, int cellIndex) {
+    int currentCellSpecies = current[cellIndex];
+
+    // The counts include the cell itself
+    if (currentCellSpecies != -1) {
+        int count = counts[(currentCellSpecies - 1) * planeSize + cellIndex] - (rule.includeCentre ? 0 : 1);
+        return ruleAllows(rule.survival, count) ? static_cast<cell_t>(currentCellSpecies) : static_cast<cell_t>(-1);
+    }
+
+    int reproductionConditionMet[10];
+    int numCandidates = 0;
+    for (int species = 1; species <= numSpecies; species++) {
+        if (ruleAllows(rule.birth, counts[(species - 1) * planeSize + cellIndex])) {
+            reproductionConditionMet[numCandidates++] = species;
+        }
+    }
+    if (numCandidates == 0) return -1;
+
+    return static_cast<cell_t>(reproductionConditionMet[pcgHash(static_cast<uint32_t>(cellIndex)) % numCandidates]);
+}
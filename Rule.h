@@ -0,0 +1,84 @@
+#ifndef FINAL_PROJECT_RULE_H
+#define FINAL_PROJECT_RULE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "Configs.h"
+
+// Outer-totalistic multispecies rules: a live cell survives if the number of
+// neighbours of its own species is in the survival set, and a dead cell is
+// born as one of the species whose neighbour count is in the birth set, with
+// the same PCG tie-break as gameOfLife. The neighbourhood is a Moore square or
+// von Neumann diamond of any radius (Larger than Life).
+//
+// Rulestrings are either B/S ("B3/S23", "B2/S013V" for von Neumann), or the
+// Golly Larger than Life format ("R5,C0,M1,S34..58,B34..45,NM"), where M1
+// counts a live cell as its own neighbour and NN selects von Neumann.
+
+enum Neighbourhood {
+    NEIGHBOURHOOD_MOORE,
+    NEIGHBOURHOOD_VON_NEUMANN
+};
+
+constexpr int MAX_RULE_RADIUS = 64;
+
+struct Rule {
+    int radius = 1;
+    Neighbourhood neighbourhood = NEIGHBOURHOOD_MOORE;
+    bool includeCentre = false;         // A live cell counts itself
+    std::vector<uint32_t> birth;        // Bit n set = born with n neighbours of a species
+    std::vector<uint32_t> survival;     // Bit n set = survives with n neighbours of its species
+};
+
+extern Rule RULE;   // Set by --rule and restored checkpoints, B3/S23 by default
+
+bool parseRule(const char *text, Rule &rule);
+std::string ruleString(const Rule &rule);   // Canonical rulestring, stored in checkpoints
+bool isLifeRule(const Rule &rule);          // B3/S23 with radius 1, which every kernel implements
+
+inline bool ruleAllows(const std::vector<uint32_t> &counts, int count) {
+    return count >= 0 && static_cast<size_t>(count / 32) < counts.size() && (counts[count / 32] >> (count % 32)) & 1u;
+}
+
+// ----------- NEIGHBOUR COUNTS ----------- //
+// Neighbourhoods are counted per species with two 1D sliding-window passes,
+// so the cost per cell doesn't grow with the radius. The first pass sums the
+// species along firstDirection into a padded sums plane, the second sums those
+// along secondDirection into the per-species counts. A Moore square is rows
+// then columns. A von Neumann diamond is the sum of two squares on the
+// diagonal lattice, cells whose x + y offset is even and odd, each summed
+// along the two diagonals.
+
+struct RuleCountPass {
+    int firstDx, firstDy;       // Direction of the pass over the grid
+    int secondDx, secondDy;     // Direction of the pass over the sums
+    int lo, hi;                 // Window [lo, hi] along both directions
+    int shiftX;                 // x offset of the second pass' window
+    bool accumulate;            // Add to the counts instead of replacing them
+};
+
+std::vector<RuleCountPass> ruleCountPasses(const Rule &rule);
+int ruleCountPadding(const Rule &rule);     // Cells of sums kept outside the grid on every side
+
+// Lines a pass walks over a width x height plane, and where line number line starts
+int ruleLineCount(int width, int height, int dx, int dy);
+void ruleLineStart(int line, int width, int height, int dx, int dy, int &x, int &y);
+
+// First pass along one line of the padded sums plane, for every species at once.
+// sums holds numSpecies planes of (width + 2 * padding) x (height + 2 * padding).
+void ruleSpeciesLineSums(const cell_t *grid, int width, int height, int numSpecies, int padding,
+                         int dx, int dy, int lo, int hi, uint16_t *sums, int line);
+
+// Second pass along one line of one species' counts plane (width x height)
+void rulePlaneLineSums(const uint16_t *sums, int width, int height, int padding,
+                       int dx, int dy, int lo, int hi, int shiftX, bool accumulate,
+                       uint16_t *counts, int line);
+
+// Next state of a cell from its per-species counts, numSpecies planes of planeSize cells
+cell_t ruleNextCellState(const Rule &rule, const cell_t *current, const uint16_t *counts,
+                         size_t planeSize, int numSpecies, int cellIndex);
+
+#endif
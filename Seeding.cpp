@@ -0,0 +1,29 @@
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include "Seeding.h"
+
+namespace {
+    constexpr size_t MIN_CELLS_PER_THREAD = 1 << 20;    // Smaller grids aren't worth starting threads for
+}
+
+void seedCells(cell_t *grid, size_t count, uint32_t seed, int numSpecies) {
+    uint64_t key = seedKey(seed);
+    auto seedRange = [=](size_t begin, size_t end) {
+        for (size_t cellIndex = begin; cellIndex < end; cellIndex++) {
+            grid[cellIndex] = seedCell(key, cellIndex, numSpecies);
+        }
+    };
+
+    size_t threadCount = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()),
+                                          std::max<size_t>(1, count / MIN_CELLS_PER_THREAD));
+    size_t chunk = (count + threadCount - 1) / threadCount;
+
+    std::vector<std::thread> threads;
+    for (size_t thread = 1; thread < threadCount; thread++) {
+        threads.emplace_back(seedRange, thread * chunk, std::min(count, (thread + 1) * chunk));
+    }
+    seedRange(0, std::min(count, chunk));
+    for (std::thread &thread : threads) thread.join();
+}
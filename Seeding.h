@@ -0,0 +1,35 @@
+#ifndef FINAL_PROJECT_SEEDING_H
+#define FINAL_PROJECT_SEEDING_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Configs.h"
+
+// Counter-based initial grids. A cell's species is a hash of (seed, cell
+// index) rather than the next value of a sequential generator, so any thread,
+// device or strip can seed any cell and the same seed always gives the same
+// grid, whatever the thread or device count.
+
+// The splitmix64 finaliser. Matches seedMix in KernelSource.h.
+inline uint64_t seedMix(uint64_t z) {
+    z += 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+// Mixed once per grid, so consecutive seeds don't give overlapping cell streams
+inline uint64_t seedKey(uint32_t seed) {
+    return seedMix(seed);
+}
+
+// Species 1..numSpecies of cell cellIndex
+inline cell_t seedCell(uint64_t key, uint64_t cellIndex, int numSpecies) {
+    return static_cast<cell_t>((seedMix(key + cellIndex) >> 32) % static_cast<uint64_t>(numSpecies) + 1);
+}
+
+// Seed cells [0, count) of grid from seed on all hardware threads
+void seedCells(cell_t *grid, size_t count, uint32_t seed, int numSpecies);
+
+#endif
@@ -0,0 +1,65 @@
+#include <cstring>
+
+#include "Stats.h"
+
+namespace {
+    constexpr uint32_t STATS_VERSION = 1;
+
+    struct StatsHeader {
+        char magic[8];          // "GOLSTATS"
+        uint32_t version;
+        uint32_t numSpecies;
+    };
+    static_assert(sizeof(StatsHeader) == 16, "Stats header must stay 16 bytes");
+}
+
+StatsStream::StatsStream(const char *path, StatsFormat format, int numSpecies)
+        : format(format), numSpecies(numSpecies) {
+    // Also works for a named pipe, which blocks here until a reader opens it
+    output = std::fopen(path, "wb");
+    if (output == nullptr) {
+        printf("Error: Failed to open %s for statistics!\n", path);
+        return;
+    }
+
+    bool headerWritten;
+    if (format == STATS_CSV) {
+        headerWritten = std::fputs("generation,species,population,births,deaths,contested\n", output) >= 0;
+    }
+    else {
+        StatsHeader header = {};
+        std::memcpy(header.magic, "GOLSTATS", 8);
+        header.version = STATS_VERSION;
+        header.numSpecies = numSpecies;
+        headerWritten = std::fwrite(&header, sizeof(header), 1, output) == 1;
+    }
+    if (!headerWritten) {
+        printf("Error: Failed to write the statistics header!\n");
+        std::fclose(output);
+        output = nullptr;
+    }
+}
+
+StatsStream::~StatsStream() {
+    if (output != nullptr) std::fclose(output);
+}
+
+void StatsStream::write(uint64_t generation, const uint32_t *slot) {
+    if (output == nullptr) return;
+
+    if (format == STATS_BINARY) {
+        std::fwrite(&generation, sizeof(generation), 1, output);
+        std::fwrite(slot, sizeof(uint32_t), static_cast<size_t>(numSpecies) * STATS_FIELDS, output);
+        return;
+    }
+
+    for (int species = 1; species <= numSpecies; species++) {
+        const uint32_t *counters = slot + (species - 1) * STATS_FIELDS;
+        std::fprintf(output, "%llu,%d,%u,%u,%u,%u\n", static_cast<unsigned long long>(generation), species,
+                     counters[STAT_POPULATION], counters[STAT_BIRTHS], counters[STAT_DEATHS], counters[STAT_CONTESTED]);
+    }
+}
+
+void StatsStream::flush() {
+    if (output != nullptr) std::fflush(output);
+}
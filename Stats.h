@@ -0,0 +1,53 @@
+#ifndef FINAL_PROJECT_STATS_H
+#define FINAL_PROJECT_STATS_H
+
+#include <cstdint>
+#include <cstdio>
+
+#include "Configs.h"
+
+// Per-generation population statistics. For every species: live cells,
+// births, deaths, and contested births (cells where more than one species had
+// exactly 3 neighbours, so the PCG tie-break picked the winner). A generation's
+// statistics are one slot of STATS_SLOT_SIZE counters, indexed
+// (species - 1) * STATS_FIELDS + field, the layout generationStats accumulates into.
+
+enum StatsField {
+    STAT_POPULATION,
+    STAT_BIRTHS,
+    STAT_DEATHS,
+    STAT_CONTESTED,
+    STATS_FIELDS
+};
+
+constexpr int STATS_SLOT_SIZE = 10 * STATS_FIELDS;     // Room for the maximum species count
+
+// Work-group shape of the generationStats kernel, one __local histogram per group
+constexpr int STATS_LOCAL_WIDTH = 16;
+constexpr int STATS_LOCAL_HEIGHT = 8;
+
+// Streams the time series to a file or named pipe. CSV has a header row and
+// one row per generation and species. Binary starts with a 16-byte header
+// ("GOLSTATS", uint32 version, uint32 species count), then per generation a
+// uint64 generation and species count x STATS_FIELDS uint32 counters, in the
+// host's (little-endian) byte order.
+class StatsStream {
+public:
+    StatsStream(const char *path, StatsFormat format, int numSpecies);
+    ~StatsStream();
+
+    StatsStream(const StatsStream&) = delete;
+    StatsStream& operator=(const StatsStream&) = delete;
+
+    bool isOpen() const { return output != nullptr; }
+
+    void write(uint64_t generation, const uint32_t *slot);
+    void flush();   // Called after every batch, so a reader following the stream sees whole batches
+
+private:
+    StatsFormat format;
+    int numSpecies;
+    FILE *output = nullptr;
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned int threadCount) {
+    if (threadCount == 0) threadCount = 1;
+
+    // The calling thread acts as worker 0, so only threadCount - 1 threads are spawned
+    for (unsigned int i = 0; i < threadCount; i++) {
+        queues.push_back(std::make_unique<TaskQueue>());
+    }
+    for (unsigned int i = 1; i < threadCount; i++) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (std::thread &worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)> &task) {
+    if (count <= 0) return;
+
+    // Publish the task before any index becomes visible to a worker
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        currentTask = &task;
+        remainingTasks.store(count);
+        batchNumber++;
+    }
+
+    // Deal the tasks out round-robin, stealing evens out any imbalance
+    for (int i = 0; i < count; i++) {
+        TaskQueue &queue = *queues[i % queues.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.tasks.push_back(i);
+    }
+    workAvailable.notify_all();
+
+    runTasks(0);
+
+    std::unique_lock<std::mutex> lock(stateMutex);
+    workFinished.wait(lock, [this] { return remainingTasks.load() == 0; });
+    currentTask = nullptr;
+}
+
+void ThreadPool::workerLoop(unsigned int workerIndex) {
+    unsigned long lastBatch = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(stateMutex);
+            workAvailable.wait(lock, [&] { return stopping || batchNumber != lastBatch; });
+            if (stopping) return;
+            lastBatch = batchNumber;
+        }
+        runTasks(workerIndex);
+    }
+}
+
+bool ThreadPool::popTask(unsigned int workerIndex, int &taskIndex) {
+    // Own queue first, newest task at the back
+    {
+        TaskQueue &own = *queues[workerIndex];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            taskIndex = own.tasks.back();
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // Steal the oldest task from another worker
+    for (size_t offset = 1; offset < queues.size(); offset++) {
+        TaskQueue &victim = *queues[(workerIndex + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            taskIndex = victim.tasks.front();
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::runTasks(unsigned int workerIndex) {
+    int taskIndex;
+    while (popTask(workerIndex, taskIndex)) {
+        (*currentTask)(taskIndex);
+
+        if (remainingTasks.fetch_sub(1) == 1) {
+            std::lock_guard<std::mutex> lock(stateMutex);
+            workFinished.notify_all();
+        }
+    }
+}
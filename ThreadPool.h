@@ -0,0 +1,53 @@
+#ifndef FINAL_PROJECT_THREADPOOL_H
+#define FINAL_PROJECT_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads with one task deque per worker.
+// A worker pops its own tasks from the back and, once it runs dry, steals
+// from the front of the other workers' deques, so uneven tasks still
+// balance out across threads.
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned int threadCount);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Run task(0) ... task(count - 1) across the pool and the calling thread,
+    // returning once every task has finished
+    void parallelFor(int count, const std::function<void(int)> &task);
+
+    unsigned int size() const { return static_cast<unsigned int>(queues.size()); }
+
+private:
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<int> tasks;
+    };
+
+    void workerLoop(unsigned int workerIndex);
+    bool popTask(unsigned int workerIndex, int &taskIndex);
+    void runTasks(unsigned int workerIndex);
+
+    std::vector<std::thread> workers;
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workFinished;
+    const std::function<void(int)> *currentTask = nullptr;
+    unsigned long batchNumber = 0;
+    std::atomic<int> remainingTasks{0};
+    bool stopping = false;
+};
+
+#endif
@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "Trace.h"
+
+namespace {
+    constexpr size_t RING_CAPACITY = 1 << 16;   // Must be a power of two
+
+    struct TraceEvent {
+        const char *name;       // String literal, never copied
+        uint64_t startNs;
+        uint64_t endNs;
+        uint32_t track;
+    };
+
+    // Sequence is 2 * index + 1 while the slot is being written and 2 * index + 2 once it's complete,
+    // so a reader can tell a torn or overwritten slot from a finished one
+    struct Slot {
+        std::atomic<uint64_t> sequence{0};
+        TraceEvent event;
+    };
+
+    struct PendingDeviceEvent {
+        const char *name;
+        uint32_t track;
+        cl_event first;
+        cl_event last;
+        uint64_t hostQueuedNs;  // Host time when the first command was enqueued
+    };
+
+    std::atomic<bool> enabled{false};
+    std::vector<Slot> ring(0);
+    std::atomic<uint64_t> nextIndex{0};
+    std::atomic<uint32_t> nextThreadTrack{1};
+    thread_local uint32_t threadTrack = 0;
+
+    // Rarely touched, only by the thread that enqueues OpenCL work and when naming threads
+    std::mutex pendingMutex;
+    std::vector<PendingDeviceEvent> pending;
+    std::vector<std::pair<uint32_t, std::string>> trackNames;
+
+    uint32_t currentThreadTrack() {
+        if (threadTrack == 0) threadTrack = nextThreadTrack.fetch_add(1, std::memory_order_relaxed);
+        return threadTrack;
+    }
+
+    void record(const char *name, uint64_t startNs, uint64_t endNs, uint32_t track) {
+        uint64_t index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+        Slot &slot = ring[index & (RING_CAPACITY - 1)];
+        slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.event = {name, startNs, endNs, track};
+        slot.sequence.store(2 * index + 2, std::memory_order_release);
+    }
+
+    bool eventComplete(cl_event event) {
+        cl_int status;
+        return clGetEventInfo(event, CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof(status), &status, NULL) == CL_SUCCESS &&
+               status == CL_COMPLETE;
+    }
+
+    void writeEscaped(FILE *file, const char *text) {
+        for (; *text; text++) {
+            if (*text == '"' || *text == '\\') std::fputc('\\', file);
+            std::fputc(*text, file);
+        }
+    }
+}
+
+void startTracing() {
+    if (enabled) return;
+    ring = std::vector<Slot>(RING_CAPACITY);
+    enabled = true;
+
+    traceNameThread("Main thread");
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    trackNames.emplace_back(TRACK_GPU_QUEUE, "OpenCL grid queue");
+    trackNames.emplace_back(TRACK_PIXEL_QUEUE, "OpenCL pixel queue");
+    trackNames.emplace_back(TRACK_DEVICE_QUEUE, "OpenCL device queues");
+}
+
+bool tracingEnabled() {
+    return enabled.load(std::memory_order_relaxed);
+}
+
+void traceNameThread(const char *name) {
+    if (!tracingEnabled()) return;
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    trackNames.emplace_back(currentThreadTrack(), name);
+}
+
+uint64_t traceNow() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void traceHostSpan(const char *name, uint64_t startNs, uint64_t endNs) {
+    if (!tracingEnabled()) return;
+    record(name, startNs, endNs, currentThreadTrack());
+}
+
+void traceDeviceEvent(const char *name, TraceTrack track, cl_event event) {
+    traceDeviceSpan(name, track, event, event);
+}
+
+void traceDeviceSpan(const char *name, TraceTrack track, cl_event first, cl_event last) {
+    if (!tracingEnabled() || first == NULL || last == NULL) return;
+    uint64_t now = traceNow();
+    clRetainEvent(first);
+    clRetainEvent(last);
+
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    pending.push_back({name, static_cast<uint32_t>(track), first, last, now});
+}
+
+void traceResolveDeviceEvents() {
+    if (!tracingEnabled()) return;
+    std::lock_guard<std::mutex> lock(pendingMutex);
+
+    size_t kept = 0;
+    for (PendingDeviceEvent &event : pending) {
+        if (!eventComplete(event.last) || !eventComplete(event.first)) {
+            pending[kept++] = event;
+            continue;
+        }
+
+        // Device clocks have their own epoch, anchor each span at the host time it was queued
+        cl_ulong queued = 0, start = 0, end = 0;
+        clGetEventProfilingInfo(event.first, CL_PROFILING_COMMAND_QUEUED, sizeof(cl_ulong), &queued, NULL);
+        clGetEventProfilingInfo(event.first, CL_PROFILING_COMMAND_START, sizeof(cl_ulong), &start, NULL);
+        clGetEventProfilingInfo(event.last, CL_PROFILING_COMMAND_END, sizeof(cl_ulong), &end, NULL);
+        if (start >= queued && end >= start) {
+            record(event.name, event.hostQueuedNs + (start - queued), event.hostQueuedNs + (end - queued), event.track);
+        }
+
+        clReleaseEvent(event.first);
+        clReleaseEvent(event.last);
+    }
+    pending.resize(kept);
+}
+
+bool writeChromeTrace(const char *path) {
+    if (!tracingEnabled()) return false;
+    traceResolveDeviceEvents();
+
+    FILE *file = std::fopen(path, "w");
+    if (file == nullptr) {
+        printf("Error: Failed to open trace file %s!\n", path);
+        return false;
+    }
+
+    std::fputs("{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n", file);
+    bool first = true;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        for (const auto &trackName : trackNames) {
+            std::fprintf(file, "%s{\"ph\": \"M\", \"name\": \"thread_name\", \"pid\": 1, \"tid\": %u, \"args\": {\"name\": \"",
+                         first ? "" : ",\n", trackName.first);
+            writeEscaped(file, trackName.second.c_str());
+            std::fputs("\"}}", file);
+            first = false;
+        }
+    }
+
+    uint64_t end = nextIndex.load(std::memory_order_acquire);
+    uint64_t begin = end > RING_CAPACITY ? end - RING_CAPACITY : 0;
+    uint64_t origin = UINT64_MAX;
+    std::vector<TraceEvent> events;
+    for (uint64_t index = begin; index < end; index++) {
+        Slot &slot = ring[index & (RING_CAPACITY - 1)];
+        uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+        TraceEvent event = slot.event;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (sequence != 2 * index + 2 || slot.sequence.load(std::memory_order_relaxed) != sequence) continue;
+        events.push_back(event);
+        origin = std::min(origin, event.startNs);
+    }
+
+    for (const TraceEvent &event : events) {
+        std::fprintf(file, "%s{\"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f, \"name\": \"",
+                     first ? "" : ",\n", event.track, (event.startNs - origin) / 1000.0,
+                     (event.endNs - event.startNs) / 1000.0);
+        writeEscaped(file, event.name);
+        std::fputs("\"}", file);
+        first = false;
+    }
+    std::fputs("\n]}\n", file);
+
+    bool ok = std::fclose(file) == 0;
+    if (ok) std::cout << "Wrote " << events.size() << " trace events to " << path << "\n";
+    return ok;
+}
@@ -0,0 +1,54 @@
+#ifndef FINAL_PROJECT_TRACE_H
+#define FINAL_PROJECT_TRACE_H
+
+#include <cstdint>
+#include <OpenCL/opencl.h>
+
+// Low-overhead timeline tracing. Host stages are timed with TraceScope and
+// OpenCL commands with their profiling events, and both are recorded into a
+// fixed-size lock-free ring (the oldest events are overwritten). The ring can
+// be dumped as Chrome trace JSON at any time, which chrome://tracing and
+// ui.perfetto.dev open directly. Everything is a no-op until startTracing().
+
+enum TraceTrack {
+    TRACK_GPU_QUEUE = 1000,     // gpu_commands
+    TRACK_PIXEL_QUEUE,          // cpu_commands
+    TRACK_DEVICE_QUEUE          // Other queues (multi-device partitions, out-of-core slots)
+};
+
+void startTracing();
+bool tracingEnabled();
+
+// Name the calling thread's track in the trace
+void traceNameThread(const char *name);
+
+// Record a finished host span on the calling thread's track, timestamps from traceNow()
+uint64_t traceNow();
+void traceHostSpan(const char *name, uint64_t startNs, uint64_t endNs);
+
+// Record an OpenCL command, call right after enqueueing it. The event is retained until
+// traceResolveDeviceEvents() finds it complete, so the caller may release it straight away.
+void traceDeviceEvent(const char *name, TraceTrack track, cl_event event);
+// Record one span from the start of first to the end of last (e.g. a batch of generations)
+void traceDeviceSpan(const char *name, TraceTrack track, cl_event first, cl_event last);
+// Convert completed device events to host time and move them into the ring
+void traceResolveDeviceEvents();
+
+// Write every event still in the ring as Chrome trace JSON
+bool writeChromeTrace(const char *path);
+
+// Times the enclosing block on the calling thread's track
+class TraceScope {
+public:
+    explicit TraceScope(const char *name) : name(name), start(tracingEnabled() ? traceNow() : 0) {}
+    ~TraceScope() { if (start) traceHostSpan(name, start, traceNow()); }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char *name;
+    uint64_t start;
+};
+
+#endif
@@ -0,0 +1,111 @@
+#include <algorithm>
+
+#include "Viewport.h"
+
+Viewport viewport;
+
+namespace {
+    // floor(value / 2^shift) for negative values too
+    int floorShift(int value, int shift) {
+        return value >= 0 ? value >> shift : -((-value + (1 << shift) - 1) >> shift);
+    }
+
+    // Cells across pixels window pixels at zoom
+    int spanCells(int pixels, int zoom) {
+        return zoom >= 0 ? (pixels + (1 << zoom) - 1) >> zoom : pixels << -zoom;
+    }
+
+    // Centre the grid along an axis it doesn't fill, otherwise keep the window on it
+    int clampOrigin(int origin, int span, int gridSize) {
+        if (span >= gridSize) return (gridSize - span) / 2;
+        return std::clamp(origin, 0, gridSize - span);
+    }
+
+    void clampViewport() {
+        viewport.originX = clampOrigin(viewport.originX, spanCells(viewWidth(), viewport.zoom), WIDTH);
+        viewport.originY = clampOrigin(viewport.originY, spanCells(viewHeight(), viewport.zoom), HEIGHT);
+    }
+}
+
+int viewWidth() {
+    return VIEW_WIDTH > 0 ? VIEW_WIDTH : WIDTH;
+}
+
+int viewHeight() {
+    return VIEW_HEIGHT > 0 ? VIEW_HEIGHT : HEIGHT;
+}
+
+int pyramidLevels() {
+    int levels = 0;
+    while (spanCells(viewWidth(), -levels) < WIDTH || spanCells(viewHeight(), -levels) < HEIGHT) levels++;
+    return levels;
+}
+
+size_t pyramidLevelOffset(int level) {
+    size_t offset = 0;
+    for (int below = 1; below < level; below++) {
+        offset += static_cast<size_t>(levelWidth(below)) * levelHeight(below);
+    }
+    return offset;
+}
+
+size_t pyramidSize() {
+    return pyramidLevelOffset(pyramidLevels() + 1);
+}
+
+void viewOrigin(const Viewport &view, int &x, int &y) {
+    x = floorShift(view.originX, viewLevel(view));
+    y = floorShift(view.originY, viewLevel(view));
+}
+
+LevelRect viewLevelRect(const Viewport &view, int level) {
+    int originX, originY;
+    viewOrigin(view, originX, originY);
+
+    // Every texel of the viewport's level covers 2^(viewLevel - level) texels of this one
+    int scale = 1 << (viewLevel(view) - level);
+    LevelRect rect;
+    rect.x0 = std::clamp(originX * scale, 0, levelWidth(level));
+    rect.y0 = std::clamp(originY * scale, 0, levelHeight(level));
+    rect.x1 = std::clamp((originX + viewWidth()) * scale, 0, levelWidth(level));
+    rect.y1 = std::clamp((originY + viewHeight()) * scale, 0, levelHeight(level));
+    return rect;
+}
+
+void initialiseViewport() {
+    if (FUSED_PIXELS) {
+        VIEW_WIDTH = VIEW_HEIGHT = 0;
+    }
+    else if (!HEADLESS && VIEW_WIDTH == 0) {
+        VIEW_WIDTH = std::min(WIDTH, DEFAULT_WINDOW_SIZE);
+        VIEW_HEIGHT = std::min(HEIGHT, DEFAULT_WINDOW_SIZE);
+    }
+    fitViewport();
+}
+
+void fitViewport() {
+    // Zoom out until the grid fits, or in as far as it still fits
+    viewport.zoom = -pyramidLevels();
+    while (viewport.zoom >= 0 && viewport.zoom < MAX_MAGNIFICATION &&
+           (WIDTH << (viewport.zoom + 1)) <= viewWidth() && (HEIGHT << (viewport.zoom + 1)) <= viewHeight()) {
+        viewport.zoom++;
+    }
+    viewport.originX = viewport.originY = 0;
+    clampViewport();
+}
+
+void panViewport(int stepsX, int stepsY) {
+    viewport.originX += std::max(1, spanCells(viewWidth(), viewport.zoom) / 8) * stepsX;
+    viewport.originY += std::max(1, spanCells(viewHeight(), viewport.zoom) / 8) * stepsY;
+    clampViewport();
+}
+
+void zoomViewport(int steps) {
+    int centreX = viewport.originX + spanCells(viewWidth(), viewport.zoom) / 2;
+    int centreY = viewport.originY + spanCells(viewHeight(), viewport.zoom) / 2;
+
+    viewport.zoom = std::clamp(viewport.zoom + steps, -pyramidLevels(), MAX_MAGNIFICATION);
+    viewport.originX = centreX - spanCells(viewWidth(), viewport.zoom) / 2;
+    viewport.originY = centreY - spanCells(viewHeight(), viewport.zoom) / 2;
+    clampViewport();
+}
@@ -0,0 +1,114 @@
+#ifndef FINAL_PROJECT_VIEWPORT_H
+#define FINAL_PROJECT_VIEWPORT_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Configs.h"
+
+// The part of the grid shown in the window (or exported), so only the window's
+// pixels are coloured and read back whatever the grid size. Zoomed in, every
+// cell covers 2^zoom x 2^zoom pixels. Zoomed out, every pixel is one texel of
+// level -zoom of a mip pyramid built from the grid: level l + 1 halves level l
+// in both directions. A texel holds the live fraction of its block (0-255)
+// and the majority species of its live cells, weighted by that fraction, and
+// is drawn as the species colour blended with the dead colour by the fraction.
+// The device (see KernelSource.h) and the CPU engine build the same texels.
+
+constexpr int MAX_MAGNIFICATION = 5;    // Zoom in at most to 32 x 32 pixels per cell
+constexpr int DEFAULT_WINDOW_SIZE = 1024;   // Largest default window side, bigger grids are zoomed out
+constexpr unsigned char OUTSIDE_COLOUR[3] = {32, 32, 32};   // Window pixels beyond the grid's edges
+
+struct Viewport {
+    int originX = 0;    // Cell at the window's bottom-left pixel, may lie outside the grid
+    int originY = 0;
+    int zoom = 0;       // log2 pixels per cell, negative to show pyramid level -zoom
+};
+extern Viewport viewport;
+
+struct ViewTexel {
+    uint8_t species;    // 0 when nothing in the block is alive
+    uint8_t density;    // Live fraction of the block, 255 = all alive
+};
+static_assert(sizeof(ViewTexel) == 2, "ViewTexel must match the kernels' uchar2");
+
+// Window size in pixels, the grid's size unless VIEW_WIDTH/VIEW_HEIGHT are set
+int viewWidth();
+int viewHeight();
+
+// Pyramid levels needed to fit the whole grid in the window, the furthest viewport can zoom out
+int pyramidLevels();
+
+inline int viewLevel(const Viewport &view) {
+    return view.zoom < 0 ? -view.zoom : 0;
+}
+
+// Texels of level in each direction, level 0 is the grid
+inline int levelWidth(int level) {
+    return ((WIDTH - 1) >> level) + 1;
+}
+inline int levelHeight(int level) {
+    return ((HEIGHT - 1) >> level) + 1;
+}
+
+// First texel of level (1..pyramidLevels()) in the pyramid buffer, and the buffer's size
+size_t pyramidLevelOffset(int level);
+size_t pyramidSize();
+
+// Texels [x0, x1) x [y0, y1) of level that the viewport needs, clipped to the level
+struct LevelRect {
+    int x0, y0, x1, y1;
+};
+LevelRect viewLevelRect(const Viewport &view, int level);
+
+// Bottom-left texel of the window in level viewLevel(view) coordinates, may lie outside the level
+void viewOrigin(const Viewport &view, int &x, int &y);
+
+// Pick the window size for this run, then fit the grid in it. Fused frames are
+// coloured one pixel per cell by the update, so they always use the grid's size.
+void initialiseViewport();
+// Show the whole grid centred in the window
+void fitViewport();
+// Move by steps eighths of the window, keeping the grid in view
+void panViewport(int stepsX, int stepsY);
+// Zoom in (positive) or out by steps powers of two around the window's centre
+void zoomViewport(int steps);
+
+// Level 0 texel of a cell
+inline ViewTexel cellTexel(int species) {
+    if (species < 1 || species >= PALETTE_SIZE) return {0, 0};
+    return {static_cast<uint8_t>(species), 255};
+}
+
+// Texel of a 2 x 2 block, count children present (the rest are {0, 0}).
+// Matches reduceTexels in KernelSource.h.
+inline ViewTexel reduceTexels(const ViewTexel children[4], int count) {
+    unsigned int weight[PALETTE_SIZE] = {0};
+    unsigned int density = 0;
+    for (int i = 0; i < 4; i++) {
+        density += children[i].density;
+        weight[children[i].species] += children[i].density;
+    }
+
+    // Ties go to the lowest species
+    uint8_t species = 0;
+    unsigned int best = 0;
+    for (int candidate = 1; candidate < PALETTE_SIZE; candidate++) {
+        if (weight[candidate] > best) {
+            best = weight[candidate];
+            species = static_cast<uint8_t>(candidate);
+        }
+    }
+    return {species, static_cast<uint8_t>(density / count)};
+}
+
+// Species colour blended with the dead colour by the texel's density
+inline void texelColour(const unsigned char palette[PALETTE_SIZE][3], ViewTexel texel, unsigned char *pixel) {
+    for (int channel = 0; channel < 3; channel++) {
+        unsigned int live = palette[texel.species][channel];
+        unsigned int dead = palette[0][channel];
+        pixel[channel] = static_cast<unsigned char>((live * texel.density + dead * (255 - texel.density) + 127) / 255);
+    }
+}
+
+#endif
@@ -14,166 +14,144 @@
  **/
 
 #include <iostream>
+#include <vector>
+#include <chrono>
+#include <ctime>
+#include <limits>
+#include <algorithm>
+#include <memory>
+#include <cstring>
 #include <GLUT/glut.h>
 #include <OpenGL/OpenGL.h>
 #include <OpenCL/opencl.h>
 
 #include "Configs.h"
-#include "KernelSource.h"
+#include "CommandLine.h"
+#include "Engine.h"
+#include "CpuEngine.h"
+#include "OutOfCore.h"
+#include "Ensemble.h"
+#include "Checkpoint.h"
+#include "CycleDetector.h"
+#include "FrameExporter.h"
+#include "Viewport.h"
+#include "Trace.h"
 
 // ----------- OPENCL ----------- //
-cl_device_id device_id;
-cl_context context;
-cl_command_queue gpu_commands;
-cl_command_queue cpu_commands;
-cl_program gpu_program;
-cl_program cpu_program;
-cl_kernel grid_update_kernel;
-cl_kernel pixels_update_kernel;
-cl_mem grid_mem;
-cl_mem grid_cpu_mem;
-cl_mem next_grid_mem;
-cl_mem cpu_pixel_buffer_mem;
-
-void initialiseOpenCL();
-void cleanupOpenCL();
 void getTimingInfo(cl_event *profiling_events, double hostWaitTime);
 
 // ----------- GAME OF LIFE ----------- //
-std::vector<int> grid;          // Previous species IDs
-std::vector<int> nextGrid;      // Updated species IDs
+uint64_t generationCount = 0;   // Generations since the grid was seeded, carried over by checkpoints
+std::unique_ptr<CheckpointWriter> checkpointWriter;
+uint64_t checkpointGeneration = UINT64_MAX;     // Generation of the last submitted checkpoint
+std::unique_ptr<FrameExporter> frameExporter;
 
 int getDesiredNumberOfSpecies();
-void initialiseGrid();
+uint playGameOfLifeCpu();
 uint playGameOfLife();
+void advanceGenerations(int count);
+void writeTrace();
+void exportFrame();
+void exportPixels(const unsigned char *framePixels, uint64_t generation);
+void stopWriters();
+void runHeadless();
+
+// ----------- PIPELINED FRAMES ----------- //
+struct PipelineSlot {
+    GLubyte *mapped = nullptr;      // Mapped PBO the pixels are read back into
+    cl_event read_event = NULL;     // Read-back into the mapping
+    uint64_t generation = 0;        // Generation shown by the frame
+};
+PipelineSlot pipelineSlots[MAX_PIPELINE_DEPTH];
+uint64_t framesIssued = 0;
+
+uint playGameOfLifePipelined();
+uint presentPipelineSlot(int slot);
+void drainPipeline();
 
 // ----------- OPENGL ----------- //
-GLuint pixelBuffer;
+GLuint pixelBuffers[MAX_PIPELINE_DEPTH];
+int displayedBuffer = 0;        // PBO drawn by displayFunc
 
 void initialiseOpenGL(int argc, char** argv);
 void displayFunc();             // Display callback
 void idleFunc();                // Idle callback
 void keyboardFunc(unsigned char key, int x, int y); // Keyboard callback
-
-// ----------- TEST VARIABLES ----------- //
-bool testModeEnabled = false;
-int iteration = 0;
-const int MAX_ITERATIONS = 100;
-double hostWaitTimeus[MAX_ITERATIONS];
-double kernelExecutionTimeus[MAX_ITERATIONS];
+void specialFunc(int key, int, int);                // Arrow key callback
 
 int main(int argc, char** argv) {
-    NUMBER_OF_SPECIES = getDesiredNumberOfSpecies();
-
-    // Register cleanup function
-    atexit(cleanupOpenCL);
-
-    // Initialisation
-    initialiseOpenGL(argc, argv);
-    initialiseOpenCL();
-    initialiseGrid();
-
-    glutMainLoop();
-
-    return 0;
-}
-
-void initialiseOpenCL() {
-    cl_int err[2];
-
-    // Connect to a compute device
-    int gpu = 1;
-    err[0] = clGetDeviceIDs(NULL, gpu ? CL_DEVICE_TYPE_GPU : CL_DEVICE_TYPE_CPU, 1, &device_id, NULL);
-    if (err[0] != CL_SUCCESS) {
-        printf("Error: Failed to create a device group!\n");
-        return;
+    if (!parseCommandLine(argc, argv)) {
+        return 1;
     }
 
-    // Create a compute context
-    context = clCreateContext(0, 1, &device_id, NULL, NULL, &err[0]);
-    if (!context) {
-        printf("Error: Failed to create a compute context!\n");
-        return;
+    // Restored runs take their dimensions, species and seed from the checkpoint
+    if (RESTORE_PATH != nullptr) {
+        if (!loadCheckpoint(RESTORE_PATH, grid, generationCount)) {
+            return 1;
+        }
+        std::cout << "Restored " << RESTORE_PATH << " at generation " << generationCount << "\n";
+        if (!ruleSupportedByOptions()) return 1;
     }
 
-    // Create "CPU" and GPU device command queues
-    gpu_commands = clCreateCommandQueue(context, device_id, CL_QUEUE_PROFILING_ENABLE, &err[0]);
-    cpu_commands = clCreateCommandQueue(context, device_id, CL_QUEUE_PROFILING_ENABLE, &err[1]);
-    if (!gpu_commands || !cpu_commands) {
-        printf("Error: Failed to create a command queue!\n");
-        return;
+    // Only prompt for the number of species when running interactively
+    if (!HEADLESS && !speciesGivenOnCommandLine()) {
+        NUMBER_OF_SPECIES = getDesiredNumberOfSpecies();
     }
 
-    // Create the compute programs from the source character arrays
-    gpu_program = clCreateProgramWithSource(context, 1, (const char **)&gpuKernelSource, NULL, &err[0]);
-    cpu_program = clCreateProgramWithSource(context, 1, (const char **)&cpuKernelSource, NULL, &err[1]);
-    if (!gpu_program || !cpu_program) {
-        printf("Error: Failed to create compute gpu_program!\n");
-        return;
+    // Out-of-core runs stream the grid from disk and manage their own device
+    if (STATE_FILE != nullptr) {
+        return runOutOfCore(STATE_FILE) ? 0 : 1;
     }
 
-    // Build the gpu_program and cpu_program executables
-    err[0] = clBuildProgram(gpu_program, 0, NULL, NULL, NULL, NULL);
-    err[1] = clBuildProgram(cpu_program, 0, NULL, NULL, NULL, NULL);
-    if (err[0] != CL_SUCCESS || err[1] != CL_SUCCESS) {
-        printf("Error: Failed to build program executable!\n");
-        return;
+    // So do ensembles, which step every instance in one launch
+    if (ENSEMBLE_SIZE > 0 || ENSEMBLE_PATH != nullptr) {
+        return runEnsemble() ? 0 : 1;
     }
 
-    // Create the GPU and "CPU" compute kernels
-    grid_update_kernel = clCreateKernel(gpu_program, "gameOfLife", &err[0]);
-    pixels_update_kernel = clCreateKernel(cpu_program, "writeToPixelBuffer", &err[1]);
-    if (!grid_update_kernel || err[0] != CL_SUCCESS || !pixels_update_kernel || err[1] != CL_SUCCESS) {
-        printf("Error: Failed to create compute kernel!\n");
-        return;
-    }
+    // Register cleanup function
+    atexit(cleanupEngine);
 
-    // Create GPU buffers
-    grid_mem = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(int) * WIDTH * HEIGHT, NULL, &err[0]);
-    next_grid_mem = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(int) * WIDTH * HEIGHT, NULL, &err[0]);
+    // Drain the checkpoint and export threads on exit(), and when main returns, while every global
+    // they read is still alive. Registered before drainPipeline, so presented frames are still exported.
+    atexit(stopWriters);
 
-    if (!grid_mem || !next_grid_mem) {
-        printf("Error: Failed to allocate device memory!\n");
-        return;
+    // Registered after cleanupEngine, so they run first while the queues and events are still valid
+    if (TRACE_PATH != nullptr) {
+        startTracing();
+        atexit(writeTrace);
+    }
+    if (!HEADLESS && PIPELINE_DEPTH > 1) {
+        atexit(drainPipeline);
     }
 
-    // Create "CPU" buffers
-    grid_cpu_mem = clCreateBuffer(context, CL_MEM_READ_WRITE, sizeof(int) * WIDTH * HEIGHT, NULL, &err[1]);
-    cpu_pixel_buffer_mem = clCreateBuffer(context, CL_MEM_WRITE_ONLY, sizeof(unsigned char) * WIDTH * HEIGHT * 3, NULL, &err[1]);
+    // Initialisation, headless runs never touch GLUT/OpenGL
+    initialiseViewport();
+    if (!HEADLESS) {
+        initialiseOpenGL(argc, argv);
+    }
+    initialiseEngine();
+    uint gridReady = RESTORE_PATH == nullptr ? initialiseGrid() : uploadGridToDevice();
+    if (!gridReady) return 1;
+    if (!startStats(generationCount)) return 1;
 
-    if (!grid_cpu_mem || !cpu_pixel_buffer_mem) {
-        printf("Error: Failed to allocate device memory!\n");
-        return;
+    if (CHECKPOINT_EVERY > 0) {
+        checkpointWriter = std::make_unique<CheckpointWriter>(CHECKPOINT_PATH);
+    }
+    if (EXPORT_PATH != nullptr) {
+        frameExporter = std::make_unique<FrameExporter>(EXPORT_PATH, EXPORT_FORMAT, viewWidth(), viewHeight());
+        if (!frameExporter->isOpen()) return 1;
     }
 
-    std::cout << "OpenCL initialized successfully!" << std::endl;
-}
+    tuneEngine();
 
-void cleanupOpenCL() {
-    std::cout << "Freeing memory allocated by OpenCL\n";
-
-    if (grid_mem) clReleaseMemObject(grid_mem);
-    if (next_grid_mem) clReleaseMemObject(next_grid_mem);
-    if (grid_cpu_mem) clReleaseMemObject(grid_cpu_mem);
-    if (cpu_pixel_buffer_mem) clReleaseMemObject(cpu_pixel_buffer_mem);
-    if (gpu_program) clReleaseProgram(gpu_program);
-    if (cpu_program) clReleaseProgram(cpu_program);
-    if (grid_update_kernel) clReleaseKernel(grid_update_kernel);
-    if (pixels_update_kernel) clReleaseKernel(pixels_update_kernel);
-    if (gpu_commands) clReleaseCommandQueue(gpu_commands);
-    if (cpu_commands) clReleaseCommandQueue(cpu_commands);
-    if (context) clReleaseContext(context);
-
-    // Get average computation times
-    if(testModeEnabled) {
-        double hostWaitTimeSum = 0, kernelExecTimeSum = 0;
-        for(int i = 0; i < MAX_ITERATIONS; i++) {
-            hostWaitTimeSum += hostWaitTimeus[i];
-            kernelExecTimeSum += kernelExecutionTimeus[i];
-        }
-        std::cout << "Average host wait time: " << hostWaitTimeSum / MAX_ITERATIONS << "us\n";
-        std::cout << "Average kernel execution time " << kernelExecTimeSum / MAX_ITERATIONS << "us\n";
+    if (HEADLESS) {
+        runHeadless();
+        return 0;
     }
+
+    glutMainLoop();
+
+    return 0;
 }
 
 int getDesiredNumberOfSpecies() {
@@ -194,47 +172,34 @@ int getDesiredNumberOfSpecies() {
     return numberOfSpecies;
 }
 
-void initialiseGrid() {
-    grid.resize(WIDTH * HEIGHT);
-    nextGrid.resize(WIDTH * HEIGHT);
-
-    std::srand(static_cast<unsigned int>(std::time(nullptr)));
-    for (int y = 0; y < HEIGHT; y++) {
-        for (int x = 0; x < WIDTH; x++) {
-            int cellIndex = y * WIDTH + x;
-            // Species ID ranges from 1 to NUMBER_OF_SPECIES
-            int speciesID = std::rand() % NUMBER_OF_SPECIES + 1;
-            grid[cellIndex]= speciesID;
-        }
-    }
-
-    nextGrid = grid;
-}
-
 void initialiseOpenGL(int argc, char** argv) {
     glutInit(&argc, argv);
     glutInitDisplayMode(GLUT_DOUBLE | GLUT_RGB);
-    glutInitWindowSize(WIDTH, HEIGHT);
+    glutInitWindowSize(viewWidth(), viewHeight());
     glutInitWindowPosition(100, 100);
     glutCreateWindow("Game of Life");
 
-    // Create Pixel Buffer Object (PBO)
-    glGenBuffers(1, &pixelBuffer); // Create 1 buffer object, store its ID in pixelBuffer
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer); // Bind buffer to its ID
-    glBufferData(GL_PIXEL_UNPACK_BUFFER,WIDTH * HEIGHT * 3, nullptr, GL_STREAM_DRAW); // Allocate (WIDTH * HEIGHT * 3) bytes to PBO
+    // Create Pixel Buffer Objects (PBOs), one per frame in flight
+    glGenBuffers(PIPELINE_DEPTH, pixelBuffers); // Create buffer objects, store their IDs in pixelBuffers
+    for (int slot = 0; slot < PIPELINE_DEPTH; slot++) {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[slot]); // Bind buffer to its ID
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, viewWidth() * viewHeight() * 3, nullptr, GL_STREAM_DRAW); // Allocate one RGB pixel per window pixel
+    }
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0); // Unbind PBO
 
     // Set callbacks
     glutDisplayFunc(displayFunc);
     glutKeyboardFunc(keyboardFunc);
+    glutSpecialFunc(specialFunc);
     glutIdleFunc(idleFunc);
 }
 
 void displayFunc() {
+    TraceScope scope("Draw");
     glClear(GL_COLOR_BUFFER_BIT);
 
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
-    glDrawPixels(WIDTH, HEIGHT, GL_RGB, GL_UNSIGNED_BYTE, 0);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[displayedBuffer]);
+    glDrawPixels(viewWidth(), viewHeight(), GL_RGB, GL_UNSIGNED_BYTE, 0);
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
     glutSwapBuffers();
@@ -252,11 +217,17 @@ void idleFunc() {
         exit(0);
     }
 
-    if(testModeEnabled) {
-        iteration++;
-        if(iteration >= MAX_ITERATIONS) {
-            exit(0);
-        }
+    // Pipelined frames are exported when they are presented
+    advanceGenerations(GENERATIONS_PER_FRAME);
+    if (ENGINE != ENGINE_OPENCL || PIPELINE_DEPTH == 1) {
+        exportFrame();
+    }
+
+    // Stop after the requested number of generations (0 = run until closed)
+    static int generation = 0;
+    generation += GENERATIONS_PER_FRAME;
+    if(GENERATIONS > 0 && generation >= GENERATIONS) {
+        exit(0);
     }
 }
 
@@ -265,69 +236,230 @@ void keyboardFunc(unsigned char key, int x, int y) {
     if (key == 27 || key == 'q') {
         exit(0);
     }
+
+    // Dump the timeline so far
+    if (key == 't') {
+        writeTrace();
+    }
+
+    // Pan with w/a/s/d, zoom with +/- and fit the whole grid with 0. Fused frames always show the whole grid.
+    if (FUSED_PIXELS) return;
+    switch (key) {
+        case 'w': panViewport(0, 1); break;
+        case 's': panViewport(0, -1); break;
+        case 'a': panViewport(-1, 0); break;
+        case 'd': panViewport(1, 0); break;
+        case '+': case '=': zoomViewport(1); break;
+        case '-': zoomViewport(-1); break;
+        case '0': fitViewport(); break;
+        default: break;
+    }
 }
 
+void specialFunc(int key, int, int) {
+    // Arrow keys pan like w/a/s/d, rows are drawn bottom-up so up moves towards higher rows
+    if (FUSED_PIXELS) return;
+    switch (key) {
+        case GLUT_KEY_UP: panViewport(0, 1); break;
+        case GLUT_KEY_DOWN: panViewport(0, -1); break;
+        case GLUT_KEY_LEFT: panViewport(-1, 0); break;
+        case GLUT_KEY_RIGHT: panViewport(1, 0); break;
+        default: break;
+    }
+}
 
-uint playGameOfLife() {
-    cl_int err;
-    cl_event profiling_events[2];
+void writeTrace() {
+    if (TRACE_PATH != nullptr) writeChromeTrace(TRACE_PATH);
+}
 
-    // ----------------- Swap host buffers -----------------
-    std::swap(nextGrid, grid);
+// Tight generation loop with no window, display pacing or per-frame logging
+void runHeadless() {
+    std::cout << "Running " << GENERATIONS << " generations of a " << WIDTH << "x" << HEIGHT
+              << " grid with " << NUMBER_OF_SPECIES << " species (seed " << SEED << ")\n";
+
+    // The initial grid is fingerprinted too, so a grid that never changes is found after one generation
+    std::unique_ptr<CycleDetector> cycleDetector;
+    std::vector<uint64_t> fingerprints(GENERATIONS_PER_FRAME);
+    if (CYCLE_WINDOW > 0) {
+        cycleDetector = std::make_unique<CycleDetector>(CYCLE_WINDOW);
+        if (!gridFingerprint(fingerprints[0])) return;
+        cycleDetector->record(generationCount, fingerprints[0]);
+    }
 
-    // ----------------- Write grid N to GPU buffer -----------------
-    err = clEnqueueWriteBuffer(gpu_commands, grid_mem, CL_TRUE, 0,
-                               sizeof(int) * WIDTH * HEIGHT,
-                               grid.data(), 0, NULL, NULL);
-    if (err != CL_SUCCESS) {
-        printf("Error: Failed to write grid to GPU memory!\n");
-        return 0;
+    int generationsRun = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (generationsRun < GENERATIONS && !(cycleDetector && cycleDetector->detected())) {
+        // Generations stay on the device, the host only waits once per batch.
+        // Exported OpenCL batches are coloured on the device along with their last generation.
+        int batch = std::min(GENERATIONS_PER_FRAME, GENERATIONS - generationsRun);
+        bool colour = frameExporter && ENGINE == ENGINE_OPENCL;
+        uint ok;
+        if (cycleDetector) ok = stepGenerationsFingerprinted(batch, fingerprints.data(), colour);
+        else ok = colour ? stepFrame(batch) : stepGenerations(batch);
+        if (ok == 0) {
+            std::cout << "Something went wrong with the OpenCL setup and execution, exiting program\n";
+            return;
+        }
+        for (int i = 0; cycleDetector && i < batch && !cycleDetector->detected(); i++) {
+            cycleDetector->record(generationCount + i + 1, fingerprints[i]);
+        }
+        advanceGenerations(batch);
+        generationsRun += batch;
+
+        traceResolveDeviceEvents();
+
+        // Export the batch's last generation, the writer thread does the rest
+        if (frameExporter && (colour || readGridToHost())) {
+            exportFrame();
+        }
+    }
+
+    // The grid repeats every period generations from here on, so only the remainder needs running
+    int skipped = 0;
+    if (cycleDetector && cycleDetector->detected() && CYCLE_ACTION == CYCLE_JUMP && generationsRun < GENERATIONS) {
+        int remaining = GENERATIONS - generationsRun;
+        int remainder = static_cast<int>(remaining % cycleDetector->period());
+        setStatsGeneration(generationCount + remaining - remainder);
+        if (remainder > 0 && stepGenerations(remainder) == 0) {
+            std::cout << "Something went wrong with the OpenCL setup and execution, exiting program\n";
+            return;
+        }
+        advanceGenerations(remaining);
+        generationsRun += remainder;
+        skipped = remaining - remainder;
     }
+    auto end = std::chrono::steady_clock::now();
 
-    // ----------------- Execute GPU kernel -----------------
-    size_t global[2] = {WIDTH, HEIGHT};
+    double seconds = std::chrono::duration<double>(end - start).count();
+    double cellUpdates = static_cast<double>(WIDTH) * HEIGHT * generationsRun;
 
-    clSetKernelArg(grid_update_kernel, 0, sizeof(cl_mem), &grid_mem);
-    clSetKernelArg(grid_update_kernel, 1, sizeof(cl_mem), &next_grid_mem);
-    clSetKernelArg(grid_update_kernel, 2, sizeof(int), &WIDTH);
-    clSetKernelArg(grid_update_kernel, 3, sizeof(int), &HEIGHT);
-    clSetKernelArg(grid_update_kernel, 4, sizeof(int), &NUMBER_OF_SPECIES);
+    std::cout << "Headless Run Info:\n";
+    std::cout << "\tTotal runtime:\t\t\t" << seconds << "s\n";
+    std::cout << "\tGenerations/second:\t\t" << generationsRun / seconds << "\n";
+    std::cout << "\tCells/second:\t\t\t" << cellUpdates / seconds << "\n";
 
-    // Start host side timer
-    auto start = std::chrono::system_clock::now();
-    err = clEnqueueNDRangeKernel(gpu_commands, grid_update_kernel,
-                                 2, NULL, global, NULL, 0, NULL, &profiling_events[0]);
-    if (err != CL_SUCCESS) {
-        printf("Error: Failed to launch compute kernel!\n");
-        return 0;
+    if (cycleDetector && cycleDetector->extinct()) {
+        std::cout << "\tDied out at generation:\t\t" << cycleDetector->transient() << "\n";
+    }
+    else if (cycleDetector && cycleDetector->detected()) {
+        std::cout << "\tCycle:\t\t\t\tperiod " << cycleDetector->period() << " from generation "
+                  << cycleDetector->transient() << "\n";
+    }
+    if (cycleDetector && cycleDetector->detected()) {
+        std::cout << "\tFinal generation:\t\t" << generationCount;
+        if (skipped > 0) std::cout << " (" << skipped << " generations skipped)";
+        std::cout << "\n";
     }
 
-    // ----------------- Write grid N to "CPU" buffer -----------------
-    err = clEnqueueWriteBuffer(cpu_commands, grid_cpu_mem, CL_TRUE, 0,
-                               sizeof(int) * WIDTH * HEIGHT,
-                               grid.data(), 0, NULL, NULL);
-    if (err != CL_SUCCESS) {
-        printf("Error: Failed to write CPU-grid buffer!\n");
-        return 0;
+    // Only read the grid back once, at the end of the run
+    if (readGridToHost()) {
+        long population = std::count_if(grid.begin(), grid.end(), [](cell_t species) { return species != -1; });
+        std::cout << "\tFinal population:\t\t" << population << "\n";
+
+        // Always leave a checkpoint of the final grid, unless the last batch already submitted it
+        if (checkpointWriter && checkpointGeneration != generationCount) {
+            checkpointWriter->submit(grid, generationCount);
+        }
     }
+}
 
-    // ----------------- Execute "CPU" kernel -----------------
-    clSetKernelArg(pixels_update_kernel, 0, sizeof(cl_mem), &grid_cpu_mem);
-    clSetKernelArg(pixels_update_kernel, 1, sizeof(cl_mem), &cpu_pixel_buffer_mem);
-    clSetKernelArg(pixels_update_kernel, 2, sizeof(int), &WIDTH);
-    clSetKernelArg(pixels_update_kernel, 3, sizeof(int), &HEIGHT);
 
-    err = clEnqueueNDRangeKernel(cpu_commands, pixels_update_kernel,
-                                 2, NULL, global, NULL,
-                                 0, NULL, &profiling_events[1]);
-    if (err != CL_SUCCESS) {
-        printf("Error: Failed to launch pixel kernel!\n");
+// Write out everything still queued, then stop the writer threads
+void stopWriters() {
+    checkpointWriter.reset();
+    frameExporter.reset();
+}
+
+// Count finished generations and hand the grid to the checkpoint writer when a checkpoint is due
+void advanceGenerations(int count) {
+    uint64_t previous = generationCount;
+    generationCount += count;
+
+    if (checkpointWriter && previous / CHECKPOINT_EVERY != generationCount / CHECKPOINT_EVERY && readGridToHost()) {
+        checkpointWriter->submit(grid, generationCount);
+        checkpointGeneration = generationCount;
+    }
+}
+
+// Queue a frame that is already coloured on the host
+void exportPixels(const unsigned char *framePixels, uint64_t generation) {
+    if (!frameExporter) return;
+    TraceScope scope("Export frame");
+
+    unsigned char *pixels = frameExporter->acquireFrame();
+    if (pixels == nullptr) return;
+    std::memcpy(pixels, framePixels, sizeof(unsigned char) * viewWidth() * viewHeight() * 3);
+    frameExporter->submitFrame(generation);
+}
+
+// Hand the colours of the current frame to the exporter, dropping the frame if its writer is behind.
+// The OpenCL pixel buffer, or the host grid for the other engines, must already hold the frame.
+void exportFrame() {
+    if (!frameExporter) return;
+    TraceScope scope("Export frame");
+
+    unsigned char *pixels = frameExporter->acquireFrame();
+    if (pixels == nullptr) return;
+
+    if (ENGINE == ENGINE_OPENCL) {
+        cl_int err = clEnqueueReadBuffer(cpu_commands, cpu_pixel_buffer_mem[0], CL_TRUE, 0,
+                                         sizeof(unsigned char) * viewWidth() * viewHeight() * 3, pixels, 0, NULL, NULL);
+        if (err != CL_SUCCESS) {
+            printf("Error: Failed to read back pixels for export!\n");
+            return;
+        }
+    }
+    else {
+        cpuWritePixels(grid, pixels);
+    }
+    frameExporter->submitFrame(generationCount);
+}
+
+uint playGameOfLifeCpu() {
+    TraceScope frameScope("Frame");
+
+    // Host-coloured frames, the multi-device engine has to gather its bands first
+    if (!stepGenerations(GENERATIONS_PER_FRAME) || !readGridToHost()) return 0;
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[0]);
+    uint64_t mapStart = traceNow();
+    GLubyte* pboPtr = (GLubyte*)glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+    traceHostSpan("glMapBuffer", mapStart, traceNow());
+    if(pboPtr) {
+        {
+            TraceScope scope("Colour pixels");
+            cpuWritePixels(grid, pboPtr);
+        }
+        TraceScope scope("glUnmapBuffer");
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    return 1;
+}
+
+uint playGameOfLife() {
+    if (ENGINE != ENGINE_OPENCL) return playGameOfLifeCpu();
+    if (PIPELINE_DEPTH > 1) return playGameOfLifePipelined();
+
+    TraceScope frameScope("Frame");
+    cl_event profiling_events[3];   // First and last grid update, pixel update
+
+    // Start host side timer
+    auto start = std::chrono::system_clock::now();
+
+    // ----------------- Execute GPU kernel GENERATIONS_PER_FRAME times and colour grid N+K -----------------
+    if (!enqueueFrame(GENERATIONS_PER_FRAME, &profiling_events[0], &profiling_events[1], &profiling_events[2], 0)) {
         return 0;
     }
+    traceDeviceSpan("Generations", TRACK_GPU_QUEUE, profiling_events[0], profiling_events[1]);
 
     // ----------------- Wait for GPU and "CPU" devices to service their commands -----------------
-    clFinish(gpu_commands);
-    clFinish(cpu_commands);
+    {
+        TraceScope scope("Wait for queues");
+        clFinish(gpu_commands);
+        clFinish(cpu_commands);
+    }
 
     // Stop host-side timer
     auto end = std::chrono::system_clock::now();
@@ -336,40 +468,139 @@ uint playGameOfLife() {
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
 
     // ----------------- Get kernel runtimes -----------------
-    clWaitForEvents(2, profiling_events);
-    getTimingInfo(profiling_events, duration.count());
-
-    // ----------------- Read grid N+1 -----------------
-    err = clEnqueueReadBuffer(gpu_commands, next_grid_mem, CL_TRUE, 0,
-                              sizeof(int) * WIDTH * HEIGHT,
-                              nextGrid.data(), 0, NULL, NULL);
-    if (err != CL_SUCCESS) {
-        printf("Error: Failed to read back updated grid!\n");
-        return 0;
+    // Printing every frame costs real time in the loop, the trace is the cheap way to see it
+    if (PRINT_TIMING) {
+        clWaitForEvents(3, profiling_events);
+        getTimingInfo(profiling_events, duration.count());
     }
+    for (cl_event event : profiling_events) clReleaseEvent(event);
 
-    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+    // ----------------- Read pixels for frame N+K -----------------
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[0]);
     // Map PBO data to the host's address space
+    uint64_t mapStart = traceNow();
     GLubyte* pboPtr = (GLubyte*)glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+    traceHostSpan("glMapBuffer", mapStart, traceNow());
     if(pboPtr) {
         // Read pixels from cpu device memory into PBO pointer in host memory
-        clEnqueueReadBuffer(cpu_commands, cpu_pixel_buffer_mem, CL_TRUE, 0, sizeof(unsigned char) * WIDTH * HEIGHT * 3, pboPtr, 0, NULL, NULL);
+        cl_event read_event;
+        {
+            TraceScope scope("Read pixels");
+            clEnqueueReadBuffer(cpu_commands, cpu_pixel_buffer_mem[0], CL_TRUE, 0, sizeof(unsigned char) * viewWidth() * viewHeight() * 3, pboPtr, 0, NULL, &read_event);
+        }
+        traceDeviceEvent("Read pixels", TRACK_PIXEL_QUEUE, read_event);
+        clReleaseEvent(read_event);
+        traceResolveDeviceEvents();
+
+        TraceScope scope("glUnmapBuffer");
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+    return 1;
+}
+
+// Issue frame N and present frame N - (PIPELINE_DEPTH - 1). Nothing waits on the host except the
+// oldest frame's read-back, so frame N's generations run while earlier frames are coloured and drawn.
+uint playGameOfLifePipelined() {
+    TraceScope frameScope("Frame");
+    int slot = static_cast<int>(framesIssued % PIPELINE_DEPTH);
+    PipelineSlot &issue = pipelineSlots[slot];
+
+    // ----------------- Execute GPU kernel GENERATIONS_PER_FRAME times and colour into this slot -----------------
+    // In-order queues chain the generations behind the previous frame's grid copy
+    cl_event first_event, last_event, pixel_event;
+    if (!enqueueFrame(GENERATIONS_PER_FRAME, &first_event, &last_event, &pixel_event, slot)) {
+        return 0;
+    }
+    traceDeviceSpan("Generations", TRACK_GPU_QUEUE, first_event, last_event);
+    clReleaseEvent(first_event);
+    clReleaseEvent(last_event);
+
+    // ----------------- Read pixels into this slot's PBO once they are coloured -----------------
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[slot]);
+    {
+        // The exporter copies presented frames out of the mapping, so it must be readable
+        TraceScope scope("glMapBuffer");
+        issue.mapped = (GLubyte*)glMapBuffer(GL_PIXEL_UNPACK_BUFFER, frameExporter ? GL_READ_WRITE : GL_WRITE_ONLY);
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    if (!issue.mapped) {
+        clReleaseEvent(pixel_event);
+        printf("Error: Failed to map pixel buffer!\n");
+        return 0;
+    }
+
+    cl_int err = clEnqueueReadBuffer(cpu_commands, cpu_pixel_buffer_mem[slot], CL_FALSE, 0,
+                                     sizeof(unsigned char) * viewWidth() * viewHeight() * 3, issue.mapped,
+                                     1, &pixel_event, &issue.read_event);
+    clReleaseEvent(pixel_event);
+    if (err != CL_SUCCESS) {
+        printf("Error: Failed to read back pixels!\n");
+        return 0;
+    }
+    traceDeviceEvent("Read pixels", TRACK_PIXEL_QUEUE, issue.read_event);
+    issue.generation = generationCount + GENERATIONS_PER_FRAME;
+    clFlush(gpu_commands);
+    clFlush(cpu_commands);
+    framesIssued++;
+
+    // ----------------- Present the oldest frame in flight -----------------
+    if (framesIssued < static_cast<uint64_t>(PIPELINE_DEPTH)) return 1;
+    return presentPipelineSlot(static_cast<int>(framesIssued % PIPELINE_DEPTH));
+}
+
+// Wait for a slot's read-back, unmap its PBO and make it the one displayFunc draws
+uint presentPipelineSlot(int slot) {
+    PipelineSlot &present = pipelineSlots[slot];
+    if (present.read_event == NULL) return 1;
+
+    cl_int err;
+    {
+        TraceScope scope("Wait for frame");
+        err = clWaitForEvents(1, &present.read_event);
+    }
+    clReleaseEvent(present.read_event);
+    present.read_event = NULL;
+    traceResolveDeviceEvents();
+
+    if (err == CL_SUCCESS) {
+        exportPixels(present.mapped, present.generation);
+    }
+
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffers[slot]);
+    {
+        TraceScope scope("glUnmapBuffer");
         glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
     }
     glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    present.mapped = nullptr;
 
+    if (err != CL_SUCCESS) {
+        printf("Error: Failed to read back pixels!\n");
+        return 0;
+    }
+    displayedBuffer = slot;
     return 1;
 }
 
+// Finish every frame still in flight, so no read-back targets an unmapped PBO
+void drainPipeline() {
+    for (int frame = 0; frame < PIPELINE_DEPTH; frame++) {
+        presentPipelineSlot(static_cast<int>((framesIssued + frame) % PIPELINE_DEPTH));
+    }
+}
+
 void getTimingInfo(cl_event *profiling_events, double hostWaitTime) {
     cl_ulong gpu_kernel_start, gpu_kernel_end, cpu_kernel_start, cpu_kernel_end;
     size_t return_bytes;
     cl_uint err;
 
+    // GPU runtime spans from the start of the first to the end of the last generation of the frame
     err = clGetEventProfilingInfo(profiling_events[0], CL_PROFILING_COMMAND_START, sizeof(cl_long), &gpu_kernel_start, &return_bytes);
-    err |= clGetEventProfilingInfo(profiling_events[0], CL_PROFILING_COMMAND_END, sizeof(cl_long), &gpu_kernel_end, &return_bytes);
-    err |= clGetEventProfilingInfo(profiling_events[1], CL_PROFILING_COMMAND_START, sizeof(cl_long), &cpu_kernel_start, &return_bytes);
-    err |= clGetEventProfilingInfo(profiling_events[1], CL_PROFILING_COMMAND_END, sizeof(cl_long), &cpu_kernel_end, &return_bytes);
+    err |= clGetEventProfilingInfo(profiling_events[1], CL_PROFILING_COMMAND_END, sizeof(cl_long), &gpu_kernel_end, &return_bytes);
+    err |= clGetEventProfilingInfo(profiling_events[2], CL_PROFILING_COMMAND_START, sizeof(cl_long), &cpu_kernel_start, &return_bytes);
+    err |= clGetEventProfilingInfo(profiling_events[2], CL_PROFILING_COMMAND_END, sizeof(cl_long), &cpu_kernel_end, &return_bytes);
     if(err != CL_SUCCESS) {
         std::cout << "Error: Could not get event profiling info!\n";
     }
@@ -379,11 +610,6 @@ void getTimingInfo(cl_event *profiling_events, double hostWaitTime) {
     cpuKernelRuntime = (double)(cpu_kernel_end - cpu_kernel_start) / 1000.0;
     totalRuntime = gpuKernelRuntime + cpuKernelRuntime;
 
-    if(testModeEnabled) {
-        hostWaitTimeus[iteration] = hostWaitTime;
-        kernelExecutionTimeus[iteration] = totalRuntime;
-    }
-
     std::cout << "Kernel Runtime Info:\n";
     std::cout << "\tGPU next grid computation:\t\t\t" << gpuKernelRuntime << "us\n";
     std::cout << "\tCPU pixels:\t\t\t\t\t\t\t" << cpuKernelRuntime << "us\n";